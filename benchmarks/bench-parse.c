@@ -0,0 +1,257 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+/* Throughput of the parser in MB/s for a generated configuration file.
+
+   Usage: bench-parse [size in MiB] [runs]
+
+   Compared are
+   - getline: reading the file line by line with getline() and splitting
+     every line with strchr() for each comment and delimiter character,
+     like libeconf did before version 0.9
+   - the scanning kernels which find the structural characters
+   - econf_readFile()  */
+
+#include "libeconf.h"
+#include "scan.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DELIM "="
+#define COMMENT "#"
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Minimum of best and the time since start */
+static double
+elapsed(double start, double best)
+{
+  double t = now() - start;
+  return t < best ? t : best;
+}
+
+static size_t
+generate(FILE *f, size_t size)
+{
+  size_t written = 0;
+  int n;
+
+  for (unsigned int group = 0; written < size; group++) {
+    if ((n = fprintf(f, "\n# settings of group %u\n[group%u]\n", group, group)) < 0)
+      return 0;
+    written += n;
+    for (unsigned int key = 0; key < 100; key++) {
+      switch (key % 4) {
+      case 0:
+	n = fprintf(f, "key%u = value%u\n", key, key * group);
+	break;
+      case 1:
+	n = fprintf(f, "  # %u is documented here\nlong_key_name_%u = a somewhat longer value with spaces %u\n",
+		    key, key, group);
+	break;
+      case 2:
+	n = fprintf(f, "quoted%u = \"quoted # value %u\" # comment\n", key, group);
+	break;
+      default:
+	n = fprintf(f, "path%u=/usr/lib/econf/%u/%u.conf\n", key, group, key);
+	break;
+      }
+      if (n < 0)
+	return 0;
+      written += n;
+    }
+  }
+  return written;
+}
+
+/* Line based parser as reference */
+static size_t
+parse_getline(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char *line = NULL;
+  size_t n = 0, entries = 0;
+  ssize_t len;
+
+  if (f == NULL)
+    return 0;
+  while ((len = getline(&line, &n, f)) != -1) {
+    char *name = line, *p;
+    if (len && line[len - 1] == '\n')
+      line[len - 1] = '\0';
+    while (isspace((unsigned char) *name))
+      name++;
+    for (size_t i = 0; i < strlen(COMMENT); i++) {
+      if ((p = strchr(name, COMMENT[i])) == NULL)
+	continue;
+      char *first_quote = strchr(name, '"'), *last_quote = strrchr(name, '"');
+      if (first_quote == NULL || last_quote < p)
+	*p = '\0';
+    }
+    if (!*name || *name == '[')
+      continue;
+    p = name;
+    while (*p && !isspace((unsigned char) *p) && strchr(DELIM, *p) == NULL)
+      p++;
+    char *key = strndup(name, p - name);
+    while (*p && (isspace((unsigned char) *p) || strchr(DELIM, *p) != NULL))
+      p++;
+    char *value = strdup(p);
+    entries += key && value;
+    free(key);
+    free(value);
+  }
+  free(line);
+  fclose(f);
+  return entries;
+}
+
+static size_t
+parse_econf(const char *path)
+{
+  econf_file *key_file = NULL;
+  size_t entries = 0;
+  char **groups;
+
+  if (econf_readFile(&key_file, path, DELIM, COMMENT))
+    return 0;
+  if (econf_getGroups(key_file, &entries, &groups) == ECONF_SUCCESS)
+    econf_freeArray(groups);
+  econf_free(key_file);
+  return entries;
+}
+
+static char *
+load(const char *path, size_t *length)
+{
+  FILE *f = fopen(path, "r");
+  char *buf;
+
+  if (f == NULL)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  *length = ftell(f);
+  rewind(f);
+  buf = malloc(*length + 1);
+  if (buf && fread(buf, 1, *length, f) != *length) {
+    free(buf);
+    buf = NULL;
+  }
+  fclose(f);
+  return buf;
+}
+
+static void
+report(const char *name, size_t size, double seconds)
+{
+  printf("%-12s %8.1f MB/s\n", name, size / seconds / 1e6);
+}
+
+int
+main(int argc, char *argv[])
+{
+  size_t size = (argc > 1 ? strtoul(argv[1], NULL, 10) : 16) << 20;
+  int runs = argc > 2 ? atoi(argv[2]) : 5;
+  char path[] = "/tmp/bench-parse-XXXXXX";
+  unsigned char cc[256] = { 0 };
+  static const struct {
+    const char *name;
+    void (*kernel)(const econf_scanner *, const char *, size_t, uint64_t *);
+  } kernels[] = {
+    { "scalar", scan_scalar },
+    { "sse2", scan_sse2 },
+    { "avx2", scan_avx2 },
+  };
+  econf_scanner scanner;
+  double best, start;
+  uint64_t *bits;
+  size_t length = 0;
+  char *buf;
+  int fd, ret = 1;
+  FILE *f;
+
+  if ((fd = mkstemp(path)) < 0 || (f = fdopen(fd, "w")) == NULL) {
+    perror("bench-parse");
+    return 1;
+  }
+  size = generate(f, size);
+  fclose(f);
+  printf("%zu bytes, best of %d runs\n", size, runs);
+
+  best = 1e9;
+  for (int i = 0; i < runs; i++) {
+    start = now();
+    if (!parse_getline(path)) {
+      fprintf(stderr, "getline parser failed\n");
+      goto out;
+    }
+    best = elapsed(start, best);
+  }
+  report("getline", size, best);
+
+  /* the classes of the structural characters, see read_file() */
+  for (int c = 0; c < 256; c++)
+    cc[c] = isspace(c) || c == '"' || c == '\0' || strchr(DELIM COMMENT, c) != NULL;
+  scan_init(&scanner, cc);
+  buf = load(path, &length);
+  bits = malloc((length / 64 + 1) * sizeof(uint64_t));
+  for (size_t k = 0; buf && bits && k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+    best = 1e9;
+    for (int i = 0; i < runs; i++) {
+      start = now();
+      kernels[k].kernel(&scanner, buf, length, bits);
+      best = elapsed(start, best);
+    }
+    report(kernels[k].name, size, best);
+  }
+  free(bits);
+  free(buf);
+
+  best = 1e9;
+  for (int i = 0; i < runs; i++) {
+    start = now();
+    if (!parse_econf(path)) {
+      fprintf(stderr, "econf_readFile failed\n");
+      goto out;
+    }
+    best = elapsed(start, best);
+  }
+  report("econf", size, best);
+  ret = 0;
+
+ out:
+  unlink(path);
+  return ret;
+}
@@ -20,6 +20,7 @@ $libc |head -1
 $CC --version |head -1
 meson --version |head -1
 ninja --version |head -1
+printf 'liburing %s\n' "$(pkg-config --modversion liburing)"
 kver="$(printf '%s\n%s\n' '#include <linux/version.h>' 'LINUX_VERSION_CODE' | $CC -E -P -)"
 printf 'kernel-headers %s.%s.%s\n' $((kver/65536)) $((kver/256%256)) $((kver%256))
 echo 'END OF BUILD ENVIRONMENT INFORMATION'
@@ -9,6 +9,8 @@ j=-j`nproc` || j=
 type sudo >/dev/null 2>&1 && sudo=sudo || sudo=
 packages="
 meson
+pkg-config
+liburing-dev
 valgrind
 $CC"
 
@@ -118,15 +118,19 @@ typedef enum econf_err econf_err;
  *  Use: econf_free(_generic_ value);
  *
  *  Replace _generic_ with one of the supported value types.
- *  Supported Types: char** and econf_file*.
+ *  Supported Types: char**, econf_file*, econf_handle* and econf_ctx*.
  */
 #define econf_free(value) (( \
   _Generic((value), \
     econf_file*: econf_freeFile , \
+    econf_handle*: econf_freeHandle , \
+    econf_ctx*: econf_freeCtx , \
     char**: econf_freeArray)) \
 (value))
 
 typedef struct econf_file econf_file;
+typedef struct econf_handle econf_handle;
+typedef struct econf_ctx econf_ctx;
 
 /** @brief Process the file of the given file_name and save its contents into key_file object.
  *
@@ -155,6 +159,103 @@ typedef struct econf_file econf_file;
 extern econf_err econf_readFile(econf_file **result, const char *file_name,
 				const char *delim, const char *comment);
 
+/** @brief Process length bytes of data and save its contents into key_file object.
+ *         The data is parsed like the contents of a file (see econf_readFile),
+ *         so configurations received e.g. via IPC do not have to be written
+ *         into a file first.
+ *
+ * @param result content of parsed data.
+ * @param data configuration text, it does not have to be null terminated.
+ * @param length number of bytes of data
+ * @param delim delimiters of key/value e.g. "\t =".
+ *        If delim contains space characters AND none space characters,
+ *        multiline values are not parseable.
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_file *key_file = NULL;
+ *   const char data[] = "[main]\nkey = value\n";
+ *   econf_err error;
+ *
+ *   error = econf_readBuffer (&key_file, data, sizeof(data) - 1, "=", "#");
+ *
+ *   econf_free (key_file);
+ *   key_file = NULL;
+ * @endcode
+ *
+ */
+extern econf_err econf_readBuffer(econf_file **result, const char *data, size_t length,
+				  const char *delim, const char *comment);
+
+/** @brief Read the file descriptor fd until end of file and save its contents
+ *         into key_file object. fd can be e.g. a pipe or a socket. It is not closed.
+ *
+ * @param result content of parsed data.
+ * @param fd file descriptor opened for reading
+ * @param delim delimiters of key/value e.g. "\t =".
+ *        If delim contains space characters AND none space characters,
+ *        multiline values are not parseable.
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_file *key_file = NULL;
+ *   econf_err error;
+ *
+ *   error = econf_readFd (&key_file, STDIN_FILENO, "=", "#");
+ *
+ *   econf_free (key_file);
+ *   key_file = NULL;
+ * @endcode
+ *
+ */
+extern econf_err econf_readFd(econf_file **result, int fd,
+			      const char *delim, const char *comment);
+
+/** @brief Load a snapshot which has been written by econf_compileConfig
+ *         into a key_file object. No config file is parsed, groups, keys,
+ *         values, comments and line numbers are the same as in the
+ *         compiled object. econf_getPath returns file_name.
+ *         The security settings (e.g. econf_requireOwner) apply to the
+ *         snapshot file.
+ *         The snapshot is mapped read-only, so all processes which open
+ *         it share the same memory. The econf_get* functions read the
+ *         mapping directly. The entries are copied into the key_file
+ *         object when it is changed (e.g. by econf_set*Value).
+ *         A snapshot must only be replaced by econf_compileConfig (or by
+ *         renaming another file), never be changed in place.
+ *
+ * @param result content of the snapshot
+ * @param file_name path of the snapshot
+ * @return econf_err ECONF_SUCCESS or error code.
+ *         ECONF_PARSE_ERROR if file_name is no valid snapshot or has been
+ *         written by an incompatible libeconf version or another machine.
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_file *key_file = NULL;
+ *   econf_err error;
+ *
+ *   error = econf_openSnapshot (&key_file, "/run/foo/bar.snapshot");
+ *   if (error)
+ *     error = econf_readConfig (&key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+ *
+ *   econf_free (key_file);
+ *   key_file = NULL;
+ * @endcode
+ *
+ */
+extern econf_err econf_openSnapshot(econf_file **result, const char *file_name);
+
 
 /** @brief Process the file of the given file_name and save its contents into key_file object.
  *  The user defined function will be called in order e.g. to check the correct file permissions.
@@ -231,6 +332,35 @@ extern econf_err econf_readFileWithCallback(econf_file **result, const char *fil
 extern econf_err econf_mergeFiles(econf_file **merged_file,
 				  econf_file *usr_file, econf_file *etc_file);
 
+/** @brief Same as econf_mergeFiles, but usr_file and etc_file are consumed.
+ *         Their strings are moved into merged_file instead of being copied.
+ *         usr_file and etc_file are freed, also in case of an error, and must
+ *         not be used afterwards.
+ *
+ * @param merged_file merged data
+ * @param usr_file First data block which has to be merged.
+ * @param etc_file Second data block which has to be merged.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_file *key_file_1 = NULL, *key_file_2 = NULL, *key_file_ret = NULL
+ *   econf_err error;
+ *
+ *   error = econf_readFile (&key_file1, "/usr/etc/test.conf", "=", "#");
+ *   error = econf_readFile (&key_file2, /etc/test.conf", "=", "#");
+ *   error = econf_mergeFilesConsume (&key_file_ret, key_file_1, key_file_2);
+ *
+ *   econf_free (key_file_ret);
+ * @endcode
+ *
+ */
+extern econf_err econf_mergeFilesConsume(econf_file **merged_file,
+					 econf_file *usr_file, econf_file *etc_file);
+
 
 /** @brief Evaluating key/values of a given configuration by reading and merging all
  *         needed/available files from different directories. Order is:
@@ -458,10 +588,145 @@ extern econf_err econf_readConfigWithCallback(econf_file **key_file,
 					      bool (*callback)(const char *filename, const void *data),
 					      const void *callback_data);
 
+/** @brief Read a configuration like econf_readConfig into a handle which
+ *         can be reloaded by econf_reload. The handle keeps every parsed
+ *         file, so a reload parses only the files which have been changed
+ *         and merges the result of the others again without parsing them.
+ *         The merged configuration is returned by econf_getConfig.
+ *
+ * @param handle reloadable configuration which has to be freed by
+ *        econf_freeHandle
+ * @param options options of econf_newKeyFile_with_options, e.g.
+ *        "PARSING_DIRS=...;ROOT_PREFIX=..." or NULL
+ * @param project, usr_subdir, config_name, config_suffix, delim, comment
+ *        see econf_readConfig. The directories set by econf_set_conf_dirs
+ *        are taken at this time.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_handle *handle = NULL;
+ *   econf_err error;
+ *
+ *   error = econf_openConfig (&handle, NULL, "foo", "/usr/etc", "bar", "conf", "=", "#");
+ *   error = econf_getIntValue (econf_getConfig (handle), "main", "size", &size);
+ *
+ *   - later on -
+ *   error = econf_reload (handle, NULL);
+ *
+ *   econf_free (handle);
+ * @endcode
+ *
+ */
+extern econf_err econf_openConfig(econf_handle **handle,
+				  const char *options,
+				  const char *project,
+				  const char *usr_subdir,
+				  const char *config_name,
+				  const char *config_suffix,
+				  const char *delim,
+				  const char *comment);
+
+/** @brief Update the configuration of handle. If no file or directory has
+ *         been changed (see econf_isStale) nothing is done. Otherwise the
+ *         files are looked up again, only new files and files with another
+ *         device, inode, modification time or size are parsed and the
+ *         configuration is merged of the parsed files.
+ *         The econf_file returned by econf_getConfig before is freed if the
+ *         configuration has been changed and it is not held by
+ *         econf_acquireConfig. In case of an error it is kept.
+ *         Concurrent calls are serialized.
+ *
+ * @param handle configuration opened by econf_openConfig
+ * @param changed set to true if the configuration has been merged again,
+ *        may be NULL
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_reload(econf_handle *handle, bool *changed);
+
+/** @brief Info about where the last error of econf_reload has happened.
+ *         For a handle of econf_openConfig this is the same as
+ *         econf_errLocation. The error of econf_openConfig and
+ *         econf_ctxOpenConfig is reported by econf_errLocation and
+ *         econf_ctxErrLocation.
+ *
+ * @param handle configuration opened by econf_openConfig
+ * @param filename Path of the last scanned file, which has to be freed.
+ * @param line_nr Number of the last handled line.
+ *
+ */
+extern void econf_handleErrLocation(econf_handle *handle, char **filename, uint64_t *line_nr);
+
+/** @brief Merged configuration of handle. It is owned by handle and is
+ *         valid until econf_reload changes it or handle is freed.
+ *         The econf_get* functions can be used on it.
+ *         If other threads call econf_reload, use econf_acquireConfig
+ *         instead.
+ *
+ * @param handle configuration opened by econf_openConfig
+ * @return merged configuration or NULL if handle is NULL
+ *
+ */
+extern econf_file *econf_getConfig(econf_handle *handle);
+
+/** @brief Take a reference to the merged configuration of handle, which
+ *         stays valid until it is released by econf_releaseConfig, even
+ *         if econf_reload replaces the configuration of handle meanwhile.
+ *         The configuration must not be changed, all threads can call
+ *         the econf_get* functions on it at the same time.
+ *         No lock is taken, so readers are never blocked by econf_reload
+ *         and never block it for longer than taking the reference. A
+ *         replaced configuration is freed when its last reference is
+ *         released.
+ *
+ * @param handle configuration opened by econf_openConfig
+ * @return merged configuration or NULL if handle is NULL
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   - reader threads -
+ *   econf_file *key_file = econf_acquireConfig (handle);
+ *   error = econf_getInt64Value (key_file, "main", "size", &size);
+ *   econf_releaseConfig (key_file);
+ *
+ *   - control thread -
+ *   error = econf_reload (handle, NULL);
+ * @endcode
+ *
+ */
+extern econf_file *econf_acquireConfig(econf_handle *handle);
+
+/** @brief Release a reference taken by econf_acquireConfig. The
+ *         configuration is freed if it has been replaced by econf_reload
+ *         (or the handle has been freed) and this was its last reference.
+ *
+ * @param key_file configuration returned by econf_acquireConfig or NULL
+ *
+ */
+extern void econf_releaseConfig(econf_file *key_file);
+
+/** @brief Free the handle and all its configurations. Configurations
+ *         which are held by econf_acquireConfig are freed when they are
+ *         released. No other thread may use handle at the same time.
+ *
+ * @param handle configuration opened by econf_openConfig
+ * @return NULL
+ *
+ */
+extern econf_handle *econf_freeHandle(econf_handle *handle);
+
 
 /** @brief Evaluating key/values of a given configuration by reading and merging all
  *         needed/available files in two different directories (normally in /usr/etc and /etc).
  *         DEPRECATED: Use the econf_readConfig/econf_readConfigWithCallback instead.
+ *         There is no econf_ctx variant, the global settings and error
+ *         location are used, so it must not be called by several threads
+ *         at the same time. See econf_ctxReadConfig.
  *
  * @param key_file content of parsed file(s).
  * @param usr_conf_dir absolute path of the first directory (normally "/usr/etc")
@@ -506,6 +771,9 @@ econf_readDirs(econf_file **key_file,
  *  directories (normally in /usr/etc and /etc). For each parsed file the user defined function
  *  will be called in order e.g. to check the correct file permissions.
  *  DEPRECATED: Use the econf_readConfig/econf_readConfigWithCallback instead.
+ *  There is no econf_ctx variant, the global settings and error location
+ *  are used, so it must not be called by several threads at the same
+ *  time. See econf_ctxReadConfigWithCallback.
  *
  * @param key_file content of parsed file(s).
  * @param usr_conf_dir absolute path of the first directory (normally "/usr/etc")
@@ -658,6 +926,12 @@ extern econf_err econf_newKeyFile(econf_file **result, char delimiter, char comm
  *           "<default_dirs>/<config_name>/"
  *  ROOT_PREFIX (default \<empty\>)
  *    Directory prefix used for all search directories if specified.
+ *  PARSING_THREADS (default 1)
+ *    Number of threads which parse the drop-in files of econf_readConfig.
+ *    With 1 the files are parsed one after another, 0 uses all online
+ *    CPUs. The files are merged in the same order anyway. The security
+ *    checks and the callback of econf_readConfigWithCallback are done for
+ *    all files before parsing starts. E.g. "PARSING_THREADS=4"
  *
  * e.g. Parsing configuration files written in python style:
  *
@@ -696,6 +970,20 @@ extern econf_err econf_newKeyFile_with_options(econf_file **result, const char *
  */
 extern econf_err econf_newIniFile(econf_file **result);
 
+/** @brief Preallocate memory for the given amount of key/value entries.
+ *         Entries are added with amortized constant cost anyway, but
+ *         if the rough size is known (e.g. before setting many values)
+ *         the memory can be allocated at once.
+ *
+ * @param key_file econf_file object.
+ * @param entries Number of key/value entries the object should be able
+ *        to hold without further allocations. If the object is already
+ *        larger nothing happens.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_reserve(econf_file *key_file, size_t entries);
+
 /** @brief Returns the comment character tag of the given econf_file object.
  *         This tag will be taken while writing comments to file.
  *
@@ -743,6 +1031,23 @@ extern void econf_set_delimiter_tag(econf_file *key_file, const char delimiter);
 extern econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
 				      const char *file_name);
 
+/** @brief Write the content of an econf_file struct (e.g. the result of
+ *         econf_readConfig) to a binary snapshot which can be loaded by
+ *         econf_openSnapshot without parsing and merging the config files
+ *         again. The snapshot contains a string table, the entries, a hash
+ *         index of the keys and the paths of the files the configuration
+ *         has been read from.
+ *         The snapshot is written to a temporary file which replaces
+ *         file_name, so readers never see a partly written snapshot.
+ *         It can only be read on machines with the same byte order.
+ *
+ * @param key_file Data which has to be written.
+ * @param file_name path of the snapshot
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_compileConfig(econf_file *key_file, const char *file_name);
+
 /* --------------- */
 /* --- GETTERS --- */
 /* --------------- */
@@ -756,6 +1061,74 @@ extern econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
  */
 extern char *econf_getPath(econf_file *kf);
 
+/** @brief Check whether the configuration files of kf have been changed.
+ *         econf_readConfig and econf_readDirs record every file and
+ *         directory they have consulted, also the ones which did not exist,
+ *         with device, inode, modification time and size. These are
+ *         compared with the current ones with statx only, no file is read.
+ *         A snapshot written by econf_compileConfig keeps the recorded
+ *         files, so also the result of econf_openSnapshot can be checked.
+ *
+ * @param kf result of econf_readConfig, econf_readDirs or econf_openSnapshot
+ * @return true if a file or directory has been created, removed or
+ *         changed since kf has been read, so it has to be read again.
+ *         false if nothing has been changed or kf has not been read by
+ *         these functions (nothing has been recorded).
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   if (econf_isStale (key_file)) {
+ *     econf_free (key_file);
+ *     key_file = NULL;
+ *     error = econf_readConfig (&key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+ *   }
+ * @endcode
+ *
+ */
+extern bool econf_isStale(econf_file *kf);
+
+/** @brief Watch the configuration files of kf with inotify. The returned
+ *         file descriptor becomes readable if one of the files or
+ *         directories which have been consulted by econf_readConfig
+ *         (see econf_isStale) is changed, created or removed. A path which
+ *         did not exist (e.g. a drop-in directory in /etc or /run) is
+ *         watched by its nearest existing parent directory.
+ *         The file descriptor is non blocking and can be added to an
+ *         epoll or poll loop, no thread is started.
+ *         If it becomes readable, call econf_watch again with the same
+ *         file descriptor (after reading the configuration again if
+ *         econf_isStale returns true). This discards the pending events
+ *         and watches the directories which have been created meanwhile.
+ *
+ * @param kf result of econf_readConfig, econf_readDirs or econf_openSnapshot
+ * @param fd inotify file descriptor. If it is negative a new one is created
+ *        which has to be closed by the caller.
+ * @return econf_err ECONF_SUCCESS or error code.
+ *         ECONF_NOFILE if no files have been recorded for kf.
+ *
+ * Usage:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   int fd = -1;
+ *
+ *   error = econf_watch (key_file, &fd);
+ *   - add fd to the epoll loop -
+ *
+ *   - fd is readable -
+ *   if (econf_isStale (key_file)) {
+ *     econf_free (key_file);
+ *     key_file = NULL;
+ *     error = econf_readConfig (&key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+ *   }
+ *   error = econf_watch (key_file, &fd);
+ * @endcode
+ *
+ */
+extern econf_err econf_watch(econf_file *kf, int *fd);
+
 /** @brief Evaluating all group entries.
  *
  * @param kf given/parsed data
@@ -1075,6 +1448,8 @@ extern econf_err econf_setBoolValue(econf_file *kf, const char *group, const cha
 extern const char *econf_errString (const econf_err error);
 
 /** @brief Info about where the error has happened.
+ *         The location is global for all functions without econf_ctx
+ *         argument, see econf_ctxErrLocation.
  *
  * @param filename Path of the last scanned file.
  * @param line_nr Number of the last handled line.
@@ -1185,12 +1560,340 @@ econf_reset_security_settings(void);
  *
  * CAUTION: These options are NOT TRHEAD-SAFE because they are set
  *          globally in libeconf. Individual setting set with econf_newKeyFile_with_options
- *          have higher priority and are trhead-safe.
+ *          have higher priority and are trhead-safe. econf_ctxSetConfDirs
+ *          sets them for a parser context.
  *
  */
 extern econf_err __attribute__ ((deprecated("Is not thread-safe. Use econf_newKeyFile_with_options instead")))
 econf_set_conf_dirs(const char **dir_postfix_list);
 
+/* --------------- */
+/* --- CONTEXT --- */
+/* --------------- */
+
+/** @brief Create a parser context. It carries the security settings and
+ *         the conf dirs of the econf_ctx* functions and the location of
+ *         their last error, which are global for all other functions.
+ *         A context must not be used by several threads at the same time,
+ *         but different threads can use different contexts.
+ *         Only the deprecated econf_readDirs and econf_readDirsWithCallback
+ *         have no econf_ctx variant.
+ *
+ * @param ctx new context with the default settings: no restrictions,
+ *        sym links are followed and no conf dirs are set.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ * Example: Reading a configuration owned by root in each thread:
+ * @code
+ *   #include "libeconf.h"
+ *
+ *   econf_ctx *ctx = NULL;
+ *   econf_file *key_file = NULL;
+ *   econf_err error;
+ *
+ *   if ((error = econf_newCtx (&ctx)))
+ *     return error;
+ *   econf_ctxRequireOwner (ctx, 0);
+ *   error = econf_ctxReadConfig (ctx, &key_file, "foo", "/usr/lib", "example",
+ *                                "conf", "=", "#");
+ *   if (error == ECONF_PARSE_ERROR) {
+ *     char *filename;
+ *     uint64_t line_nr;
+ *     econf_ctxErrLocation (ctx, &filename, &line_nr);
+ *     ...
+ *     free (filename);
+ *   }
+ *
+ *   econf_free (key_file);
+ *   econf_free (ctx);
+ * @endcode
+ */
+extern econf_err econf_newCtx(econf_ctx **ctx);
+
+/** @brief Free a context created by econf_newCtx.
+ *
+ * @param ctx context
+ * @return NULL
+ *
+ */
+extern econf_ctx *econf_freeCtx(econf_ctx *ctx);
+
+/* helper so that __attribute__((cleanup(econf_freeCtxp)) may be used */
+static __inline__ void econf_freeCtxp(econf_ctx **ctx) {
+  if (*ctx)
+    *ctx = econf_freeCtx(*ctx);
+}
+
+/** @brief All files parsed with ctx require this user permission.
+ *         See econf_requireOwner.
+ *
+ * @param ctx context
+ * @param owner User ID
+ * @return void
+ *
+ */
+extern void econf_ctxRequireOwner(econf_ctx *ctx, uid_t owner);
+
+/** @brief All files parsed with ctx require this group permission.
+ *         See econf_requireGroup.
+ *
+ * @param ctx context
+ * @param group Group ID
+ * @return void
+ *
+ */
+extern void econf_ctxRequireGroup(econf_ctx *ctx, gid_t group);
+
+/** @brief All files parsed with ctx have to have these file and directory
+ *         permissions. See econf_requirePermissions.
+ *
+ * @param ctx context
+ * @param file_perms file permissions
+ * @param dir_perms dir permissions
+ * @return void
+ *
+ */
+extern void econf_ctxRequirePermissions(econf_ctx *ctx, mode_t file_perms, mode_t dir_perms);
+
+/** @brief Allowing the parser to follow sym links with ctx (default: true).
+ *
+ * @param ctx context
+ * @param allow allow to follow sym links.
+ * @return void
+ *
+ */
+extern void econf_ctxFollowSymlinks(econf_ctx *ctx, bool allow);
+
+/** @brief Set the directory structures of ctx which are used if the
+ *         econf_file has none. See econf_set_conf_dirs.
+ *
+ * @param ctx context
+ * @param dir_postfix_list list of directory structures, NULL terminated.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxSetConfDirs(econf_ctx *ctx, const char **dir_postfix_list);
+
+/** @brief Info about where the last error of a function called with ctx
+ *         has happened. See econf_errLocation.
+ *
+ * @param ctx context
+ * @param filename Path of the last scanned file, which has to be freed.
+ * @param line_nr Number of the last handled line.
+ *
+ */
+extern void econf_ctxErrLocation(econf_ctx *ctx, char **filename, uint64_t *line_nr);
+
+/** @brief Same as econf_readFile with the settings of ctx.
+ *
+ * @param ctx context
+ * @param result content of parsed file.
+ * @param file_name absolute path of parsed file
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadFile(econf_ctx *ctx, econf_file **result,
+				   const char *file_name,
+				   const char *delim, const char *comment);
+
+/** @brief Same as econf_readFileWithCallback with the settings of ctx.
+ *
+ * @param ctx context
+ * @param result content of parsed file.
+ * @param file_name absolute path of parsed file
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @param callback function which will be called for the given filename.
+ *        This user defined function has the pathname as parameter and returns
+ *        true if this file can be parsed. If not, the parsing will be aborted
+ *        and ECONF_PARSING_CALLBACK_FAILED will be returned.
+ * @param callback_data pointer which will be given to the callback function.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadFileWithCallback(econf_ctx *ctx, econf_file **result,
+					       const char *file_name,
+					       const char *delim, const char *comment,
+					       bool (*callback)(const char *filename, const void *data),
+					       const void *callback_data);
+
+/** @brief Same as econf_readConfig with the settings of ctx.
+ *
+ * @param ctx context
+ * @param key_file content of parsed file(s), see econf_readConfig
+ * @param project name of the project used as subdirectory, can be NULL
+ * @param usr_subdir absolute path of the first directory (often "/usr/lib")
+ * @param config_name basename of the configuration file
+ * @param config_suffix suffix of the configuration file. Can also be NULL.
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadConfig(econf_ctx *ctx,
+				     econf_file **key_file,
+				     const char *project,
+				     const char *usr_subdir,
+				     const char *config_name,
+				     const char *config_suffix,
+				     const char *delim,
+				     const char *comment);
+
+/** @brief Same as econf_readConfigWithCallback with the settings of ctx.
+ *
+ * @param ctx context
+ * @param key_file content of parsed file(s), see econf_readConfig
+ * @param project name of the project used as subdirectory, can be NULL
+ * @param usr_subdir absolute path of the first directory (often "/usr/lib")
+ * @param config_name basename of the configuration file
+ * @param config_suffix suffix of the configuration file. Can also be NULL.
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @param callback function which will be called for each file.
+ *        This user defined function has the pathname as parameter and returns
+ *        true if this file can be parsed. If not, the parsing will be aborted
+ *        and ECONF_PARSING_CALLBACK_FAILED will be returned.
+ * @param callback_data pointer which will be given to the callback function.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadConfigWithCallback(econf_ctx *ctx,
+						 econf_file **key_file,
+						 const char *project,
+						 const char *usr_subdir,
+						 const char *config_name,
+						 const char *config_suffix,
+						 const char *delim,
+						 const char *comment,
+						 bool (*callback)(const char *filename, const void *data),
+						 const void *callback_data);
+
+/** @brief Same as econf_readBuffer with the settings of ctx.
+ *
+ * @param ctx context
+ * @param result content of parsed buffer
+ * @param data content of a configuration file, it does not need to be
+ *        null terminated
+ * @param length number of bytes of data
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadBuffer(econf_ctx *ctx, econf_file **result,
+				     const char *data, size_t length,
+				     const char *delim, const char *comment);
+
+/** @brief Same as econf_readFd with the settings of ctx.
+ *
+ * @param ctx context
+ * @param result content of parsed file
+ * @param fd file descriptor opened for reading
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadFd(econf_ctx *ctx, econf_file **result, int fd,
+				 const char *delim, const char *comment);
+
+/** @brief Same as econf_openSnapshot with the settings of ctx.
+ *
+ * @param ctx context
+ * @param result configuration of the snapshot
+ * @param file_name path of the snapshot written by econf_compileConfig
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxOpenSnapshot(econf_ctx *ctx, econf_file **result,
+				       const char *file_name);
+
+/** @brief Same as econf_readDirsHistory with the settings of ctx.
+ *
+ * @param ctx context
+ * @param key_files list of parsed file(s), see econf_readDirsHistory
+ * @param size Size of the evaluated key_files list.
+ * @param usr_conf_dir absolute path of the first directory (normally "/usr/etc")
+ * @param etc_conf_dir absolute path of the second directory (normally "/etc")
+ * @param config_name basename of the configuration file
+ * @param config_suffix suffix of the configuration file. Can also be NULL.
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadDirsHistory(econf_ctx *ctx,
+					  econf_file ***key_files,
+					  size_t *size,
+					  const char *usr_conf_dir,
+					  const char *etc_conf_dir,
+					  const char *config_name,
+					  const char *config_suffix,
+					  const char *delim,
+					  const char *comment);
+
+/** @brief Same as econf_readDirsHistoryWithCallback with the settings of ctx.
+ *
+ * @param ctx context
+ * @param key_files list of parsed file(s), see econf_readDirsHistory
+ * @param size Size of the evaluated key_files list.
+ * @param usr_conf_dir absolute path of the first directory (normally "/usr/etc")
+ * @param etc_conf_dir absolute path of the second directory (normally "/etc")
+ * @param config_name basename of the configuration file
+ * @param config_suffix suffix of the configuration file. Can also be NULL.
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @param callback function which will be called for each file.
+ *        This user defined function has the pathname as parameter and returns
+ *        true if this file can be parsed. If not, the parsing will be aborted
+ *        and ECONF_PARSING_CALLBACK_FAILED will be returned.
+ * @param callback_data pointer which will be given to the callback function.
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxReadDirsHistoryWithCallback(econf_ctx *ctx,
+						      econf_file ***key_files,
+						      size_t *size,
+						      const char *usr_conf_dir,
+						      const char *etc_conf_dir,
+						      const char *config_name,
+						      const char *config_suffix,
+						      const char *delim,
+						      const char *comment,
+						      bool (*callback)(const char *filename, const void *data),
+						      const void *callback_data);
+
+/** @brief Same as econf_openConfig with the settings of ctx. The handle
+ *         keeps a copy of the settings and the conf dirs of ctx, which
+ *         are used for every econf_reload, so ctx can be changed or freed
+ *         afterwards. The location of an error is stored in ctx, the one
+ *         of econf_reload is returned by econf_handleErrLocation.
+ *
+ * @param ctx context
+ * @param handle reloadable configuration which has to be freed by
+ *        econf_freeHandle
+ * @param options options of econf_newKeyFile_with_options or NULL
+ * @param project name of the project used as subdirectory, can be NULL
+ * @param usr_subdir absolute path of the first directory (often "/usr/lib")
+ * @param config_name basename of the configuration file
+ * @param config_suffix suffix of the configuration file. Can also be NULL.
+ * @param delim delimiters of key/value e.g. "\t ="
+ * @param comment array of characters which define the start of a comment
+ * @return econf_err ECONF_SUCCESS or error code
+ *
+ */
+extern econf_err econf_ctxOpenConfig(econf_ctx *ctx,
+				     econf_handle **handle,
+				     const char *options,
+				     const char *project,
+				     const char *usr_subdir,
+				     const char *config_name,
+				     const char *config_suffix,
+				     const char *delim,
+				     const char *comment);
+
 #ifdef __cplusplus
 }
 #endif
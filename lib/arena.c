@@ -0,0 +1,155 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Chunks are growing from ARENA_MIN_CHUNK to ARENA_MAX_CHUNK bytes. Strings
+   which would waste more than half of a chunk get their own one. */
+#define ARENA_MIN_CHUNK 1024
+#define ARENA_MAX_CHUNK (1024 * 1024)
+
+struct arena_chunk {
+  struct arena_chunk *next;
+  size_t size, used;
+  char data[];
+};
+
+static struct arena_chunk *
+new_chunk(size_t size)
+{
+  if (size > SIZE_MAX - sizeof(struct arena_chunk))
+    return NULL;
+  struct arena_chunk *chunk = malloc(sizeof(struct arena_chunk) + size);
+  if (chunk == NULL)
+    return NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
+
+char *
+arena_alloc(econf_arena *arena, size_t size)
+{
+  struct arena_chunk *chunk = arena->head;
+
+  if (chunk == NULL || chunk->size - chunk->used < size) {
+    if (arena->next_size < ARENA_MIN_CHUNK)
+      arena->next_size = ARENA_MIN_CHUNK;
+    if (size > arena->next_size / 2) {
+      /* Large string. The current chunk is still used for the next ones. */
+      if ((chunk = new_chunk(size)) == NULL)
+	return NULL;
+      chunk->used = size;
+      if (arena->head) {
+	chunk->next = arena->head->next;
+	arena->head->next = chunk;
+      } else {
+	chunk->next = NULL;
+	arena->head = chunk;
+      }
+      return chunk->data;
+    }
+    if ((chunk = new_chunk(arena->next_size)) == NULL)
+      return NULL;
+    chunk->next = arena->head;
+    arena->head = chunk;
+    if (arena->next_size < ARENA_MAX_CHUNK)
+      arena->next_size *= 2;
+  }
+
+  char *ret = chunk->data + chunk->used;
+  chunk->used += size;
+  return ret;
+}
+
+static char *
+copy(econf_arena *arena, const char *str, size_t len)
+{
+  char *ret = arena_alloc(arena, len + 1);
+  if (ret == NULL)
+    return NULL;
+  memcpy(ret, str, len);
+  ret[len] = '\0';
+  return ret;
+}
+
+char *
+arena_strndup(econf_arena *arena, const char *str, size_t n)
+{
+  return copy(arena, str, strnlen(str, n));
+}
+
+char *
+arena_strdup(econf_arena *arena, const char *str)
+{
+  return copy(arena, str, strlen(str));
+}
+
+char *
+arena_replace(econf_arena *arena, char *old, const char *str)
+{
+  size_t len = strlen(str);
+  if (old != NULL && len <= strlen(old)) {
+    memmove(old, str, len + 1);
+    return old;
+  }
+  return arena_strdup(arena, str);
+}
+
+void
+arena_move(econf_arena *dest, econf_arena *src)
+{
+  struct arena_chunk *last = src->head;
+
+  if (last == NULL)
+    return;
+  if (dest->head == NULL) {
+    *dest = *src;
+  } else {
+    /* The chunks of src are added behind the head of dest, so new strings
+       are still allocated in the current chunk of dest.  */
+    while (last->next)
+      last = last->next;
+    last->next = dest->head->next;
+    dest->head->next = src->head;
+  }
+  src->head = NULL;
+  src->next_size = 0;
+}
+
+void
+arena_free(econf_arena *arena)
+{
+  struct arena_chunk *chunk = arena->head;
+  while (chunk) {
+    struct arena_chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  arena->head = NULL;
+  arena->next_size = 0;
+}
@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+/* --- arena.h --- */
+
+#include <stddef.h>
+
+/* Bump allocator for the strings (groups, keys, values, comments) of an
+   econf_file. Strings are never freed individually. All memory is
+   released at once by arena_free.
+
+   Overwritten strings stay in the arena. In order to keep that small,
+   arena_replace reuses the old memory if the new string fits.  */
+
+typedef struct econf_arena {
+  struct arena_chunk *head;
+  /* Size of the next chunk which will be allocated. */
+  size_t next_size;
+} econf_arena;
+
+/* Allocate size bytes. The memory is not aligned, so it can only be
+   used for strings. Returns NULL if there is not enough memory.  */
+char *arena_alloc(econf_arena *arena, size_t size);
+
+/* Copy a string (at most n characters) into the arena. */
+char *arena_strdup(econf_arena *arena, const char *str);
+char *arena_strndup(econf_arena *arena, const char *str, size_t n);
+
+/* Return a copy of str which replaces old. If str fits into old, old is
+   overwritten instead. old can be NULL.  */
+char *arena_replace(econf_arena *arena, char *old, const char *str);
+
+/* Move all strings of src into dest without copying them. src is empty
+   afterwards.  */
+void arena_move(econf_arena *dest, econf_arena *src);
+
+/* Free all strings of the arena. */
+void arena_free(econf_arena *arena);
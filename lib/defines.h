@@ -42,5 +42,12 @@
 #define TRUE hashstring("true")
 #define FALSE hashstring("false")
 
+/* Upper limit of the PARSING_THREADS option */
+#define MAX_PARSE_THREADS 64
+
+/* Number of drop-in files which are opened at once for parsing them on
+   several threads, so many drop-in files do not exhaust RLIMIT_NOFILE */
+#define PARSE_CHUNK 32
+
 #define DEFAULT_RUN_SUBDIR "/run"
 #define DEFAULT_ETC_SUBDIR "/etc"
@@ -75,5 +75,5 @@ econf_errString (const econf_err error)
 
 extern void econf_errLocation (char **filename, uint64_t *line_nr)
 {
-  last_scanned_file( filename, line_nr );
+  last_scanned_file( &default_ctx, filename, line_nr );
 }
@@ -25,118 +25,286 @@
 #include "defines.h"
 #include "getfilecontents.h"
 #include "helpers.h"
+#include "scan.h"
+#include "strbuf.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <sys/stat.h>
 #include <dirent.h>
-#include <libgen.h>
-
-/*info for reporting scan errors (line Nr, filename) */
-static uint64_t last_scanned_line_nr = 0;
-static char *last_scanned_filename = NULL;
-
-// Checking file permissions, uid, group,...
-bool file_owner_set = false;
-uid_t file_owner = 0;
-bool file_group_set = false;
-gid_t file_group = 0;
-bool file_permissions_set = false;
-mode_t file_perms_file;
-mode_t file_perms_dir;
-bool allow_follow_symlinks = true;
+#include <unistd.h>
 
+/* Settings and error location of the functions without econf_ctx */
+econf_ctx default_ctx = { .allow_follow_symlinks = true };
+
+/* Concatenate head and the count strings of parts, separated by newlines,
+   with a single allocation. Without head there is no newline in front of
+   the first part.  */
+static char *
+join_strings(econf_arena *arena, const char *head, const char **parts, size_t count)
+{
+  size_t length = head ? strlen(head) : 0;
+  char *str, *p;
+
+  for (size_t i = 0; i < count; i++)
+    length += 1 + strlen(parts[i]);
+  if (head == NULL && count > 0)
+    length--;
+  if ((str = p = arena_alloc(arena, length + 1)) == NULL)
+    return NULL;
+  if (head)
+    p = stpcpy(p, head);
+  for (size_t i = 0; i < count; i++) {
+    if (head || i > 0)
+      *p++ = '\n';
+    p = stpcpy(p, parts[i]);
+  }
+  *p = '\0';
+  return str;
+}
+
+static const char *
+skip_space(const char *str)
+{
+  while (isspace((unsigned char) *str))
+    str++;
+  return str;
+}
+
+/* Join the values and comments of the entries chained by next into the
+   first entry. An entry without value resets the value and the comment
+   behind it. parts needs room for all entries of the chain.  */
 static econf_err
-join_same_entries(econf_file *ef)
+join_entry(econf_file *ef, size_t first, const size_t *next, const char **parts)
 {
-  for(size_t i = 0; i < ef->length; i++)
-  {
-    for(size_t j = i+1; j < ef->length; j++)
-    {
-      if (strcmp(ef->file_entry[i].group, ef->file_entry[j].group) == 0 &&
-	  strcmp(ef->file_entry[i].key, ef->file_entry[j].key) == 0)
-      {
-	char *post, *pre;
-	if (ef->file_entry[j].value == NULL ||
-	    strlen(ef->file_entry[j].value) == 0)
-	{
-	  /* reset entry */
-	  free(ef->file_entry[i].value);
-	  ef->file_entry[i].value = strdup("");
-	} else {
-	  /* appending value */
-	  post = ef->file_entry[j].value;
-	  pre = ef->file_entry[i].value;
-	  int ret = 0;
-	  if (post != NULL && strlen(post) > 0)
-	  {
-	    /* removing leading spaces */
-	    while(isspace(*post)) post++;
-	    ret = asprintf(&(ef->file_entry[i].value), "%s\n%s", pre,
-			   post);
-	    if(ret<0)
-	      return ECONF_NOMEM;
-	    free(pre);
-	  }
-	}
+  struct file_entry *fe = &ef->file_entry[first];
+  size_t count = 0, reset = SIZE_MAX;
+  char *str;
+
+  /* The last reset throws away everything in front of it */
+  for (size_t i = next[first]; i != SIZE_MAX; i = next[i]) {
+    if (ef->file_entry[i].value == NULL || *ef->file_entry[i].value == '\0')
+      reset = i;
+  }
 
-	/* appending before key comment */
-	if (ef->file_entry[j].comment_before_key != NULL &&
-	    strlen(ef->file_entry[j].comment_before_key) > 0)
-	{
-	  post = ef->file_entry[j].comment_before_key;
-          pre = ef->file_entry[i].comment_before_key;
-	  int ret = asprintf(&(ef->file_entry[i].comment_before_key),
-			     "%s\n%s", pre, post);
-	  if(ret<0)
-	    return ECONF_NOMEM;
-	  free(pre);
-	}
+  /* value */
+  for (size_t i = reset == SIZE_MAX ? next[first] : next[reset]; i != SIZE_MAX; i = next[i])
+    parts[count++] = skip_space(ef->file_entry[i].value);
+  str = join_strings(&ef->arena,
+		     (reset == SIZE_MAX && fe->value) ? fe->value : "", parts, count);
+  if (str == NULL)
+    return ECONF_NOMEM;
+  fe->value = str;
 
-	if (ef->file_entry[j].value == NULL ||
-	    strlen(ef->file_entry[j].value) == 0)
-	{
-	  /* reset after value comment */
-	  free(ef->file_entry[i].comment_after_value);
-	  ef->file_entry[i].comment_after_value = NULL;
-	} else {
-	  /* appending after value comment */
-	  if (ef->file_entry[j].comment_after_value != NULL &&
-	      strlen(ef->file_entry[j].comment_after_value) > 0)
-	  {
-	    post = ef->file_entry[j].comment_after_value;
-	    pre = ef->file_entry[i].comment_after_value;
-	    /* removing leading spaces */
-            while(isspace(*post)) post++;
-            if (pre == NULL)
-	    {
-	      ef->file_entry[i].comment_after_value = strdup(post);
-	    } else {
-	      int ret = asprintf(&(ef->file_entry[i].comment_after_value),
-				 "%s\n%s", pre, post);
-	      if(ret<0)
-		return ECONF_NOMEM;
-	      free(pre);
-	    }
-	  }
-	}
-      }
+  /* comment before key */
+  count = 0;
+  for (size_t i = next[first]; i != SIZE_MAX; i = next[i]) {
+    if (ef->file_entry[i].comment_before_key && *ef->file_entry[i].comment_before_key)
+      parts[count++] = ef->file_entry[i].comment_before_key;
+  }
+  if (count > 0) {
+    str = join_strings(&ef->arena, fe->comment_before_key ? fe->comment_before_key : "",
+		       parts, count);
+    if (str == NULL)
+      return ECONF_NOMEM;
+    fe->comment_before_key = str;
+  }
+
+  /* comment after value */
+  count = 0;
+  for (size_t i = reset == SIZE_MAX ? next[first] : next[reset]; i != SIZE_MAX; i = next[i]) {
+    if (ef->file_entry[i].comment_after_value && *ef->file_entry[i].comment_after_value)
+      parts[count++] = skip_space(ef->file_entry[i].comment_after_value);
+  }
+  if (reset != SIZE_MAX)
+    fe->comment_after_value = NULL;
+  if (count > 0) {
+    str = join_strings(&ef->arena, fe->comment_after_value, parts, count);
+    if (str == NULL)
+      return ECONF_NOMEM;
+    fe->comment_after_value = str;
+  }
+  return ECONF_SUCCESS;
+}
+
+/* Join all entries with the same group and key into the first of them
+   and remove the others. The entries are grouped with the key index, so
+   this is linear in the number of entries.  */
+static econf_err
+join_same_entries(econf_file *ef)
+{
+  size_t length = ef->length, first, kept = 0;
+  /* next: the following entry with the same group/key
+     tail: the last entry chained to a first entry, SIZE_MAX for all
+     entries which are joined into another one */
+  size_t *next = malloc(length * sizeof(size_t));
+  size_t *tail = malloc(length * sizeof(size_t));
+  const char **parts = malloc(length * sizeof(char *));
+  econf_err error = ECONF_SUCCESS;
+
+  if (length < 2)
+    goto out;
+  if (next == NULL || tail == NULL || parts == NULL) {
+    error = ECONF_NOMEM;
+    goto out;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    struct file_entry *fe = &ef->file_entry[i];
+    next[i] = SIZE_MAX;
+    tail[i] = i;
+    if (find_key(*ef, fe->group, fe->key, &first) == ECONF_SUCCESS && first != i) {
+      next[tail[first]] = i;
+      tail[first] = i;
+      tail[i] = SIZE_MAX;
     }
   }
+
+  for (size_t i = 0; i < length; i++) {
+    if (tail[i] == SIZE_MAX)
+      continue;
+    if (next[i] != SIZE_MAX && (error = join_entry(ef, i, next, parts)))
+      goto out;
+    ef->file_entry[kept++] = ef->file_entry[i];
+  }
+
+  if (kept < length) {
+    /* unused elements have to be zeroed, see key_file_append */
+    memset(&ef->file_entry[kept], 0, (length - kept) * sizeof(struct file_entry));
+    ef->length = kept;
+    error = key_index_rebuild(ef);
+  }
+
+ out:
+  free(next);
+  free(tail);
+  free(parts);
+  return error;
+}
+
+/* A string which is collected from one or more lines. A single line is
+   used as it is, more lines are joined in a buffer and copied into the
+   arena once they are complete, so every line is copied only once.  */
+struct lines {
+  char *str;         /* the first line, NULL if there is none */
+  econf_strbuf buf;  /* all lines if joined is true */
+  bool joined;
+};
+
+static bool
+lines_empty(const struct lines *l)
+{
+  return !l->joined && l->str == NULL;
+}
+
+static void
+lines_set(struct lines *l, char *str)
+{
+  l->str = str;
+  l->buf.length = 0;
+  l->joined = false;
+}
+
+/* Append sep and str. A missing first line is taken as empty string. */
+static econf_err
+lines_append(struct lines *l, const char *sep, const char *str)
+{
+  econf_err error;
+
+  if (!l->joined) {
+    l->buf.length = 0;
+    if (l->str && (error = strbuf_append(&l->buf, l->str, strlen(l->str))))
+      return error;
+    l->joined = true;
+  }
+  if ((error = strbuf_append(&l->buf, sep, strlen(sep))) ||
+      (error = strbuf_append(&l->buf, str, strlen(str))))
+    return error;
   return ECONF_SUCCESS;
 }
 
+/* Add str as next line */
 static econf_err
-store (econf_file *ef, const char *group, const char *key,
-       const char *value, const uint64_t line_number,
-       const char *comment_before_key, const char *comment_after_value,
+lines_add(struct lines *l, char *str)
+{
+  if (lines_empty(l)) {
+    lines_set(l, str);
+    return ECONF_SUCCESS;
+  }
+  return lines_append(l, "\n", str);
+}
+
+/* Return the complete string in result and start again. */
+static econf_err
+lines_finish(struct lines *l, econf_arena *arena, char **result)
+{
+  if (l->joined) {
+    *result = arena_strndup(arena, l->buf.length ? l->buf.data : "", l->buf.length);
+    if (*result == NULL)
+      return ECONF_NOMEM;
+  } else {
+    *result = l->str;
+  }
+  lines_set(l, NULL);
+  return ECONF_SUCCESS;
+}
+
+/* Strings of read_file which can consist of several lines */
+struct parse_state {
+  /* comments which belong to the next new entry */
+  struct lines comment_before_key, comment_after_value;
+  /* value and comment of the entry to which following lines are
+     appended, open is SIZE_MAX if there is none */
+  size_t open;
+  struct lines value, value_comment;
+};
+
+/* Store value and comment of the open entry */
+static econf_err
+close_entry(econf_file *ef, struct parse_state *state)
+{
+  econf_err error;
+
+  if (state->open == SIZE_MAX)
+    return ECONF_SUCCESS;
+  struct file_entry *fe = &ef->file_entry[state->open];
+  state->open = SIZE_MAX;
+  if ((error = lines_finish(&state->value, &ef->arena, &fe->value)) ||
+      (error = lines_finish(&state->value_comment, &ef->arena, &fe->comment_after_value)))
+    return error;
+  return ECONF_SUCCESS;
+}
+
+static void
+free_parse_state(struct parse_state *state)
+{
+  strbuf_free(&state->comment_before_key.buf);
+  strbuf_free(&state->comment_after_value.buf);
+  strbuf_free(&state->value.buf);
+  strbuf_free(&state->value_comment.buf);
+}
+
+/* Add a new entry with the collected comments or append value and comment
+   to the last entry. New entries take over key and value, which have to be
+   part of the arena. The collected comments are used up in both cases.  */
+static econf_err
+store (econf_file *ef, struct parse_state *state, const char *group, char *key,
+       char *value, const uint64_t line_number,
        const bool quotes,
        const bool append_entry)
 {
+  econf_err error;
+  char *comment_before_key, *comment_after_value;
+
+  if ((error = lines_finish(&state->comment_before_key, &ef->arena, &comment_before_key)) ||
+      (error = lines_finish(&state->comment_after_value, &ef->arena, &comment_after_value)))
+    return error;
 
   if (append_entry)
   {
@@ -152,89 +320,67 @@ store (econf_file *ef, const char *group, const char *key,
         value++;
     }
 
-    char *content = ef->file_entry[ef->length-1].value;
-    int ret = asprintf(&(ef->file_entry[ef->length-1].value), "%s\n%s", content,
-	     value);
-    if(ret<0)
-      return ECONF_NOMEM;
-    free(content);
+    struct file_entry *fe = &ef->file_entry[ef->length-1];
+    if (state->open != ef->length-1) {
+      if ((error = close_entry(ef, state)))
+	return error;
+      state->open = ef->length-1;
+      lines_set(&state->value, fe->value);
+      lines_set(&state->value_comment, fe->comment_after_value);
+    }
+    if ((error = lines_append(&state->value, "\n", value)))
+      return error;
     /* Points to the end of the array. This is needed for the next entry. */
-    ef->file_entry[ef->length-1].line_number = line_number;
+    fe->line_number = line_number;
 
-    if (ef->file_entry[ef->length-1].comment_after_value &&
-	!comment_after_value)
+    const char *comment = comment_after_value;
+    if (!lines_empty(&state->value_comment) && !comment)
     { /* multiline entry. This line has no comment. So we have to add an empty entry. */
-      comment_after_value = "";
+      comment = "";
     }
 
-    if (comment_after_value)
-    {
-      ret = -1;
-      if (ef->file_entry[ef->length-1].comment_after_value)
-      {
-	content = ef->file_entry[ef->length-1].comment_after_value;
-	ret = asprintf(&(ef->file_entry[ef->length-1].comment_after_value), "%s\n%s", content,
-		       comment_after_value);
-	free(content);
-      } else {
-	ret = asprintf(&(ef->file_entry[ef->length-1].comment_after_value), "\n%s",
-		       comment_after_value);
-      }
-      if(ret<0)
-	return ECONF_NOMEM;
-    }
+    if (comment && (error = lines_append(&state->value_comment, "\n", comment)))
+      return error;
 
     return ECONF_SUCCESS;
   }
 
   /* not appending -> new entry */
-  if (ef->alloc_length == ef->length) {
-    struct file_entry *tmp;
-
-    tmp = realloc(ef->file_entry, (ef->length + 1) * sizeof(struct file_entry));
-    if (!tmp)
-      return ECONF_NOMEM;
-    ef->file_entry = tmp;
-    ef->length++;
-    ef->alloc_length = ef->length;
-  }
+  if ((error = close_entry(ef, state)))
+    return error;
+  error = key_file_reserve(ef, ef->length + 1);
+  if (error)
+    return error;
+  ef->length++;
 
   ef->file_entry[ef->length-1].line_number = line_number;
 
   ef->file_entry[ef->length-1].quotes = quotes;
 
-  if (group)
-	  ef->file_entry[ef->length-1].group = setGroupList(ef, group);
-  else
-    ef->file_entry[ef->length-1].group = setGroupList(ef, KEY_FILE_NULL_VALUE);
+  ef->file_entry[ef->length-1].group = setGroupList(ef, group ? group : KEY_FILE_NULL_VALUE,
+						    &ef->file_entry[ef->length-1].group_id);
+  if (ef->file_entry[ef->length-1].group == NULL)
+    return ECONF_NOMEM;
 
   if (key) {
     /* remove space at the end of the key */
-    const char *p = key + strlen(key);
+    char *p = key + strlen(key);
     if (p > key)
       p--;
     while (p > key && (isspace((unsigned)*p)))
       p--;
-    ef->file_entry[ef->length-1].key = strndup(key, (size_t)(p+1-key));
+    if (*p)
+      p[1] = '\0';
+    ef->file_entry[ef->length-1].key = key;
+  } else {
+    ef->file_entry[ef->length-1].key = arena_strdup(&ef->arena, KEY_FILE_NULL_VALUE);
   }
-  else
-    ef->file_entry[ef->length-1].key = strdup(KEY_FILE_NULL_VALUE);
 
-  if (value)
-    ef->file_entry[ef->length-1].value = strdup(value);
-  else
-    ef->file_entry[ef->length-1].value = NULL;
+  ef->file_entry[ef->length-1].value = value;
+  ef->file_entry[ef->length-1].comment_before_key = comment_before_key;
+  ef->file_entry[ef->length-1].comment_after_value = comment_after_value;
 
-  if (comment_before_key)
-    ef->file_entry[ef->length-1].comment_before_key = strdup(comment_before_key);
-  else
-    ef->file_entry[ef->length-1].comment_before_key = NULL;
-  if (comment_after_value)
-    ef->file_entry[ef->length-1].comment_after_value = strdup(comment_after_value);
-  else
-    ef->file_entry[ef->length-1].comment_after_value = NULL;
-
-  return ECONF_SUCCESS;
+  return key_index_add(ef, ef->length-1);
 }
 
 static void
@@ -253,63 +399,142 @@ check_delim(const char *str, bool *has_wsp, bool *has_nonwsp)
   }
 }
 
-static void free_buffer(char **buffer)
+/* Character classes of the parser. A character can be in several classes,
+   e.g. a whitespace delimiter. Only newline and null byte are CC_EOL.  */
+enum {
+  CC_SPACE = 1,
+  CC_DELIM = 2,
+  CC_COMMENT = 4,
+  CC_QUOTE = 8,
+  CC_EOL = 16
+};
+
+static void
+init_char_classes(unsigned char *cc, const char *delim, const char *comment)
+{
+  memset(cc, 0, UCHAR_MAX + 1);
+  for (int c = 1; c <= UCHAR_MAX; c++) {
+    if (isspace(c))
+      cc[c] |= CC_SPACE;
+  }
+  for (; delim && *delim; delim++)
+    cc[(unsigned char) *delim] |= CC_DELIM;
+  for (; comment && *comment; comment++)
+    cc[(unsigned char) *comment] |= CC_COMMENT;
+  cc['"'] |= CC_QUOTE;
+  cc['\0'] |= CC_EOL;
+  cc['\n'] |= CC_EOL;
+}
+
+/* Positions found while scanning a line. Pointers are NULL if there is
+   no such character.  */
+struct line_tokens {
+  char *name;          /* first character after the leading whitespace */
+  char *end;           /* first newline or null byte */
+  char *line_end;      /* newline or end of the buffer */
+  char *first_comment; /* first comment character of the line */
+  char *name_comment;  /* first comment character starting at name */
+  char *comment;       /* first comment character after the last quote */
+  char *first_space;   /* first whitespace starting at name */
+  char *name_end;      /* first whitespace or delimiter starting at name */
+  char *next_delim;    /* first delimiter after name_end */
+};
+
+/* Tokenize the line starting at buf in a single pass, so the cost does not
+   depend on the number of delimiter and comment characters. Only the
+   structural characters found by scan_buffer() are looked at.  */
+static void
+scan_line(const unsigned char *cc, const uint64_t *bits,
+	  char *content, size_t length, char *buf, struct line_tokens *tok)
+{
+  unsigned char cls;
+  size_t pos = buf - content;
+  char *p;
+
+  memset(tok, 0, sizeof(*tok));
+  while (scan_next(bits, pos, length) == pos &&
+	 ((cls = cc[(unsigned char) content[pos]]) & (CC_SPACE|CC_EOL)) == CC_SPACE) {
+    if ((cls & CC_COMMENT) && !tok->first_comment)
+      tok->first_comment = content + pos;
+    pos++;
+  }
+  tok->name = content + pos;
+
+  for (;; pos++) {
+    pos = scan_next(bits, pos, length);
+    p = content + pos;
+    if (!(cls = cc[(unsigned char) *p]))
+      continue;
+    if (cls & CC_EOL)
+      break;
+    if (cls & CC_COMMENT) {
+      if (!tok->name_comment)
+	tok->name_comment = p;
+      if (!tok->comment)
+	tok->comment = p;
+    }
+    /* Comment characters in front of a quote may be quoted */
+    if (cls & CC_QUOTE)
+      tok->comment = NULL;
+    if ((cls & CC_SPACE) && !tok->first_space)
+      tok->first_space = p;
+    if (cls & (CC_SPACE|CC_DELIM)) {
+      if (!tok->name_end)
+	tok->name_end = p;
+      else if ((cls & CC_DELIM) && !tok->next_delim)
+	tok->next_delim = p;
+    }
+  }
+  tok->end = p;
+  if (!tok->first_comment)
+    tok->first_comment = tok->name_comment;
+
+  /* A null byte in the line hides the rest of it */
+  if (*p == '\0' && pos < length) {
+    p = memchr(p, '\n', length - pos);
+    if (p == NULL)
+      p = content + length;
+  }
+  tok->line_end = p;
+}
+
+/* Same as read_file_r, the location of an error is stored in ctx */
+static econf_err
+read_file(econf_ctx *ctx, econf_file *ef, const char *file, int fd,
+	  const struct stat *sb, const char *delim, const char *comment)
 {
-    free(*buffer);
+  uint64_t line_nr = ctx->last_scanned_line_nr;
+  econf_err error = read_file_r(ef, file, fd, sb, delim, comment, &line_nr);
+
+  return set_scan_location(ctx, file, line_nr, error);
 }
 
 econf_err
-read_file_with_callback(econf_file **key_file, const char *file_name,
-			const char *delim, const char *comment,
+read_file_with_callback(econf_ctx *ctx, struct dir_cache *dirs, econf_file **key_file,
+			const char *file_name, const char *delim, const char *comment,
 			bool (*callback)(const char *filename, const void *data),
 			const void *callback_data)
 {
   econf_err t_err;
   struct stat sb;
+  int fd;
 
   if (key_file == NULL || file_name == NULL || delim == NULL || comment == NULL)
     return ECONF_ARGUMENT_IS_NULL_VALUE;
 
-  // Checking file permissions, uid, group,...
-  if (lstat(file_name, &sb) == -1)
-    return ECONF_NOFILE;
-  if (!allow_follow_symlinks && (sb.st_mode&S_IFMT) == S_IFLNK)
-    return ECONF_ERROR_FILE_IS_SYM_LINK;
-  if (file_owner_set && sb.st_uid != file_owner)
-    return ECONF_WRONG_OWNER;
-  if (file_group_set && sb.st_gid != file_group)
-    return ECONF_WRONG_GROUP;
-  if (file_permissions_set) {
-    struct stat sb_dir;
-    if (!(sb.st_mode&file_perms_file))
-      return ECONF_WRONG_FILE_PERMISSION;
-    char *cdirc = strdup(file_name);
-    int dir_stat = lstat(dirname(cdirc), &sb_dir);
-    free(cdirc);
-    if ( dir_stat == -1)
-      return ECONF_NOFILE;
-    if (!(sb_dir.st_mode&file_perms_dir))
-      return ECONF_WRONG_DIR_PERMISSION;
-  }
-
-  // calling user defined checks
-  if (callback != NULL && !(*callback)(file_name, callback_data))
-    return ECONF_PARSING_CALLBACK_FAILED;
+  if ((t_err = open_checked(ctx, dirs, file_name, callback, callback_data, &fd, &sb)))
+    return t_err;
 
   // Get absolute path if not provided
   char *absolute_path = get_absolute_path(file_name, &t_err);
-  if (absolute_path == NULL)
+  if (absolute_path == NULL) {
+    close (fd);
     return t_err;
-
-  if (*comment)
-    (*key_file)->comment = comment[0];
-  else {
-    (*key_file)->comment = '#';
-    comment = "#";
   }
 
-  t_err = read_file(*key_file, absolute_path, delim, comment);
+  t_err = read_file(ctx, *key_file, absolute_path, fd, &sb, delim, comment);
 
+  close (fd);
   free (absolute_path);
 
   if(t_err) {
@@ -321,123 +546,273 @@ read_file_with_callback(econf_file **key_file, const char *file_name,
   return ECONF_SUCCESS;
 }
 
-/* Read the file line by line and parse for comments, keys and values */
 econf_err
-read_file(econf_file *ef, const char *file,
-	  const char *delim, const char *comment)
+open_error(int error)
+{
+  switch (error) {
+  case EMFILE:
+  case ENFILE:
+    return ECONF_ERROR;
+  case ENOMEM:
+    return ECONF_NOMEM;
+  default:
+    return ECONF_NOFILE;
+  }
+}
+
+void
+free_dir_cache(struct dir_cache *cache)
+{
+  for (size_t i = 0; i < cache->count; i++) {
+    if (cache->entries[i].fd >= 0)
+      close(cache->entries[i].fd);
+    free(cache->entries[i].path);
+  }
+  free(cache->entries);
+  cache->entries = NULL;
+  cache->count = cache->alloc = 0;
+}
+
+/* Find the parent directory of file_name, which are the first length
+   bytes of it, in cache or open it. The config files are spread over a
+   few directories only, so they are searched linearly.  */
+static econf_err
+open_dir(struct dir_cache *cache, const char *file_name, size_t length,
+	 struct dir_entry **dir)
+{
+  struct dir_entry *entry;
+  econf_err error;
+
+  for (size_t i = 0; i < cache->count; i++) {
+    entry = &cache->entries[i];
+    if (strncmp(entry->path, file_name, length) == 0 && entry->path[length] == '\0') {
+      *dir = entry;
+      return ECONF_SUCCESS;
+    }
+  }
+
+  if (cache->count == cache->alloc) {
+    size_t alloc = cache->alloc ? cache->alloc * 2 : 4;
+    entry = realloc(cache->entries, alloc * sizeof(struct dir_entry));
+    if (entry == NULL)
+      return ECONF_NOMEM;
+    cache->entries = entry;
+    cache->alloc = alloc;
+  }
+  entry = &cache->entries[cache->count];
+  if ((entry->path = strndup(file_name, length)) == NULL)
+    return ECONF_NOMEM;
+  /* A file name without slash is relative to the working directory */
+  entry->fd = open(length ? entry->path : ".", O_PATH | O_DIRECTORY | O_CLOEXEC);
+  if (entry->fd < 0 && (error = open_error(errno)) != ECONF_NOFILE) {
+    free(entry->path);
+    return error;
+  }
+  if (entry->fd >= 0 && fstat(entry->fd, &entry->st) != 0) {
+    close(entry->fd);
+    entry->fd = -1;
+  }
+  cache->count++;
+  *dir = entry;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+open_checked(const econf_ctx *ctx, struct dir_cache *dirs, const char *file_name,
+	     bool (*callback)(const char *filename, const void *data),
+	     const void *callback_data, int *fd, struct stat *sb)
+{
+  struct dir_cache local = { NULL, 0, 0 };
+  const char *base = strrchr(file_name, '/');
+  int flags = O_RDONLY | O_CLOEXEC;
+  struct dir_entry *dir;
+  econf_err error = ECONF_SUCCESS;
+
+  *fd = -1;
+  if (dirs == NULL)
+    dirs = &local;
+  if (!ctx->allow_follow_symlinks)
+    flags |= O_NOFOLLOW;
+
+  /* the parent directory is "/" for /name */
+  if ((error = open_dir(dirs, file_name,
+			base == NULL ? 0 : base == file_name ? 1 : (size_t) (base - file_name),
+			&dir)))
+    goto out;
+  if (dir->fd < 0) {
+    error = ECONF_NOFILE;
+    goto out;
+  }
+  if ((*fd = openat(dir->fd, base ? base + 1 : file_name, flags)) < 0) {
+    error = errno == ELOOP && (flags & O_NOFOLLOW) ?
+      ECONF_ERROR_FILE_IS_SYM_LINK : open_error(errno);
+    goto out;
+  }
+
+  // Checking file permissions, uid, group,...
+  if (fstat(*fd, sb) != 0)
+    error = ECONF_NOFILE;
+  else if (ctx->file_owner_set && sb->st_uid != ctx->file_owner)
+    error = ECONF_WRONG_OWNER;
+  else if (ctx->file_group_set && sb->st_gid != ctx->file_group)
+    error = ECONF_WRONG_GROUP;
+  else if (ctx->file_permissions_set && !(sb->st_mode&ctx->file_perms_file))
+    error = ECONF_WRONG_FILE_PERMISSION;
+  else if (ctx->file_permissions_set && !(dir->st.st_mode&ctx->file_perms_dir))
+    error = ECONF_WRONG_DIR_PERMISSION;
+  // calling user defined checks
+  else if (callback != NULL && !(*callback)(file_name, callback_data))
+    error = ECONF_PARSING_CALLBACK_FAILED;
+
+ out:
+  if (error && *fd >= 0) {
+    close(*fd);
+    *fd = -1;
+  }
+  free_dir_cache(&local);
+  return error;
+}
+
+/* Read the complete file into a null terminated buffer of the arena.
+   A read error ends the file like it did for getline.  */
+static econf_err
+load_file(econf_arena *arena, int fd, const struct stat *sb,
+	  char **data, size_t *length)
+{
+  struct stat st;
+  size_t size = BUFSIZ, len = 0;
+  char *buf, *heap_buf = NULL;
+  ssize_t n;
+
+  /* One byte more than the file size to see that the file is complete */
+  if (sb == NULL && fstat(fd, &st) == 0)
+    sb = &st;
+  if (sb && S_ISREG(sb->st_mode) && (uintmax_t) sb->st_size < SIZE_MAX - 1)
+    size = (size_t) sb->st_size + 1;
+  if ((buf = arena_alloc(arena, size + 1)) == NULL)
+    return ECONF_NOMEM;
+
+  for (;;) {
+    n = read(fd, buf + len, size - len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    len += n;
+    if (len < size)
+      continue;
+    /* The file is larger than expected (e.g. a pipe). Continue on the heap
+       and copy the result into the arena at the end. */
+    char *tmp = size > SIZE_MAX / 2 ? NULL : realloc(heap_buf, size * 2 + 1);
+    if (tmp == NULL) {
+      free(heap_buf);
+      return ECONF_NOMEM;
+    }
+    if (heap_buf == NULL)
+      memcpy(tmp, buf, len);
+    heap_buf = buf = tmp;
+    size *= 2;
+  }
+
+  if (heap_buf) {
+    buf = arena_alloc(arena, len + 1);
+    if (buf)
+      memcpy(buf, heap_buf, len);
+    free(heap_buf);
+    if (buf == NULL)
+      return ECONF_NOMEM;
+  }
+  buf[len] = '\0';
+  *data = buf;
+  *length = len;
+  return ECONF_SUCCESS;
+}
+
+/* Parse content line by line for comments, keys and values. content
+   has to be null terminated and part of the arena of the econf_file,
+   because it is cut into strings in place, so keys, values and comments
+   only have to be copied if they consist of more than one line.
+   The number of the last scanned line is returned in line_nr, which is
+   not changed for empty content.  */
+static econf_err
+parse_content(econf_file *ef, char *content, size_t content_length,
+	      const char *delim, const char *comment, uint64_t *line_nr)
 {
   char *current_group = NULL;
-  char *current_comment_before_key = NULL;
-  char *current_comment_after_value = NULL;
+  struct parse_state state = { .open = SIZE_MAX };
   econf_err retval = ECONF_SUCCESS;
   uint64_t line = 0;
   bool has_wsp, has_nonwsp;
-  FILE *kf = fopen(file, "rbe");
-
-  if (kf == NULL)
-    return ECONF_NOFILE;
+  unsigned char cc[UCHAR_MAX + 1];
+  econf_scanner scanner;
+  uint64_t *bits;
+  char *content_end = content + content_length, *next;
 
+  if (*comment)
+    ef->comment = comment[0];
+  else {
+    ef->comment = '#';
+    comment = "#";
+  }
+  ef->delimiter = *delim;
   check_delim(delim, &has_wsp, &has_nonwsp);
 
-  ef->path = strdup (file);
-  if (ef->path == NULL) {
-    fclose (kf);
+  init_char_classes(cc, delim, comment);
+  scan_init(&scanner, cc);
+  bits = scan_buffer(&scanner, content, content_length);
+  if (bits == NULL)
     return ECONF_NOMEM;
-  }
-  ef->delimiter = *delim;
 
-  size_t max_size = BUFSIZ;
-  char *buf = malloc(max_size * sizeof(char));
-  while (getline(&buf, &max_size, kf) != -1) {
-    char *p, *name, *data = NULL;
+  for (next = content; next < content_end;) {
+    struct line_tokens tok;
+    char *buf, *p, *name, *cut, *data = NULL;
     bool quote_seen = false, delim_seen = false;
-    char *org_buf __attribute__ ((__cleanup__(free_buffer))) = strdup(buf);
+    /* Null bytes written into a line which has to be restored if the line
+       continues the value of the previous entry. See below. */
+    char *key_end = NULL, key_end_c = '\0';
+    char *comment_start = NULL, comment_start_c = '\0';
+    char *org_end = NULL;
+
+    /* Cut the next line and remove the trailing newline character */
+    buf = next;
+    scan_line(cc, bits, content, content_length, buf, &tok);
+    next = tok.line_end;
+    if (next < content_end)
+      *next++ = '\0';
 
     line++;
-    last_scanned_line_nr = line;
-
-    /* Remove trailing newline character */
-    size_t n = strlen(buf);
-    if (n && *(buf + n - 1) == '\n')
-      *(buf + n - 1) = '\0';
 
     if (!*buf)
       continue; /* empty line */
+    name = tok.name;
+    /* The strings of the line end at cut after removing comments */
+    cut = tok.end;
 
-    /* ignore space at beginning of the line */
-    name = buf;
-    while (*name && isspace((unsigned)*name))
-      name++;
+    /* Only the directly following line can be appended to an entry. Remember
+       where the text for appending ends before the line gets changed. */
+    if (ef->length > 0 && ef->file_entry[ef->length-1].line_number+1 == line)
+      org_end = (ef->python_style || !tok.first_comment) ? tok.end : tok.first_comment;
 
-    /* go through all comment characters and check if one of them could be found */
-    for (size_t i = 0; i < strlen(comment); i++) {
-      p = strchr(name, comment[i]);
-      if (p)
+    if (cc[(unsigned char) *name] & CC_COMMENT)
+    {
+      /* Comment is defined in the line before the key/value line */
+      if ((retval = lines_add(&state.comment_before_key, name+1)))
+	goto out;
+      comment_start = name;
+      comment_start_c = *name;
+      *name = '\0';
+      cut = name;
+    } else if (tok.name_comment && ef->python_style == false) { /* not for python config files */
+      /* Without delimiter the value starts at the first whitespace */
+      data = tok.first_space ? tok.first_space : tok.end;
+      /* Comment is defined after the key/value in the same line. A comment
+	 character is taken only if it is not enclosed in quotes. */
+      if (tok.comment)
       {
-	if (p==name)
-	{
-	  /* Comment is defined in the line before the key/value line */
-	  if (current_comment_before_key)
-          {
-	    /* appending */
-	    char *content = current_comment_before_key;
-	    int ret = asprintf(&current_comment_before_key, "%s\n%s", content,
-			       p+1);
-	    if (ret<0) {
-	      free(buf);
-	      return ECONF_NOMEM;
-	    }
-	    free(content);
-	  } else {
-	    current_comment_before_key = strdup(p+1);
-	  }
-	  *p = '\0';
-	} else if (ef->python_style == false) { /* not for python config files */
-	  /* Comment is defined after the key/value in the same line */
-	  char *first_quote = strchr(name, '"');
-	  char *last_quote = strrchr(name, '"');
-	  bool delim_found = false;
-
-	  data = name;
-	  while (*data && !(isspace((unsigned)*data) ||
-			    strchr(delim, *data) != NULL))
-		  data++;
-	  if (*data && strchr(delim, *data) != NULL)
-	    delim_found = false;
-
-	  while (p) {
-	    /* going through all comments hits and find the first one */
-	    /* who i not inside of two quotes */
-	    if ( first_quote==NULL || /* no quote */
-		 (first_quote!=last_quote && last_quote<p) || /* comment is in string included */
-		 (first_quote==last_quote && last_quote<p && !delim_found)) /* multiline with one quote */
-	    {
-	      if (current_comment_after_value)
-	      {
-	        /* appending */
-	        char *content = current_comment_after_value;
-	        int ret = asprintf(&current_comment_after_value, "%s\n%s", content,
-				   p+1);
-	        if(ret<0) {
-	          free(buf);
-	          return ECONF_NOMEM;
-	        }
-	        free(content);
-	      } else {
-	        current_comment_after_value = strdup(p+1);
-	      }
-	      *p = '\0';
-	    } else {
-	      p++;
-	    }
-	    /* find next comment flag */
-	    for (size_t k = 0; k < strlen(comment); k++) {
-	      p = strchr(p, comment[k]);
-	      if (p)
-		break;
-	    }
-	  }
-	}
+	if ((retval = lines_add(&state.comment_after_value, tok.comment+1)))
+	  goto out;
+	*tok.comment = '\0';
+	cut = tok.comment;
       }
     }
 
@@ -462,29 +837,26 @@ read_file(econf_file *ef, const char *file,
 	retval = ECONF_EMPTY_SECTION_NAME;
 	goto out;
       }
-      current_group = setGroupList(ef, name);
+      current_group = setGroupList(ef, name, NULL);
       continue;
     }
 
     if (delim == NULL || strlen(delim) == 0 || strcmp(delim, "\n") == 0) {
-      /* No delimiter is defined. Key without a value will be stored. */
-      retval = store(ef, current_group, name, data, line,
-		     current_comment_before_key, current_comment_after_value,
+      /* No delimiter is defined. Key without a value will be stored.
+	 The value shares the line with key and comment, so it is copied. */
+      if (data && (data = arena_strdup(&ef->arena, data)) == NULL) {
+	retval = ECONF_NOMEM;
+	goto out;
+      }
+      retval = store(ef, &state, current_group, name, data, line,
 		     false, /* no quote */
 		     false /* new entry */);
-      free(current_comment_before_key);
-      current_comment_before_key = NULL;
-      free(current_comment_after_value);
-      current_comment_after_value = NULL;
       continue;
     }
 
     /* Valid delimiters are defined */
     /* go to the end of the name */
-    data = name;
-    while (*data && !(isspace((unsigned)*data) ||
-		      strchr(delim, *data) != NULL))
-      data++;
+    data = (tok.name_end && tok.name_end < cut) ? tok.name_end : cut;
     if (data > name && *data) {
       if (has_wsp && has_nonwsp)
       {
@@ -493,13 +865,14 @@ read_file(econf_file *ef, const char *file,
 	 * In this case delim_seen has the special meaning "non-whitespace
 	 * delim seen". See comment below.
 	 */
-	delim_seen = !isspace((unsigned)*data) &&
-	  strchr(delim, *data) != NULL;
+	delim_seen = (cc[(unsigned char) *data] & (CC_SPACE|CC_DELIM)) == CC_DELIM;
       }
       else
       {
-	delim_seen = strchr(delim, *data) != NULL;
+	delim_seen = cc[(unsigned char) *data] & CC_DELIM;
       }
+      key_end = data;
+      key_end_c = *data;
       *data++ = '\0';
     }
 
@@ -513,19 +886,19 @@ read_file(econf_file *ef, const char *file,
        */
       bool found_delim = false;
       if (ef->python_style == false ||
-	  !isspace(*org_buf))
+	  !(cc[(unsigned char) *buf] & CC_SPACE))
       {
         /* It is not a typical python style with indentation */
 	/* So, delimiter has to be regarded */
         found_delim = delim_seen;
         if (!found_delim)
         {
-          /* searching the rest of the string for delimiters */
-	  char *c = data;
-	  while (*c && !(strchr(delim, *c) != NULL))
-	    c++;
-          if (*c)
-	    found_delim = true;
+          /* searching the rest of the string for delimiters. Without
+	     key end data is the delimiter at the beginning of name. */
+	  if (key_end)
+	    found_delim = tok.next_delim && tok.next_delim < cut;
+	  else
+	    found_delim = *data != '\0';
 	}
       }
       if (!found_delim &&
@@ -534,25 +907,16 @@ read_file(econf_file *ef, const char *file,
 	  /* The Entry must be the next line. Otherwise it is a new one */
 	  ef->file_entry[ef->length-1].line_number+1 == line)
       {
-	if (ef->python_style == false) { /* not for python config files */
-          /* removing comments */
-          for (size_t i = 0; i < strlen(comment); i++) {
-	    char *pt = strchr(org_buf, comment[i]);
-	    if (pt)
-	      *pt = '\0';
-	  }
-	}
-	/* removing \n at the end of the line */
-	if (strlen(org_buf) > 0 && org_buf[strlen(org_buf)-1] == '\n' )
-	  org_buf[strlen(org_buf)-1] = 0;
-	retval = store(ef, current_group, name, org_buf, line,
-		       current_comment_before_key, current_comment_after_value,
+	/* The line is taken as it is, without comments (not for python
+	   config files). So the cuts done above are reverted. */
+	if (key_end && key_end < org_end)
+	  *key_end = key_end_c;
+	if (comment_start && comment_start < org_end)
+	  *comment_start = comment_start_c;
+	*org_end = '\0';
+	retval = store(ef, &state, current_group, name, buf, line,
 		       false, /* Quotes does not matter in the following lines */
 		       true /* appending entry */);
-	free(current_comment_before_key);
-	current_comment_before_key = NULL;
-	free(current_comment_after_value);
-	current_comment_after_value = NULL;
 	if (retval)
 	  goto out;
 	continue;
@@ -570,7 +934,7 @@ read_file(econf_file *ef, const char *file,
       data = NULL;
     else {
       /* go to the beginning of the value */
-      while (*data && isspace((unsigned)*data))
+      while (cc[(unsigned char) *data] & CC_SPACE)
 	data++;
       if (!has_wsp && !delim_seen) {
 	/*
@@ -578,15 +942,15 @@ read_file(econf_file *ef, const char *file,
 	 * require at least one delimiter, and skip more whitespace
 	 * after it.
 	 */
-	if (!*data || strchr(delim, *data) == NULL) {
+	if (!(cc[(unsigned char) *data] & CC_DELIM)) {
 	  retval = ECONF_MISSING_DELIMITER;
 	  goto out;
 	}
 	data++;
-	while (*data && isspace((unsigned)*data))
+	while (cc[(unsigned char) *data] & CC_SPACE)
 	  data++;
       } else if (has_wsp && has_nonwsp && !delim_seen &&
-		 *data && strchr(delim, *data) != NULL) {
+		 (cc[(unsigned char) *data] & CC_DELIM)) {
 	/*
 	 * If delim contains both whitespace and non-whitespace characters,
 	 * use any combination of one non-whitespace delimiter and
@@ -600,7 +964,7 @@ read_file(econf_file *ef, const char *file,
 	 * key==value -> "=value"
 	 */
 	data++;
-	while (*data && isspace((unsigned)*data))
+	while (cc[(unsigned char) *data] & CC_SPACE)
 	  data++;
       }
       if (*data == '"') {
@@ -609,10 +973,10 @@ read_file(econf_file *ef, const char *file,
       }
 
       /* remove space at the end of the value */
-      p = data + strlen(data);
+      p = cut;
       if (p > data)
 	p--;
-      while (p > data && (isspace((unsigned)*p)))
+      while (p > data && (cc[(unsigned char) *p] & CC_SPACE))
 	p--;
       /* Strip double quotes only if both leading and trailing quotes exist. */
       if (p >= data && quote_seen) {
@@ -625,45 +989,118 @@ read_file(econf_file *ef, const char *file,
 	*(p + 1) = '\0';
     }
 
-    retval = store(ef, current_group, name, data, line,
-		   current_comment_before_key, current_comment_after_value,
+    retval = store(ef, &state, current_group, name, data, line,
 		   quote_seen,
 		   false /* new entry */);
-    free(current_comment_before_key);
-    current_comment_before_key = NULL;
-    free(current_comment_after_value);
-    current_comment_after_value = NULL;
     if (retval)
       goto out;
   }
 
  out:
-  free(buf);
-  fclose (kf);
-  if (current_comment_before_key)
-    free(current_comment_before_key);
-  if (current_comment_after_value)
-    free(current_comment_after_value);
+  free(bits);
+  {
+    econf_err error = close_entry(ef, &state);
+    if (retval == ECONF_SUCCESS)
+      retval = error;
+  }
+  free_parse_state(&state);
 
   if(ef->join_same_entries == true)
   {
-    join_same_entries(ef);
+    econf_err error = join_same_entries(ef);
+    if (retval == ECONF_SUCCESS)
+      retval = error;
   }
 
-  if (retval != ECONF_SUCCESS && retval != ECONF_NOFILE) {
-    free(last_scanned_filename);
-    last_scanned_filename = strdup(file);
-    if (last_scanned_filename == NULL) {
+  if (line > 0)
+    *line_nr = line;
+  return retval;
+}
+
+econf_err
+set_scan_location(econf_ctx *ctx, const char *source, uint64_t line_nr,
+		  econf_err error)
+{
+  ctx->last_scanned_line_nr = line_nr;
+  if (error != ECONF_SUCCESS && error != ECONF_NOFILE) {
+    free(ctx->last_scanned_filename);
+    ctx->last_scanned_filename = NULL;
+    if (source && (ctx->last_scanned_filename = strdup(source)) == NULL) {
        return ECONF_NOMEM;
     }
   }
+  return error;
+}
 
-  return retval;
+econf_err
+read_file_r(econf_file *ef, const char *file, int fd, const struct stat *sb,
+	    const char *delim, const char *comment, uint64_t *line_nr)
+{
+  econf_err error;
+  char *content;
+  size_t length;
+
+  if ((ef->path = strdup (file)) == NULL)
+    return ECONF_NOMEM;
+  if ((error = load_file(&ef->arena, fd, sb, &content, &length)))
+    return error;
+  return parse_content(ef, content, length, delim, comment, line_nr);
+}
+
+econf_err
+parse_file_r(econf_file *ef, const char *file, char *content, size_t length,
+	     const char *delim, const char *comment, uint64_t *line_nr)
+{
+  if ((ef->path = strdup (file)) == NULL)
+    return ECONF_NOMEM;
+  return parse_content(ef, content, length, delim, comment, line_nr);
+}
+
+econf_err
+read_fd(econf_ctx *ctx, econf_file *ef, int fd,
+	const char *delim, const char *comment)
+{
+  econf_err error;
+  char *content;
+  size_t length;
+  uint64_t line_nr = ctx->last_scanned_line_nr;
+
+  if ((error = load_file(&ef->arena, fd, NULL, &content, &length)))
+    return error;
+  error = parse_content(ef, content, length, delim, comment, &line_nr);
+  return set_scan_location(ctx, NULL, line_nr, error);
+}
+
+econf_err
+read_buffer(econf_ctx *ctx, econf_file *ef, const char *data, size_t length,
+	    const char *delim, const char *comment)
+{
+  econf_err error;
+  char *content;
+  uint64_t line_nr = ctx->last_scanned_line_nr;
+
+  if (length == SIZE_MAX ||
+      (content = arena_alloc(&ef->arena, length + 1)) == NULL)
+    return ECONF_NOMEM;
+  if (length)
+    memcpy(content, data, length);
+  content[length] = '\0';
+  error = parse_content(ef, content, length, delim, comment, &line_nr);
+  return set_scan_location(ctx, NULL, line_nr, error);
+}
+
+void last_scanned_file(econf_ctx *ctx, char **filename, uint64_t *line_nr)
+{
+  *line_nr = ctx->last_scanned_line_nr;
+  *filename = ctx->last_scanned_filename;
+  ctx->last_scanned_filename = NULL; /* Freeing is the responsilble of econf_errLocation now */
 }
 
-void last_scanned_file(char **filename, uint64_t *line_nr)
+void free_ctx(econf_ctx *ctx)
 {
-  *line_nr = last_scanned_line_nr;
-  *filename = last_scanned_filename;
-  last_scanned_filename = NULL; /* Freeing is the responsilble of econf_errLocation now */
+  econf_freeArray(ctx->conf_dirs);
+  ctx->conf_dirs = NULL;
+  ctx->conf_count = 0;
+  free(ctx->last_scanned_filename);
+  ctx->last_scanned_filename = NULL;
 }
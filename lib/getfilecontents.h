@@ -26,23 +26,107 @@
 #include "libeconf.h"
 #include "keyfile.h"
 
-extern bool allow_follow_symlinks;
-// Checking file permissions, uid, group,...
-extern bool file_owner_set;
-extern uid_t file_owner;
-extern bool file_group_set;
-extern gid_t file_group;
-extern bool file_permissions_set;
-extern mode_t file_perms_file;
-extern mode_t file_perms_dir;
-
-extern econf_err read_file_with_callback(econf_file **key_file, const char *file_name,
-					    const char *delim, const char *comment,
-					    bool (*callback)(const char *filename, const void *data),
-					    const void *callback_data);
-
-/* Fill the econf_file struct with values from the given file */
-extern econf_err read_file(econf_file *read_file, const char *file,
-			   const char *delim, const char *comment);
-
-extern void last_scanned_file(char **filename, uint64_t *line_nr);
+#include <sys/stat.h>
+
+/* Settings of a parser and the location of its last error, see
+   econf_newCtx. The functions without econf_ctx argument use
+   default_ctx.  */
+struct econf_ctx {
+  // Checking file permissions, uid, group,...
+  bool file_owner_set;
+  uid_t file_owner;
+  bool file_group_set;
+  gid_t file_group;
+  bool file_permissions_set;
+  mode_t file_perms_file;
+  mode_t file_perms_dir;
+  bool allow_follow_symlinks;
+
+  // configuration directories format, see econf_set_conf_dirs
+  char **conf_dirs;
+  int conf_count;
+
+  // info for reporting scan errors (line Nr, filename)
+  uint64_t last_scanned_line_nr;
+  char *last_scanned_filename;
+};
+
+extern econf_ctx default_ctx;
+
+/* Parent directories of the files which have been opened by
+   open_checked. Every directory is opened and checked once, the files
+   in it are opened relative to it. Missing directories are kept with
+   fd -1.  */
+struct dir_cache {
+  struct dir_entry {
+    char *path;
+    int fd;
+    struct stat st;
+  } *entries;
+  size_t count, alloc;
+};
+
+/* econf_err of an open which failed with errno error. Only a missing
+   or inaccessible file is ECONF_NOFILE, running out of file descriptors
+   is an error of its own.  */
+extern econf_err open_error(int error);
+
+/* Close and free the directories of cache */
+extern void free_dir_cache(struct dir_cache *cache);
+
+/* Read file_name into key_file after the checks of open_checked. dirs
+   may be NULL.  */
+extern econf_err read_file_with_callback(econf_ctx *ctx, struct dir_cache *dirs,
+					 econf_file **key_file,
+					 const char *file_name,
+					 const char *delim, const char *comment,
+					 bool (*callback)(const char *filename, const void *data),
+					 const void *callback_data);
+
+/* Open file_name for reading and run the security checks of ctx on the
+   opened file with fstat, so the checked file is the one which is read.
+   Sym links are not followed if ctx does not allow it. The file is
+   opened relative to its parent directory, which is taken from dirs and
+   opened and checked there at the first time. dirs may be NULL. At last
+   the user defined callback is called for file_name. On success fd is
+   the opened file and sb its status.  */
+extern econf_err open_checked(const econf_ctx *ctx, struct dir_cache *dirs,
+			      const char *file_name,
+			      bool (*callback)(const char *filename, const void *data),
+			      const void *callback_data, int *fd, struct stat *sb);
+
+/* Fill the econf_file struct with values from fd, which has been opened
+   by open_checked for file. The number of the last scanned line is
+   returned in line_nr instead of being stored for econf_errLocation, so
+   different files can be read by several threads at once.  */
+extern econf_err read_file_r(econf_file *read_file, const char *file,
+			     int fd, const struct stat *sb,
+			     const char *delim, const char *comment,
+			     uint64_t *line_nr);
+
+/* Same as read_file_r for a file which has already been loaded into
+   content, which is part of the arena of read_file and null terminated.  */
+extern econf_err parse_file_r(econf_file *read_file, const char *file,
+			      char *content, size_t length,
+			      const char *delim, const char *comment,
+			      uint64_t *line_nr);
+
+/* Store the location of error in ctx for econf_errLocation. source can
+   be NULL. Returns error or ECONF_NOMEM.  */
+extern econf_err set_scan_location(econf_ctx *ctx, const char *source,
+				   uint64_t line_nr, econf_err error);
+
+/* Fill the econf_file struct with values read from fd until end of file */
+extern econf_err read_fd(econf_ctx *ctx, econf_file *read_file, int fd,
+			 const char *delim, const char *comment);
+
+/* Fill the econf_file struct with values from length bytes of data */
+extern econf_err read_buffer(econf_ctx *ctx, econf_file *read_file,
+			     const char *data, size_t length,
+			     const char *delim, const char *comment);
+
+/* Location of the last error of ctx. The caller frees filename.  */
+extern void last_scanned_file(econf_ctx *ctx, char **filename, uint64_t *line_nr);
+
+/* Free the settings and the error location of ctx, not ctx itself */
+extern void free_ctx(econf_ctx *ctx);
@@ -0,0 +1,122 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "libeconf.h"
+#include "hashtable.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Size of a new table. Tables are never filled more than half, so
+   probe sequences stay short. */
+#define HASH_MIN_SIZE 16
+
+// Spread the bits of the hash value. String hashes like djb2 have weak
+// low bits which would be the only ones used for the slot number.
+static size_t
+mix(size_t hash)
+{
+  uint64_t h = hash;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (size_t) h;
+}
+
+static void
+put(struct hash_slot *slots, size_t size, size_t hash, size_t value)
+{
+  size_t pos = mix(hash) & (size - 1);
+  while (slots[pos].value != HASH_EMPTY)
+    pos = (pos + 1) & (size - 1);
+  slots[pos].hash = hash;
+  slots[pos].value = value;
+}
+
+static econf_err
+resize(econf_hashtable *ht, size_t size)
+{
+  struct hash_slot *slots = malloc(size * sizeof(struct hash_slot));
+  if (slots == NULL)
+    return ECONF_NOMEM;
+  for (size_t i = 0; i < size; i++)
+    slots[i].value = HASH_EMPTY;
+  for (size_t i = 0; i < ht->size; i++)
+    if (ht->slots[i].value != HASH_EMPTY)
+      put(slots, size, ht->slots[i].hash, ht->slots[i].value);
+  free(ht->slots);
+  ht->slots = slots;
+  ht->size = size;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+hash_reserve(econf_hashtable *ht, size_t count)
+{
+  size_t size = ht->size ? ht->size : HASH_MIN_SIZE;
+  while (size / 2 < count)
+    size *= 2;
+  if (size == ht->size)
+    return ECONF_SUCCESS;
+  return resize(ht, size);
+}
+
+econf_err
+hash_insert(econf_hashtable *ht, size_t hash, size_t value)
+{
+  econf_err error;
+  if ((error = hash_reserve(ht, ht->used + 1)))
+    return error;
+  put(ht->slots, ht->size, hash, value);
+  ht->used++;
+  return ECONF_SUCCESS;
+}
+
+size_t
+hash_next(const econf_hashtable *ht, size_t hash, size_t *pos)
+{
+  while (ht->slots[*pos].value != HASH_EMPTY) {
+    size_t cur = *pos;
+    *pos = (*pos + 1) & (ht->size - 1);
+    if (ht->slots[cur].hash == hash)
+      return ht->slots[cur].value;
+  }
+  return HASH_EMPTY;
+}
+
+size_t
+hash_first(const econf_hashtable *ht, size_t hash, size_t *pos)
+{
+  if (ht->size == 0)
+    return HASH_EMPTY;
+  *pos = mix(hash) & (ht->size - 1);
+  return hash_next(ht, hash, pos);
+}
+
+void
+hash_free(econf_hashtable *ht)
+{
+  free(ht->slots);
+  ht->slots = NULL;
+  ht->size = ht->used = 0;
+}
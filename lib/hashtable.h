@@ -0,0 +1,68 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+/* --- hashtable.h --- */
+
+#include "libeconf.h"
+
+#include <stddef.h>
+
+/* Open addressing hash table which maps a hash value to an index
+   (e.g. the number of a file_entry). The table does not know anything
+   about the indexed objects, so the caller has to compare the candidates
+   returned for a hash value with the object it is looking for.
+
+   Usage:
+     size_t pos;
+     for (size_t n = hash_first(ht, hash, &pos); n != HASH_EMPTY;
+          n = hash_next(ht, hash, &pos))
+       if (<object n matches>)
+         return n;
+*/
+
+/* Value of an unused slot. */
+#define HASH_EMPTY ((size_t) -1)
+
+typedef struct econf_hashtable {
+  struct hash_slot {
+    size_t hash;
+    size_t value;
+  } *slots;
+  /* Number of slots (power of two or 0) and number of used slots. */
+  size_t size, used;
+} econf_hashtable;
+
+/* Make sure that count values can be stored without resizing the table */
+econf_err hash_reserve(econf_hashtable *ht, size_t count);
+
+/* Add value with the given hash. The table does not check for
+   duplicates and does not keep the order of insertion.  */
+econf_err hash_insert(econf_hashtable *ht, size_t hash, size_t value);
+
+/* Return the first/next value stored with the given hash or HASH_EMPTY. */
+size_t hash_first(const econf_hashtable *ht, size_t hash, size_t *pos);
+size_t hash_next(const econf_hashtable *ht, size_t hash, size_t *pos);
+
+/* Remove all values and free the slots. */
+void hash_free(econf_hashtable *ht);
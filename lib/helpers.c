@@ -24,6 +24,7 @@
 #include "libeconf.h"
 #include "defines.h"
 #include "helpers.h"
+#include "snapshot.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -42,9 +43,10 @@ char *combine_strings(const char *string_one, const char *string_two,
 
 // Set null value defined in include/defines.h
 void initialize(econf_file *key_file, size_t num) {
-  key_file->file_entry[num].group = setGroupList(key_file, KEY_FILE_NULL_VALUE);
-  key_file->file_entry[num].key = strdup(KEY_FILE_NULL_VALUE);
-  key_file->file_entry[num].value = strdup(KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].group = setGroupList(key_file, KEY_FILE_NULL_VALUE,
+						 &key_file->file_entry[num].group_id);
+  key_file->file_entry[num].key = arena_strdup(&key_file->arena, KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].value = arena_strdup(&key_file->arena, KEY_FILE_NULL_VALUE);
   key_file->file_entry[num].comment_before_key = NULL;
   key_file->file_entry[num].comment_after_value = NULL;
   key_file->file_entry[num].quotes = false;
@@ -120,28 +122,126 @@ size_t hashstring(const char *string) {
   return hash;
 }
 
-// Look for matching key
-econf_err find_key(econf_file key_file, const char *group, const char *key, size_t *num) {
-	char *grp = (!group || !*group) ? strdup(KEY_FILE_NULL_VALUE) : strdup(group);
-  if (grp == NULL)
-    return  ECONF_NOMEM;
-  if (!key || !*key) {
-    free(grp);
-    return ECONF_ERROR;
+// Hash value of a group name. The name does not have to be null terminated.
+static size_t
+group_hash(const char *group, size_t group_len)
+{
+  size_t hash = 5381;
+  for (size_t i = 0; i < group_len; i++)
+    hash = ((hash << 5) + hash) + (unsigned char) group[i];
+  return hash;
+}
+
+// Look for the number of the given group in the group index.
+static bool
+lookup_group(const econf_file *key_file, size_t hash,
+	     const char *group, size_t group_len, size_t *id)
+{
+  size_t pos;
+  for (size_t n = hash_first(&key_file->group_index, hash, &pos); n != HASH_EMPTY;
+       n = hash_next(&key_file->group_index, hash, &pos)) {
+    const char *name = key_file->groups[n];
+    if (!strncmp(name, group, group_len) && name[group_len] == '\0') {
+      *id = n;
+      return true;
+    }
   }
-  for (size_t i = 0; i < key_file.length; i++) {
-    if (!strcmp(key_file.file_entry[i].group, grp) &&
-        !strcmp(key_file.file_entry[i].key, key)) {
-      free(grp);
-      *num = i;
+  return false;
+}
+
+// Hash value of the group/key combination used in the key index
+static size_t
+key_hash(size_t group_id, const char *key)
+{
+  size_t hash = 5381 + group_id;
+  while (*key)
+    hash = ((hash << 5) + hash) + (unsigned char) *key++;
+  return hash;
+}
+
+// Look for the first entry with the given group/key in the key index.
+static econf_err
+lookup_key(const econf_file *key_file, size_t group_id, const char *key, size_t *num)
+{
+  size_t hash = key_hash(group_id, key), pos;
+  for (size_t n = hash_first(&key_file->key_index, hash, &pos); n != HASH_EMPTY;
+       n = hash_next(&key_file->key_index, hash, &pos)) {
+    const struct file_entry *fe = &key_file->file_entry[n];
+    if (fe->group_id == group_id && !strcmp(fe->key, key)) {
+      *num = n;
       return ECONF_SUCCESS;
     }
   }
-  // Key not found
-  free(grp);
   return ECONF_NOKEY;
 }
 
+// Look for matching key
+econf_err find_key(econf_file key_file, const char *group, const char *key, size_t *num) {
+  size_t group_id;
+  if (!group || !*group)
+    group = KEY_FILE_NULL_VALUE;
+  if (!key || !*key)
+    return ECONF_ERROR;
+  size_t group_len = strlen(group);
+  if (key_file.snapshot)
+    return snapshot_find_key(&key_file, group, group_len, key, num);
+  if (!lookup_group(&key_file, group_hash(group, group_len), group, group_len, &group_id))
+    return ECONF_NOKEY;
+  return lookup_key(&key_file, group_id, key, num);
+}
+
+// Look for matching key, group can be enclosed in brackets
+econf_err find_bracketed_key(econf_file key_file, const char *group, const char *key,
+			     size_t *num) {
+  size_t group_len = group ? strlen(group) : 0;
+  if (group_len && *group == '[' && group[group_len - 1] == ']') {
+    // same as stripbrackets: take everything up to the first ']'
+    group++;
+    group_len = strchr(group, ']') - group;
+  }
+  if (!group_len) {
+    group = KEY_FILE_NULL_VALUE;
+    group_len = strlen(group);
+  }
+  if (!key || !*key)
+    return ECONF_ERROR;
+  if (key_file.snapshot)
+    return snapshot_find_key(&key_file, group, group_len, key, num);
+  size_t group_id;
+  if (!lookup_group(&key_file, group_hash(group, group_len), group, group_len, &group_id))
+    return ECONF_NOKEY;
+  return lookup_key(&key_file, group_id, key, num);
+}
+
+econf_err find_group_key(const econf_file *key_file, size_t group_id, const char *key,
+			 size_t *num) {
+  if (!key || !*key)
+    return ECONF_ERROR;
+  return lookup_key(key_file, group_id, key, num);
+}
+
+econf_err key_index_add(econf_file *key_file, size_t num) {
+  struct file_entry *fe = &key_file->file_entry[num];
+  size_t found;
+  if (fe->group == NULL || fe->key == NULL)
+    return ECONF_ERROR;
+  if (lookup_key(key_file, fe->group_id, fe->key, &found) == ECONF_SUCCESS)
+    return ECONF_SUCCESS;  // the first entry wins
+  return hash_insert(&key_file->key_index, key_hash(fe->group_id, fe->key), num);
+}
+
+econf_err key_index_rebuild(econf_file *key_file) {
+  econf_err error;
+  hash_free(&key_file->key_index);
+  if ((error = hash_reserve(&key_file->key_index, key_file->length)))
+    return error;
+  for (size_t i = 0; i < key_file->length; i++) {
+    if ((error = key_index_add(key_file, i)))
+      return error;
+  }
+  return ECONF_SUCCESS;
+}
+
 // Append a new key to an existing econf_file
 // TODO: If the group is already known the new key should be appended
 // at the end of that group not at the end of the file.
@@ -165,7 +265,9 @@ new_key (econf_file *key_file, const char *group, const char *key) {
     return error;
   }
   free(grp);
-  return setKey(key_file, key_file->length - 1, key);
+  if ((error = setKey(key_file, key_file->length - 1, key)))
+    return error;
+  return key_index_add(key_file, key_file->length - 1);
 }
 
 // Set value for the given group, key combination. If the combination
@@ -177,7 +279,10 @@ econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
 		      const void *value)
 {
   size_t num;
-  econf_err error = find_key(*kf, group, key, &num);
+  econf_err error = snapshot_materialize(kf);
+  if (error)
+    return error;
+  error = find_key(*kf, group, key, &num);
   if (error) {
     if (error != ECONF_NOKEY) {
       return error;
@@ -192,18 +297,18 @@ econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
 
 struct file_entry cpy_file_entry(econf_file *dest_kf, struct file_entry fe) {
   struct file_entry copied_fe;
-  copied_fe.group = setGroupList(dest_kf, fe.group);
-  copied_fe.key = strdup(fe.key);
+  copied_fe.group = setGroupList(dest_kf, fe.group, &copied_fe.group_id);
+  copied_fe.key = arena_strdup(&dest_kf->arena, fe.key);
   if (fe.value)
-    copied_fe.value = strdup(fe.value);
+    copied_fe.value = arena_strdup(&dest_kf->arena, fe.value);
   else
     copied_fe.value = NULL;
   if (fe.comment_before_key)
-    copied_fe.comment_before_key = strdup(fe.comment_before_key);
+    copied_fe.comment_before_key = arena_strdup(&dest_kf->arena, fe.comment_before_key);
   else
     copied_fe.comment_before_key = NULL;
   if (fe.comment_after_value)
-    copied_fe.comment_after_value = strdup(fe.comment_after_value);
+    copied_fe.comment_after_value = arena_strdup(&dest_kf->arena, fe.comment_after_value);
   else
     copied_fe.comment_after_value = NULL;  
   copied_fe.line_number = fe.line_number;
@@ -211,31 +316,42 @@ struct file_entry cpy_file_entry(econf_file *dest_kf, struct file_entry fe) {
   return copied_fe;
 }
 
-/* Handle groups in an string array */
-char *getFromGroupList(econf_file *key_file, const char *name) {
-  char *ret = NULL;
-  for (int i = 0; i < key_file->group_count; i++) {
-    if (!strcmp(key_file->groups[i], name)) {
-      ret = key_file->groups[i];
-      i = key_file->group_count;
-    }
-  }
-  return ret;
+/* Handle the list of group names */
+char *getFromGroupList(econf_file *key_file, const char *name, size_t *id) {
+  size_t len = strlen(name), n;
+  if (!lookup_group(key_file, group_hash(name, len), name, len, &n))
+    return NULL;
+  if (id)
+    *id = n;
+  return key_file->groups[n];
 }
 
-char *setGroupList(econf_file *key_file, const char *name) {
-  char *ret = getFromGroupList(key_file, name);
-  if (ret != NULL)
-    return ret;
-  key_file->group_count++;
-  key_file->groups =
-    realloc(key_file->groups, (key_file->group_count +1) * sizeof(char *));
-  if (key_file->groups == NULL) {
-    key_file->group_count--;
-  } else {
-    key_file->groups[key_file->group_count] = NULL;
-    key_file->groups[key_file->group_count-1] = strdup(name);
-    ret = key_file->groups[key_file->group_count-1];
+char *setGroupList(econf_file *key_file, const char *name, size_t *id) {
+  size_t len = strlen(name), hash = group_hash(name, len), n;
+  if (lookup_group(key_file, hash, name, len, &n)) {
+    if (id)
+      *id = n;
+    return key_file->groups[n];
+  }
+  // groups is kept null terminated
+  if (key_file->group_count + 2 > key_file->group_alloc) {
+    size_t alloc = key_file->group_alloc ? key_file->group_alloc * 2 : 8;
+    char **groups = realloc(key_file->groups, alloc * sizeof(char *));
+    if (groups == NULL)
+      return NULL;
+    key_file->groups = groups;
+    key_file->group_alloc = alloc;
   }
-  return ret;
+  char *group = arena_strndup(&key_file->arena, name, len);
+  if (group == NULL)
+    return NULL;
+  n = key_file->group_count;
+  if (hash_insert(&key_file->group_index, hash, n))
+    return NULL;
+  key_file->groups[n] = group;
+  key_file->groups[n + 1] = NULL;
+  key_file->group_count++;
+  if (id)
+    *id = n;
+  return group;
 }
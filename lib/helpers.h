@@ -62,6 +62,23 @@ size_t hashstring(const char *str);
    the key, if not it will point to -1.  */
 econf_err find_key(econf_file key_file, const char *group, const char *key, size_t *num);
 
+/* Same as find_key, but the group name can be enclosed in '[' and ']'
+   which will be ignored like in stripbrackets. No memory is allocated.  */
+econf_err find_bracketed_key(econf_file key_file, const char *group, const char *key,
+			     size_t *num);
+
+/* Same as find_key, but the group is given by its number in groups.  */
+econf_err find_group_key(const econf_file *key_file, size_t group_id, const char *key,
+			 size_t *num);
+
+/* Add the file_entry number num to the key index if there is no entry
+   with the same group/key combination before. Has to be called whenever
+   a new entry has been added to the econf_file.  */
+econf_err key_index_add(econf_file *key_file, size_t num);
+
+/* Recreate the key index for all entries of the econf_file.  */
+econf_err key_index_rebuild(econf_file *key_file);
+
 /* Set value for the given group, key combination. If the combination
    does not exist it is created.  */
 econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
@@ -72,6 +89,10 @@ econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
 /* dest_kf contains the list of group names */
 struct file_entry cpy_file_entry(econf_file *dest_kf, struct file_entry fe);
 
-/* Handle groups in an string array */
-char *getFromGroupList(econf_file *key_file, const char *name);
-char *setGroupList(econf_file *key_file, const char *name);
+/* Handle the list of group names */
+/* Return the stored name of the group and its number in id (if id is not
+   NULL). Returns NULL if the group is unknown.  */
+char *getFromGroupList(econf_file *key_file, const char *name, size_t *id);
+/* Same as getFromGroupList but unknown groups are added.
+   Returns NULL if there is not enough memory.  */
+char *setGroupList(econf_file *key_file, const char *name, size_t *id);
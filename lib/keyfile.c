@@ -25,6 +25,7 @@
 #include "defines.h"
 #include "helpers.h"
 #include "keyfile.h"
+#include "snapshot.h"
 
 #include <errno.h>
 #include <float.h>
@@ -54,27 +55,61 @@ void print_key_file(const econf_file key_file)
 }
 
 
+econf_err key_file_reserve(econf_file *kf, size_t count) {
+  if (kf == NULL)
+    return ECONF_ERROR;
+  if (count <= kf->alloc_length)
+    return ECONF_SUCCESS;
+  size_t new_length = kf->alloc_length < KEY_FILE_DEFAULT_LENGTH ?
+    KEY_FILE_DEFAULT_LENGTH : kf->alloc_length * 2;
+  if (new_length < count)
+    new_length = count;
+  if (new_length > SIZE_MAX / sizeof(struct file_entry))
+    return ECONF_NOMEM;
+  struct file_entry *tmp =
+    realloc(kf->file_entry, new_length * sizeof(struct file_entry));
+  if (tmp == NULL)
+    return ECONF_NOMEM;
+  // Unused elements are zeroed so that key_file_append can see that
+  // they still have to be initialized.
+  memset(tmp + kf->alloc_length, 0,
+	 (new_length - kf->alloc_length) * sizeof(struct file_entry));
+  kf->file_entry = tmp;
+  kf->alloc_length = new_length;
+  return ECONF_SUCCESS;
+}
+
 econf_err key_file_append(econf_file *kf) {
+  econf_err error;
   if (kf == NULL)
     return ECONF_ERROR;
-  if(kf->length++ >= kf->alloc_length) {
-    kf->alloc_length++;
-    kf->file_entry =
-      realloc(kf->file_entry, (kf->alloc_length) * sizeof(struct file_entry));
-    if (kf->file_entry == NULL)
-      return ECONF_NOMEM;
-    initialize(kf, kf->alloc_length - 1);
-  }
+  if ((error = key_file_reserve(kf, kf->length + 1)))
+    return error;
+  // Elements allocated by econf_newKeyFile are already initialized.
+  if (kf->file_entry[kf->length].key == NULL)
+    initialize(kf, kf->length);
+  kf->length++;
   return ECONF_SUCCESS;
 }
 
 /* --- GETTERS --- */
 
+/* Value of entry num. The entries of a mapped snapshot are read from
+   the mapping.  */
+static const char *
+entry_value(const econf_file *kf, size_t num)
+{
+  if (kf->snapshot)
+    return snapshot_string(kf, snapshot_entry(kf, num)->value);
+  return kf->file_entry[num].value;
+}
+
 econf_err getIntValueNum(econf_file key_file, size_t num, int32_t *result) {
   char *endptr;
   errno = 0;
-  *result = strtol(key_file.file_entry[num].value, &endptr, 0);
-  if (endptr == key_file.file_entry[num].value || errno == ERANGE || (errno != 0 && *result == 0))
+  const char *value = entry_value(&key_file, num);
+  *result = strtol(value, &endptr, 0);
+  if (endptr == value || errno == ERANGE || (errno != 0 && *result == 0))
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
@@ -82,8 +117,9 @@ econf_err getIntValueNum(econf_file key_file, size_t num, int32_t *result) {
 econf_err getInt64ValueNum(econf_file key_file, size_t num, int64_t *result) {
   char *endptr;
   errno = 0;
-  *result = strtoll(key_file.file_entry[num].value, &endptr, 0);
-  if (endptr == key_file.file_entry[num].value || errno == ERANGE || (errno != 0 && *result == 0))
+  const char *value = entry_value(&key_file, num);
+  *result = strtoll(value, &endptr, 0);
+  if (endptr == value || errno == ERANGE || (errno != 0 && *result == 0))
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
@@ -91,8 +127,9 @@ econf_err getInt64ValueNum(econf_file key_file, size_t num, int64_t *result) {
 econf_err getUIntValueNum(econf_file key_file, size_t num, uint32_t *result) {
   char *endptr;
   errno = 0;
-  *result = strtoul(key_file.file_entry[num].value, &endptr, 0);
-  if (endptr == key_file.file_entry[num].value || errno == ERANGE || (errno != 0 && *result == 0))
+  const char *value = entry_value(&key_file, num);
+  *result = strtoul(value, &endptr, 0);
+  if (endptr == value || errno == ERANGE || (errno != 0 && *result == 0))
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
@@ -100,8 +137,9 @@ econf_err getUIntValueNum(econf_file key_file, size_t num, uint32_t *result) {
 econf_err getUInt64ValueNum(econf_file key_file, size_t num, uint64_t *result) {
   char *endptr;
   errno = 0;
-  *result = strtoull(key_file.file_entry[num].value, &endptr, 0);
-  if (endptr == key_file.file_entry[num].value || errno == ERANGE || (errno != 0 && *result == 0))
+  const char *value = entry_value(&key_file, num);
+  *result = strtoull(value, &endptr, 0);
+  if (endptr == value || errno == ERANGE || (errno != 0 && *result == 0))
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
@@ -109,8 +147,9 @@ econf_err getUInt64ValueNum(econf_file key_file, size_t num, uint64_t *result) {
 econf_err getFloatValueNum(econf_file key_file, size_t num, float *result) {
   char *endptr;
   errno = 0;
-  *result = strtof(key_file.file_entry[num].value, &endptr);
-  if (endptr == key_file.file_entry[num].value) /* do not check errno because it is a false alarm in ppc and S390 */
+  const char *value = entry_value(&key_file, num);
+  *result = strtof(value, &endptr);
+  if (endptr == value) /* do not check errno because it is a false alarm in ppc and S390 */
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
@@ -118,16 +157,18 @@ econf_err getFloatValueNum(econf_file key_file, size_t num, float *result) {
 econf_err getDoubleValueNum(econf_file key_file, size_t num, double *result) {
   char *endptr;
   errno = 0;
-  *result = strtod(key_file.file_entry[num].value, &endptr);
-  if (endptr == key_file.file_entry[num].value || errno == ERANGE || (errno != 0 && *result == 0))
+  const char *value = entry_value(&key_file, num);
+  *result = strtod(value, &endptr);
+  if (endptr == value || errno == ERANGE || (errno != 0 && *result == 0))
     return ECONF_VALUE_CONVERSION_ERROR;
   return ECONF_SUCCESS;
 }
 
 econf_err getStringValueNum(econf_file key_file, size_t num, char **result) {
-  if (key_file.file_entry[num].value)
+  const char *value = entry_value(&key_file, num);
+  if (value)
   {
-    *result = strdup(key_file.file_entry[num].value);
+    *result = strdup(value);
     if (*result == NULL)
       return ECONF_NOMEM;
   } else {
@@ -139,9 +180,9 @@ econf_err getStringValueNum(econf_file key_file, size_t num, char **result) {
 
 econf_err getBoolValueNum(econf_file key_file, size_t num, bool *result) {
   char *value, *tmp;
-  tmp = strdup(key_file.file_entry[num].value);
+  tmp = strdup(entry_value(&key_file, num));
   value = toLowerCase(tmp);
-  size_t hash = hashstring(toLowerCase(key_file.file_entry[num].value));
+  size_t hash = hashstring(value);
   econf_err err = ECONF_SUCCESS;
 
   if ((*value == '1' && strlen(tmp) == 1) || hash == YES || hash == TRUE)
@@ -161,13 +202,24 @@ econf_err getBoolValueNum(econf_file key_file, size_t num, bool *result) {
 econf_err getCommentsNum(econf_file key_file, size_t num,
 			 char **comment_before_key,
 			 char **comment_after_value) {
-  if (key_file.file_entry[num].comment_before_key)
-    *comment_before_key = strdup(key_file.file_entry[num].comment_before_key);
+  const char *before, *after;
+
+  if (key_file.snapshot) {
+    const struct snapshot_entry *se = snapshot_entry(&key_file, num);
+    before = snapshot_string(&key_file, se->comment_before_key);
+    after = snapshot_string(&key_file, se->comment_after_value);
+  } else {
+    before = key_file.file_entry[num].comment_before_key;
+    after = key_file.file_entry[num].comment_after_value;
+  }
+
+  if (before)
+    *comment_before_key = strdup(before);
   else
     *comment_before_key = NULL;
 
-  if (key_file.file_entry[num].comment_after_value)
-    *comment_after_value = strdup(key_file.file_entry[num].comment_after_value);
+  if (after)
+    *comment_after_value = strdup(after);
   else
     *comment_after_value = NULL;
 
@@ -175,7 +227,10 @@ econf_err getCommentsNum(econf_file key_file, size_t num,
 }
 
 econf_err getLineNrNum(econf_file key_file, size_t num, uint64_t *line_nr) {
-  *line_nr = key_file.file_entry[num].line_number;
+  if (key_file.snapshot)
+    *line_nr = snapshot_entry(&key_file, num)->line_number;
+  else
+    *line_nr = key_file.file_entry[num].line_number;
 
   return ECONF_SUCCESS;
 }
@@ -197,7 +252,8 @@ econf_err setGroup(econf_file *key_file, size_t num, const char *value) {
   if (key_file == NULL || value == NULL)
     return ECONF_ERROR;
 
-  key_file->file_entry[num].group = setGroupList(key_file, value);
+  key_file->file_entry[num].group = setGroupList(key_file, value,
+						 &key_file->file_entry[num].group_id);
   if (key_file->file_entry[num].group == NULL)
     return ECONF_NOMEM;
 
@@ -207,25 +263,27 @@ econf_err setGroup(econf_file *key_file, size_t num, const char *value) {
 econf_err setKey(econf_file *key_file, size_t num, const char *value) {
   if (key_file == NULL || value == NULL)
     return ECONF_ERROR;
-  if (key_file->file_entry[num].key)
-    free(key_file->file_entry[num].key);
-  key_file->file_entry[num].key = strdup(value);
+  key_file->file_entry[num].key =
+    arena_replace(&key_file->arena, key_file->file_entry[num].key, value);
   if (key_file->file_entry[num].key == NULL)
     return ECONF_NOMEM;
 
   return ECONF_SUCCESS;
 }
 
+/* Large enough for every number printed by econf_setValueNum */
+#define NUMBER_BUFSIZ 64
+
 #define econf_setValueNum(FCT_TYPE, TYPE, FMT, PR)			\
 econf_err set ## FCT_TYPE ## ValueNum(econf_file *ef, size_t num, const void *v) { \
   const TYPE *value = (const TYPE*) v; \
+  char buf[NUMBER_BUFSIZ]; \
   char *ptr; \
 \
-  if (asprintf (&ptr, FMT PR, *value) == -1) \
+  snprintf (buf, sizeof(buf), FMT PR, *value); \
+  ptr = arena_replace(&ef->arena, ef->file_entry[num].value, buf); \
+  if (ptr == NULL) \
     return ECONF_NOMEM; \
-\
-  if (ef->file_entry[num].value) \
-    free(ef->file_entry[num].value); \
 \
   ef->file_entry[num].value = ptr; \
 \
@@ -245,12 +303,9 @@ econf_err setStringValueNum(econf_file *ef, size_t num, const void *v) {
   const char *value = (const char*) (v ? v : "");
   char *ptr;
 
-  if ((ptr = strdup (value)) == NULL)
+  if ((ptr = arena_replace(&ef->arena, ef->file_entry[num].value, value)) == NULL)
     return ECONF_NOMEM;
 
-  if (ef->file_entry[num].value)
-    free(ef->file_entry[num].value);
-
   ef->file_entry[num].value = ptr;
 
   return ECONF_SUCCESS;
@@ -263,15 +318,15 @@ econf_err setBoolValueNum(econf_file *kf, size_t num, const void *v) {
   size_t hash = hashstring(toLowerCase(tmp));
 
   if ((*value == '1' && strlen(tmp) == 1) || hash == YES || hash == TRUE) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup("true");
+    kf->file_entry[num].value =
+      arena_replace(&kf->arena, kf->file_entry[num].value, "true");
   } else if ((*value == '0' && strlen(tmp) == 1) ||
              hash == NO || hash == FALSE) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup("false");
+    kf->file_entry[num].value =
+      arena_replace(&kf->arena, kf->file_entry[num].value, "false");
   } else if (hash == KEY_FILE_NULL_VALUE_HASH || strlen(value) == 0) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup(KEY_FILE_NULL_VALUE);
+    kf->file_entry[num].value =
+      arena_replace(&kf->arena, kf->file_entry[num].value, KEY_FILE_NULL_VALUE);
   } else { error = ECONF_WRONG_BOOLEAN_VALUE; }
 
   free(tmp);
@@ -281,11 +336,10 @@ econf_err setBoolValueNum(econf_file *kf, size_t num, const void *v) {
 econf_err setCommentsNum(econf_file *key_file, size_t num,
 			 const char *comment_before_key,
 			 const char *comment_after_value) {
-  free(key_file->file_entry[num].comment_before_key);
-  free(key_file->file_entry[num].comment_after_value);
-
   if (comment_before_key != NULL) {
-     key_file->file_entry[num].comment_before_key = strdup( comment_before_key );
+     key_file->file_entry[num].comment_before_key =
+       arena_replace(&key_file->arena, key_file->file_entry[num].comment_before_key,
+		     comment_before_key);
      if (key_file->file_entry[num].comment_before_key == NULL )
          return ECONF_NOMEM;
   } else {
@@ -293,7 +347,9 @@ econf_err setCommentsNum(econf_file *key_file, size_t num,
   }
 
   if (comment_after_value != NULL) {
-     key_file->file_entry[num].comment_after_value = strdup( comment_after_value );
+     key_file->file_entry[num].comment_after_value =
+       arena_replace(&key_file->arena, key_file->file_entry[num].comment_after_value,
+		     comment_after_value);
      if (key_file->file_entry[num].comment_after_value == NULL )
          return ECONF_NOMEM;
   } else {
@@ -25,10 +25,15 @@
 
 /* --- keyfile.h --- */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "arena.h"
+#include "hashtable.h"
+#include "statvec.h"
+
 /* This file contains the definition of the econf_file struct declared in
    libeconf.h as well as the functions to get and set a specified element
    of the struct. All functions return an error code != 0 on error defined
@@ -39,9 +44,12 @@
 typedef struct econf_file {
   /* The file_entry struct contains the group, key and value of every
      key/value entry found in a config file or set via the set functions. If no
-     group is found or provided the group is set to KEY_FILE_NULL_VALUE.  */
+     group is found or provided the group is set to KEY_FILE_NULL_VALUE.
+     group_id is the number of the group in groups.
+     All strings are allocated in arena.  */
   struct file_entry {
     char *group, *key, *value;
+    size_t group_id;
     char *comment_before_key, *comment_after_value;
     uint64_t line_number;
     bool quotes; /*Value is enclosed by quotes*/
@@ -59,6 +67,14 @@ typedef struct econf_file {
   bool on_merge_delete;
   char *path;
 
+  /* Paths of the files which have been merged by econf_readConfig,
+     null terminated. NULL if the entries come from path only.  */
+  char **sources;
+
+  /* Files and directories which have been consulted by econf_readConfig
+     with their identity at that time, see econf_isStale.  */
+  econf_statvec stats;
+
   /* General options */
 
   /* Parsed entries with the same name will not be replaces but */
@@ -69,6 +85,10 @@ typedef struct econf_file {
   /* e.b. Identations will be handled like multiline entries. */
   bool python_style;
 
+  /* Number of threads which parse the drop-in files of econf_readConfig. */
+  /* 1 parses them one after another, 0 uses all online CPUs. */
+  int parse_threads;
+
   /* List of directories from which the configuration files have to be parsed. */
   /* The last entry has the highest priority. */
   char **parse_dirs;
@@ -78,17 +98,40 @@ typedef struct econf_file {
   char **conf_dirs;
   int conf_count;
 
-  // groups
+  // Names of all groups in the order in which they have been added.
+  // group_index maps the name to the number in groups. See setGroupList.
   char **groups;
-  int group_count;
+  size_t group_count, group_alloc;
+  econf_hashtable group_index;
 
   // root prefix, added to /etc, /usr, /run, ...
   char *root_prefix;
 
+  // Owner of all group, key, value and comment strings
+  econf_arena arena;
+
+  // Maps every group/key combination to the number of the first
+  // file_entry with this combination. See find_key.
+  econf_hashtable key_index;
+
+  // Read-only mapping of a snapshot opened by econf_openSnapshot.
+  // If it is set, the entries are not part of file_entry, see snapshot.h.
+  const void *snapshot;
+  size_t snapshot_size;
+
+  // References to a configuration published by an econf_handle, held
+  // by the handle and by the readers. See handle_acquire.
+  atomic_size_t handle_refs;
+
 } econf_file;
 
-/* Increases both length and alloc_length of key_file by one and initializes
-   new elements of struct file_entry.  */
+/* Makes sure that at least count elements of struct file_entry are
+   allocated. alloc_length grows geometrically, so appending single
+   elements is amortized O(1). New elements are zeroed.  */
+econf_err key_file_reserve(econf_file *key_file, size_t count);
+
+/* Increases length of key_file by one and initializes the new element
+   of struct file_entry. alloc_length is increased if needed.  */
 econf_err key_file_append(econf_file *key_file);
 
 /* GETTERS */
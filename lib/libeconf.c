@@ -29,71 +29,139 @@
 #include "keyfile.h"
 #include "mergefiles.h"
 #include "readconfig.h"
+#include "snapshot.h"
+#include "watch.h"
 
 #include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #define PARSING_DIRS "PARSING_DIRS="
 #define CONFIG_DIRS "CONFIG_DIRS="
 #define ROOT_PREFIX "ROOT_PREFIX="
+#define PARSING_THREADS "PARSING_THREADS="
 
-// configuration directories format
-static char **conf_dirs = {NULL}; // see econf_set_conf_dirs
-static int conf_count = 0;
+econf_err econf_newCtx(econf_ctx **ctx)
+{
+  if (ctx == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  if ((*ctx = calloc(1, sizeof(econf_ctx))) == NULL)
+    return ECONF_NOMEM;
+  (*ctx)->allow_follow_symlinks = true;
+  return ECONF_SUCCESS;
+}
+
+econf_ctx *econf_freeCtx(econf_ctx *ctx)
+{
+  if (ctx == NULL)
+    return NULL;
+  free_ctx(ctx);
+  free(ctx);
+  return NULL;
+}
+
+void econf_ctxRequireOwner(econf_ctx *ctx, uid_t owner)
+{
+  if (ctx == NULL)
+    return;
+  ctx->file_owner_set = true;
+  ctx->file_owner = owner;
+}
+
+void econf_ctxRequireGroup(econf_ctx *ctx, gid_t group)
+{
+  if (ctx == NULL)
+    return;
+  ctx->file_group_set = true;
+  ctx->file_group = group;
+}
+
+void econf_ctxRequirePermissions(econf_ctx *ctx, mode_t file_perms, mode_t dir_perms)
+{
+  if (ctx == NULL)
+    return;
+  ctx->file_permissions_set = true;
+  ctx->file_perms_file = file_perms;
+  ctx->file_perms_dir = dir_perms;
+}
+
+void econf_ctxFollowSymlinks(econf_ctx *ctx, bool allow)
+{
+  if (ctx == NULL)
+    return;
+  ctx->allow_follow_symlinks = allow;
+}
+
+econf_err econf_ctxSetConfDirs(econf_ctx *ctx, const char **dir_postfix_list)
+{
+  char **dirs;
+  int count = 0;
+
+  if (ctx == NULL || dir_postfix_list == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  while (dir_postfix_list[count])
+    count++;
+  if ((dirs = calloc(count + 1, sizeof(char *))) == NULL)
+    return ECONF_NOMEM;
+  for (int i = 0; i < count; i++) {
+    if ((dirs[i] = strdup(dir_postfix_list[i])) == NULL) {
+      econf_freeArray(dirs);
+      return ECONF_NOMEM;
+    }
+  }
+  // free old entry
+  econf_freeArray(ctx->conf_dirs);
+  ctx->conf_dirs = dirs;
+  ctx->conf_count = count;
+  return ECONF_SUCCESS;
+}
+
+void econf_ctxErrLocation(econf_ctx *ctx, char **filename, uint64_t *line_nr)
+{
+  if (ctx == NULL) {
+    *filename = NULL;
+    *line_nr = 0;
+    return;
+  }
+  last_scanned_file(ctx, filename, line_nr);
+}
 
 void econf_requireOwner(uid_t owner)
 {
-  file_owner_set = true;
-  file_owner = owner;
+  econf_ctxRequireOwner(&default_ctx, owner);
 }
 
 void econf_requireGroup(gid_t group)
 {
-  file_group_set = true;
-  file_group = group;
+  econf_ctxRequireGroup(&default_ctx, group);
 }
 
 void econf_requirePermissions(mode_t file_perms, mode_t dir_perms)
 {
-  file_permissions_set = true;
-  file_perms_file = file_perms;
-  file_perms_dir = dir_perms;
+  econf_ctxRequirePermissions(&default_ctx, file_perms, dir_perms);
 }
 
 void econf_followSymlinks(bool allow)
 {
-  allow_follow_symlinks = allow;
+  econf_ctxFollowSymlinks(&default_ctx, allow);
 }
 
 void econf_reset_security_settings(void)
 {
-  file_owner_set = false;
-  file_group_set = false;
-  file_permissions_set = false;
-  allow_follow_symlinks = true;
+  default_ctx.file_owner_set = false;
+  default_ctx.file_group_set = false;
+  default_ctx.file_permissions_set = false;
+  default_ctx.allow_follow_symlinks = true;
 }
 
 econf_err econf_set_conf_dirs(const char **dir_postfix_list)
 {
-  // free old entry
-  if (conf_dirs) econf_freeArray(conf_dirs);
-  conf_count = 0;
-  const char **tmp = dir_postfix_list;
-  while (*tmp++)
-    conf_count++;
-  conf_dirs = malloc(sizeof(char *) * (conf_count+1));
-  if (!conf_dirs)
-    return ECONF_NOMEM;
-  conf_dirs[conf_count]=NULL;
-  for (int i = 0; i < conf_count; i++)
-  {
-    conf_dirs[i] = strdup(dir_postfix_list[i]);
-  }
-  return ECONF_SUCCESS;
+  return econf_ctxSetConfDirs(&default_ctx, dir_postfix_list);
 }
 
 // Create a new econf_file. Allocation is based on
@@ -112,13 +180,14 @@ econf_newKeyFile(econf_file **result, char delimiter, char comment)
   key_file->comment = comment;
   key_file->join_same_entries = false;
   key_file->python_style = false;
+  key_file->parse_threads = 1;
 
   key_file->parse_dirs = NULL;
   key_file->parse_dirs_count = 0;
   key_file->conf_dirs = NULL;
   key_file->conf_count = 0;
   key_file->groups = NULL;
-  key_file->group_count = 0;
+  key_file->group_count = key_file->group_alloc = 0;
   key_file->file_entry = malloc(KEY_FILE_DEFAULT_LENGTH * sizeof(struct file_entry));
   if (key_file->file_entry == NULL)
     {
@@ -145,12 +214,13 @@ econf_newKeyFile_with_options(econf_file **result, const char *options) {
   (*result)->length = 0;
   (*result)->join_same_entries = false;
   (*result)->python_style = false;
+  (*result)->parse_threads = 1;
   (*result)->parse_dirs = NULL;
   (*result)->parse_dirs_count = 0;
   (*result)->conf_dirs = NULL;
   (*result)->conf_count = 0;
   (*result)->groups = NULL;
-  (*result)->group_count = 0;
+  (*result)->group_count = (*result)->group_alloc = 0;
   (*result)->root_prefix = NULL;
 
   if (options == NULL || strlen(options) == 0)
@@ -209,6 +279,18 @@ econf_newKeyFile_with_options(econf_file **result, const char *options) {
       continue;
     }
 
+    if (strncmp(o_opt, PARSING_THREADS, strlen(PARSING_THREADS)) == 0) {
+      char *end;
+      long threads = strtol(o_opt + strlen(PARSING_THREADS), &end, 10);
+      if (end == o_opt + strlen(PARSING_THREADS) || *end || threads < 0 ||
+	  threads > MAX_PARSE_THREADS) {
+	free(begin_opt);
+	return ECONF_VALUE_CONVERSION_ERROR;
+      }
+      (*result)->parse_threads = (int) threads;
+      continue;
+    }
+
     if (strncmp(o_opt, ROOT_PREFIX, strlen(ROOT_PREFIX)) == 0) {
       (*result)->root_prefix = strdup(o_opt + strlen(ROOT_PREFIX));
       continue;
@@ -251,18 +333,22 @@ void econf_set_delimiter_tag(econf_file *key_file, const char delimiter) {
 }
 
 // Process the file of the given file_name and save its contents into key_file
-econf_err econf_readFileWithCallback(econf_file **key_file, const char *file_name,
-				     const char *delim, const char *comment,
-				     bool (*callback)(const char *filename, const void *data),
-				     const void *callback_data)
+econf_err econf_ctxReadFileWithCallback(econf_ctx *ctx, econf_file **key_file,
+					const char *file_name,
+					const char *delim, const char *comment,
+					bool (*callback)(const char *filename, const void *data),
+					const void *callback_data)
 {
   econf_err t_err;
 
+  if (ctx == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
   if ((t_err = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS) {
     return t_err;
   }
 
-  t_err = read_file_with_callback(key_file, file_name,
+  t_err = read_file_with_callback(ctx, NULL, key_file, file_name,
 				  delim, comment,
 				  callback,
 				  callback_data);
@@ -272,12 +358,113 @@ econf_err econf_readFileWithCallback(econf_file **key_file, const char *file_nam
   return t_err;
 }
 
+econf_err econf_ctxReadFile(econf_ctx *ctx, econf_file **key_file,
+			    const char *file_name,
+			    const char *delim, const char *comment)
+{
+  return econf_ctxReadFileWithCallback(ctx, key_file, file_name, delim, comment,
+				       NULL, NULL);
+}
+
+econf_err econf_readFileWithCallback(econf_file **key_file, const char *file_name,
+				     const char *delim, const char *comment,
+				     bool (*callback)(const char *filename, const void *data),
+				     const void *callback_data)
+{
+  return econf_ctxReadFileWithCallback(&default_ctx, key_file, file_name, delim, comment,
+				       callback, callback_data);
+}
+
 econf_err econf_readFile(econf_file **key_file, const char *file_name,
 			 const char *delim, const char *comment)
 {
    return econf_readFileWithCallback(key_file, file_name, delim, comment, NULL, NULL);
 }
 
+econf_err econf_ctxReadBuffer(econf_ctx *ctx, econf_file **key_file,
+			      const char *data, size_t length,
+			      const char *delim, const char *comment)
+{
+  econf_err t_err;
+
+  if (ctx == NULL || key_file == NULL || (data == NULL && length > 0) || delim == NULL || comment == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
+  if ((t_err = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS)
+    return t_err;
+
+  t_err = read_buffer(ctx, *key_file, data, length, delim, comment);
+  if (t_err != ECONF_SUCCESS)
+    *key_file = econf_freeFile(*key_file);
+  return t_err;
+}
+
+econf_err econf_readBuffer(econf_file **key_file, const char *data, size_t length,
+			   const char *delim, const char *comment)
+{
+  return econf_ctxReadBuffer(&default_ctx, key_file, data, length, delim, comment);
+}
+
+econf_err econf_ctxReadFd(econf_ctx *ctx, econf_file **key_file, int fd,
+			  const char *delim, const char *comment)
+{
+  econf_err t_err;
+
+  if (ctx == NULL || key_file == NULL || delim == NULL || comment == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  if (fd < 0)
+    return ECONF_NOFILE;
+
+  if ((t_err = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS)
+    return t_err;
+
+  t_err = read_fd(ctx, *key_file, fd, delim, comment);
+  if (t_err != ECONF_SUCCESS)
+    *key_file = econf_freeFile(*key_file);
+  return t_err;
+}
+
+econf_err econf_readFd(econf_file **key_file, int fd,
+		       const char *delim, const char *comment)
+{
+  return econf_ctxReadFd(&default_ctx, key_file, fd, delim, comment);
+}
+
+econf_err econf_ctxOpenSnapshot(econf_ctx *ctx, econf_file **key_file,
+				const char *file_name)
+{
+  econf_err t_err;
+
+  if (ctx == NULL || key_file == NULL || file_name == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
+  if ((t_err = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS)
+    return t_err;
+
+  t_err = read_snapshot(ctx, *key_file, file_name);
+  if (t_err != ECONF_SUCCESS)
+    *key_file = econf_freeFile(*key_file);
+  return t_err;
+}
+
+econf_err econf_openSnapshot(econf_file **key_file, const char *file_name)
+{
+  return econf_ctxOpenSnapshot(&default_ctx, key_file, file_name);
+}
+
+// Preallocate file_entry elements and the key index
+econf_err econf_reserve(econf_file *key_file, size_t entries)
+{
+  econf_err error;
+  if (key_file == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  if ((error = snapshot_materialize(key_file)))
+    return error;
+  if ((error = key_file_reserve(key_file, entries)))
+    return error;
+  return hash_reserve(&key_file->key_index, entries);
+}
+
 // Merge the contents of two key files
 econf_err econf_mergeFiles(econf_file **merged_file, econf_file *usr_file, econf_file *etc_file)
 {
@@ -286,6 +473,13 @@ econf_err econf_mergeFiles(econf_file **merged_file, econf_file *usr_file, econf
     return ECONF_ARGUMENT_IS_NULL_VALUE;
   }
 
+  econf_err error;
+  if ((error = snapshot_materialize(usr_file)) ||
+      (error = snapshot_materialize(etc_file))) {
+    *merged_file = NULL;
+    return error;
+  }
+
   *merged_file = calloc(1, sizeof(econf_file));
   if (*merged_file == NULL)
     return ECONF_NOMEM;
@@ -301,77 +495,80 @@ econf_err econf_mergeFiles(econf_file **merged_file, econf_file *usr_file, econf
     return ECONF_SUCCESS;
   }
 
-  struct file_entry *fe =
-      malloc((etc_file->length + usr_file->length) * sizeof(struct file_entry));
-  if (fe == NULL)
-    {
-      free (*merged_file);
+  error = merge_files(*merged_file, usr_file, etc_file);
+  if (!error)
+    error = key_index_rebuild(*merged_file);
+  if (error)
+    *merged_file = econf_freeFile(*merged_file);
+  return error;
+}
+
+// Merge the contents of two key files and free them
+econf_err econf_mergeFilesConsume(econf_file **merged_file, econf_file *usr_file,
+				  econf_file *etc_file)
+{
+  econf_err error;
+
+  if (merged_file == NULL || usr_file == NULL || etc_file == NULL) {
+    if (merged_file)
       *merged_file = NULL;
-      return ECONF_NOMEM;
-    }
+    econf_freeFile(usr_file);
+    econf_freeFile(etc_file);
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  }
 
-  size_t merge_length = 0;
-
-  if ((etc_file->file_entry == NULL ||
-       !strcmp(etc_file->file_entry->group, KEY_FILE_NULL_VALUE)) &&
-      (usr_file->file_entry == NULL ||
-       strcmp(usr_file->file_entry->group, KEY_FILE_NULL_VALUE))) {
-    merge_length = insert_nogroup(*merged_file, &fe, etc_file);
-  }
-  merge_length = merge_existing_groups(*merged_file,&fe, usr_file,
-				       etc_file, merge_length);
-  merge_length = add_new_groups(*merged_file, &fe, usr_file,
-				etc_file, merge_length);
-  (*merged_file)->length = merge_length;
-  (*merged_file)->alloc_length = merge_length;
-  (*merged_file)->file_entry = fe;
-  return ECONF_SUCCESS;
+  if (usr_file == etc_file) {
+    error = econf_mergeFiles(merged_file, usr_file, etc_file);
+    econf_freeFile(usr_file);
+    return error;
+  }
+
+  if ((error = snapshot_materialize(usr_file)) ||
+      (error = snapshot_materialize(etc_file))) {
+    *merged_file = NULL;
+    econf_freeFile(usr_file);
+    econf_freeFile(etc_file);
+    return error;
+  }
+
+  econf_file *key_files[2] = { usr_file, etc_file };
+  usr_file->on_merge_delete = etc_file->on_merge_delete = 1;
+  return merge_key_files(key_files, 2, merged_file);
 }
 
-econf_err econf_readConfigWithCallback(econf_file **key_file,
-				       const char *project,
-				       const char *usr_subdir,
-				       const char *config_name,
-				       const char *config_suffix,
-				       const char *delim,
-				       const char *comment,
-				       bool (*callback)(const char *filename, const void *data),
-				       const void *callback_data)
+/* Set the default parse dirs of key_file for project, if no other
+   parse dirs have been set. If config_name is empty, the drop-ins of
+   project are parsed without main configuration file.  */
+static econf_err
+set_default_dirs(econf_file *key_file, const char *project, const char *usr_subdir,
+		 const char **config_name)
 {
   char *usr_dir = NULL;
   char *run_dir = NULL;
   char *etc_dir = NULL;
-  econf_err ret = ECONF_SUCCESS;
-  int init_keyfile = 0;
 
-  if (*key_file == NULL) {
-    if ((ret = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS)
-      return ret;
-    init_keyfile = 1;
-  }
-
-  if (config_name == NULL || strlen(config_name) == 0) {
+  if (*config_name == NULL || strlen(*config_name) == 0) {
     /* Drop-ins without Main Configuration File. */
     /* e.g. parsing /usr/lib/<project>.d/a.conf, /usr/lib/<project>.d/b.conf and /etc/<project>.d/c.conf */
     /* https://uapi-group.org/specifications/specs/configuration_files_specification/#drop-ins-without-main-configuration-file */
-    config_name = project;
+    *config_name = project;
     project = NULL;
-    if ((*key_file)->conf_count > 0) econf_freeArray((*key_file)->conf_dirs);
-    (*key_file)->conf_count = 1;
-    (*key_file)->conf_dirs = calloc((*key_file)->conf_count +1, sizeof(char *));
-    (*key_file)->conf_dirs[(*key_file)->conf_count] = NULL;
-    (*key_file)->conf_dirs[0] = strdup(".d");
+    if (key_file->conf_count > 0) econf_freeArray(key_file->conf_dirs);
+    key_file->conf_count = 1;
+    key_file->conf_dirs = calloc(key_file->conf_count +1, sizeof(char *));
+    key_file->conf_dirs[key_file->conf_count] = NULL;
+    key_file->conf_dirs[0] = strdup(".d");
   }
 
   if (usr_subdir == NULL)
     usr_subdir = "";
 
   int re = 0;
-  if ((*key_file)->root_prefix) {
+  if (key_file->root_prefix) {
     if (project != NULL) {
-      re = asprintf(&usr_dir, "%s/%s/%s", (*key_file)->root_prefix, usr_subdir, project);
+      re = asprintf(&usr_dir, "%s/%s/%s", key_file->root_prefix, usr_subdir, project);
     } else {
-      re = asprintf(&usr_dir, "%s%s", (*key_file)->root_prefix, usr_subdir);
+      re = asprintf(&usr_dir, "%s%s", key_file->root_prefix, usr_subdir);
     }
   } else {
     if (project != NULL) {
@@ -384,11 +581,11 @@ econf_err econf_readConfigWithCallback(econf_file **key_file,
   if (re < 0)
     return ECONF_NOMEM;
 
-  if ((*key_file)->root_prefix) {
+  if (key_file->root_prefix) {
     if (project != NULL) {
-      re = asprintf(&run_dir, "%s/%s/%s", (*key_file)->root_prefix, DEFAULT_RUN_SUBDIR, project);
+      re = asprintf(&run_dir, "%s/%s/%s", key_file->root_prefix, DEFAULT_RUN_SUBDIR, project);
     } else {
-      re = asprintf(&run_dir, "%s%s", (*key_file)->root_prefix, DEFAULT_RUN_SUBDIR);
+      re = asprintf(&run_dir, "%s%s", key_file->root_prefix, DEFAULT_RUN_SUBDIR);
     }
   } else {
     if (project != NULL) {
@@ -403,11 +600,11 @@ econf_err econf_readConfigWithCallback(econf_file **key_file,
     return ECONF_NOMEM;
   }
 
-  if ((*key_file)->root_prefix) {
+  if (key_file->root_prefix) {
     if (project != NULL) {
-      re = asprintf(&etc_dir, "%s/%s/%s", (*key_file)->root_prefix, DEFAULT_ETC_SUBDIR, project);
+      re = asprintf(&etc_dir, "%s/%s/%s", key_file->root_prefix, DEFAULT_ETC_SUBDIR, project);
     } else {
-      re = asprintf(&etc_dir,  "%s%s", (*key_file)->root_prefix, DEFAULT_ETC_SUBDIR);
+      re = asprintf(&etc_dir,  "%s%s", key_file->root_prefix, DEFAULT_ETC_SUBDIR);
     }
   } else {
     if (project != NULL) {
@@ -423,36 +620,223 @@ econf_err econf_readConfigWithCallback(econf_file **key_file,
     return ECONF_NOMEM;
   }
 
-  if ((*key_file)->parse_dirs_count == 0) {
+  if (key_file->parse_dirs_count == 0) {
     /* taking default */
-    (*key_file)->parse_dirs_count = 3;
-    (*key_file)->parse_dirs = calloc((*key_file)->parse_dirs_count +1, sizeof(char *));
-    (*key_file)->parse_dirs[(*key_file)->parse_dirs_count] = NULL;
-    (*key_file)->parse_dirs[0] = strdup(usr_dir);
-    (*key_file)->parse_dirs[1] = strdup(run_dir);
-    (*key_file)->parse_dirs[2] = strdup(etc_dir);
+    key_file->parse_dirs_count = 3;
+    key_file->parse_dirs = calloc(key_file->parse_dirs_count +1, sizeof(char *));
+    key_file->parse_dirs[key_file->parse_dirs_count] = NULL;
+    key_file->parse_dirs[0] = strdup(usr_dir);
+    key_file->parse_dirs[1] = strdup(run_dir);
+    key_file->parse_dirs[2] = strdup(etc_dir);
   }
 
-  ret = readConfigWithCallback(key_file,
+  free(usr_dir);
+  free(run_dir);
+  free(etc_dir);
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_ctxReadConfigWithCallback(econf_ctx *ctx,
+					  econf_file **key_file,
+					  const char *project,
+					  const char *usr_subdir,
+					  const char *config_name,
+					  const char *config_suffix,
+					  const char *delim,
+					  const char *comment,
+					  bool (*callback)(const char *filename, const void *data),
+					  const void *callback_data)
+{
+  econf_err ret = ECONF_SUCCESS;
+  int init_keyfile = 0;
+
+  if (ctx == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
+  if (*key_file == NULL) {
+    if ((ret = econf_newKeyFile_with_options(key_file, "")) != ECONF_SUCCESS)
+      return ret;
+    init_keyfile = 1;
+  }
+
+  if ((ret = set_default_dirs(*key_file, project, usr_subdir, &config_name)) != ECONF_SUCCESS) {
+    if (init_keyfile)
+      *key_file = econf_free(*key_file);
+    return ret;
+  }
+
+  ret = readConfigWithCallback(ctx,
+			       key_file,
 			       config_name,
 			       config_suffix,
 			       delim,
 			       comment,
-			       conf_dirs,
-			       conf_count,
 			       callback,
 			       callback_data);
 
   if (init_keyfile && ret != ECONF_SUCCESS)
     *key_file = econf_free(*key_file);
 
-  free(usr_dir);
-  free(run_dir);
-  free(etc_dir);
-
   return ret;
 }
 
+econf_err econf_readConfigWithCallback(econf_file **key_file,
+				       const char *project,
+				       const char *usr_subdir,
+				       const char *config_name,
+				       const char *config_suffix,
+				       const char *delim,
+				       const char *comment,
+				       bool (*callback)(const char *filename, const void *data),
+				       const void *callback_data)
+{
+  return econf_ctxReadConfigWithCallback(&default_ctx,
+					 key_file,
+					 project,
+					 usr_subdir,
+					 config_name,
+					 config_suffix,
+					 delim,
+					 comment,
+					 callback,
+					 callback_data);
+}
+
+
+static econf_err open_config(econf_ctx *ctx,
+			     econf_handle **handle,
+			     const char *options,
+			     const char *project,
+			     const char *usr_subdir,
+			     const char *config_name,
+			     const char *config_suffix,
+			     const char *delim,
+			     const char *comment)
+{
+  econf_file *key_file = NULL;
+  econf_err ret;
+
+  if (handle == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  *handle = NULL;
+
+  if ((ret = econf_newKeyFile_with_options(&key_file, options ? options : "")) != ECONF_SUCCESS)
+    return ret;
+  if ((ret = set_default_dirs(key_file, project, usr_subdir, &config_name)) != ECONF_SUCCESS) {
+    econf_free(key_file);
+    return ret;
+  }
+  /* conf dirs of ctx at this time */
+  if (key_file->conf_count == 0 && ctx->conf_count > 0) {
+    if ((key_file->conf_dirs = calloc(ctx->conf_count + 1, sizeof(char *))) == NULL) {
+      econf_free(key_file);
+      return ECONF_NOMEM;
+    }
+    key_file->conf_count = ctx->conf_count;
+    for (int i = 0; i < ctx->conf_count; i++) {
+      if ((key_file->conf_dirs[i] = strdup(ctx->conf_dirs[i])) == NULL) {
+	econf_free(key_file);
+	return ECONF_NOMEM;
+      }
+    }
+  }
+
+  return open_handle(ctx, handle, key_file, config_name, config_suffix, delim, comment);
+}
+
+econf_err econf_openConfig(econf_handle **handle,
+			   const char *options,
+			   const char *project,
+			   const char *usr_subdir,
+			   const char *config_name,
+			   const char *config_suffix,
+			   const char *delim,
+			   const char *comment)
+{
+  return open_config(&default_ctx, handle, options, project, usr_subdir,
+		     config_name, config_suffix, delim, comment);
+}
+
+econf_err econf_ctxOpenConfig(econf_ctx *ctx,
+			      econf_handle **handle,
+			      const char *options,
+			      const char *project,
+			      const char *usr_subdir,
+			      const char *config_name,
+			      const char *config_suffix,
+			      const char *delim,
+			      const char *comment)
+{
+  if (ctx == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  return open_config(ctx, handle, options, project, usr_subdir,
+		     config_name, config_suffix, delim, comment);
+}
+
+econf_err econf_reload(econf_handle *handle, bool *changed)
+{
+  if (handle == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  return reload_handle(handle, changed);
+}
+
+econf_file *econf_getConfig(econf_handle *handle)
+{
+  if (handle == NULL)
+    return NULL;
+  return atomic_load(&handle->current);
+}
+
+econf_file *econf_acquireConfig(econf_handle *handle)
+{
+  if (handle == NULL)
+    return NULL;
+  return handle_acquire(handle);
+}
+
+void econf_releaseConfig(econf_file *key_file)
+{
+  handle_release(key_file);
+}
+
+void econf_handleErrLocation(econf_handle *handle, char **filename, uint64_t *line_nr)
+{
+  if (handle == NULL) {
+    *filename = NULL;
+    *line_nr = 0;
+    return;
+  }
+  pthread_mutex_lock(&handle->lock);
+  last_scanned_file(handle->ctx, filename, line_nr);
+  pthread_mutex_unlock(&handle->lock);
+}
+
+econf_handle *econf_freeHandle(econf_handle *handle)
+{
+  free_handle(handle);
+  return NULL;
+}
+
+econf_err econf_ctxReadConfig(econf_ctx *ctx,
+			      econf_file **key_file,
+			      const char *project,
+			      const char *usr_subdir,
+			      const char *config_name,
+			      const char *config_suffix,
+			      const char *delim,
+			      const char *comment)
+{
+  return econf_ctxReadConfigWithCallback(ctx,
+					 key_file,
+					 project,
+					 usr_subdir,
+					 config_name,
+					 config_suffix,
+					 delim,
+					 comment,
+					 NULL,
+					 NULL);
+}
 
 econf_err econf_readConfig (econf_file **key_file,
 			    const char *project,
@@ -473,17 +857,21 @@ econf_err econf_readConfig (econf_file **key_file,
 				      NULL);
 }
 
-econf_err econf_readDirsHistoryWithCallback(econf_file ***key_files,
-					    size_t *size,
-					    const char *dist_conf_dir,
-					    const char *etc_conf_dir,
-					    const char *config_name,
-					    const char *config_suffix,
-					    const char *delim,
-					    const char *comment,
-					    bool (*callback)(const char *filename, const void *data),
-					    const void *callback_data)
+econf_err econf_ctxReadDirsHistoryWithCallback(econf_ctx *ctx,
+					       econf_file ***key_files,
+					       size_t *size,
+					       const char *dist_conf_dir,
+					       const char *etc_conf_dir,
+					       const char *config_name,
+					       const char *config_suffix,
+					       const char *delim,
+					       const char *comment,
+					       bool (*callback)(const char *filename, const void *data),
+					       const void *callback_data)
 {
+   if (ctx == NULL)
+     return ECONF_ARGUMENT_IS_NULL_VALUE;
+
    int count = 2;
    char **parse_dirs = calloc(count+1, sizeof(char *));
    parse_dirs[count] = NULL;
@@ -496,7 +884,7 @@ econf_err econf_readDirsHistoryWithCallback(econf_file ***key_files,
    else
      parse_dirs[1] = strdup("");
 
-   econf_err ret = readConfigHistoryWithCallback(key_files,
+   econf_err ret = readConfigHistoryWithCallback(ctx, key_files,
 						 size,
 						 parse_dirs, count,
 						 config_name,
@@ -504,14 +892,49 @@ econf_err econf_readDirsHistoryWithCallback(econf_file ***key_files,
 						 delim,
 						 comment,
 						 false, false, /*join_same_entries, python_style*/
-						 conf_dirs,
-						 conf_count,
+						 1, /*parse_threads*/
+						 ctx->conf_dirs,
+						 ctx->conf_count,
 						 callback,
-						 callback_data);
+						 callback_data,
+						 NULL);
    parse_dirs = econf_freeArray(parse_dirs);
    return ret;
 }
 
+econf_err econf_ctxReadDirsHistory(econf_ctx *ctx,
+				   econf_file ***key_files,
+				   size_t *size,
+				   const char *dist_conf_dir,
+				   const char *etc_conf_dir,
+				   const char *config_name,
+				   const char *config_suffix,
+				   const char *delim,
+				   const char *comment)
+{
+  return econf_ctxReadDirsHistoryWithCallback(ctx, key_files, size,
+					      dist_conf_dir, etc_conf_dir,
+					      config_name, config_suffix,
+					      delim, comment, NULL, NULL);
+}
+
+econf_err econf_readDirsHistoryWithCallback(econf_file ***key_files,
+					    size_t *size,
+					    const char *dist_conf_dir,
+					    const char *etc_conf_dir,
+					    const char *config_name,
+					    const char *config_suffix,
+					    const char *delim,
+					    const char *comment,
+					    bool (*callback)(const char *filename, const void *data),
+					    const void *callback_data)
+{
+  return econf_ctxReadDirsHistoryWithCallback(&default_ctx, key_files, size,
+					      dist_conf_dir, etc_conf_dir,
+					      config_name, config_suffix,
+					      delim, comment, callback, callback_data);
+}
+
 econf_err econf_readDirsHistory(econf_file ***key_files,
 				size_t *size,
 				const char *dist_conf_dir,
@@ -520,27 +943,10 @@ econf_err econf_readDirsHistory(econf_file ***key_files,
 				const char *config_suffix,
 				const char *delim,
 				const char *comment) {
-  int count = 2;
-  char **parse_dirs = calloc(count+1, sizeof(char *));
-  parse_dirs[count] = NULL;
-  if (dist_conf_dir)
-    parse_dirs[0] = strdup(dist_conf_dir);
-  else
-    parse_dirs[0] = strdup("");
-  if (etc_conf_dir)
-    parse_dirs[1] = strdup(etc_conf_dir);
-  else
-    parse_dirs[1] = strdup("");
-
-  econf_err ret = readConfigHistoryWithCallback(key_files, size,
-						parse_dirs, count,
-						config_name,
-						config_suffix, delim, comment,
-						false, false, /*join_same_entries, python_style*/
-						conf_dirs, conf_count,
-						NULL, NULL);
-  parse_dirs = econf_freeArray(parse_dirs);
-  return ret;
+  return econf_ctxReadDirsHistoryWithCallback(&default_ctx, key_files, size,
+					      dist_conf_dir, etc_conf_dir,
+					      config_name, config_suffix,
+					      delim, comment, NULL, NULL);
 }
 
 econf_err econf_readDirsWithCallback(econf_file **result,
@@ -569,10 +975,9 @@ econf_err econf_readDirsWithCallback(econf_file **result,
   else
     (*result)->parse_dirs[1] = strdup("");
 
-  return readConfigWithCallback(result,
+  return readConfigWithCallback(&default_ctx, result,
 				config_name,
 				config_suffix, delim, comment,
-				conf_dirs, conf_count,
 				callback, callback_data);
 }
 
@@ -600,10 +1005,9 @@ econf_err econf_readDirs(econf_file **result,
   else
     (*result)->parse_dirs[1] = strdup("");
 
-  return readConfigWithCallback(result,
+  return readConfigWithCallback(&default_ctx, result,
 				config_name,
 				config_suffix, delim, comment,
-				conf_dirs, conf_count,
 				NULL, NULL);
 }
 
@@ -612,6 +1016,9 @@ econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
 			       const char *file_name) {
   if (!key_file)
     return ECONF_ARGUMENT_IS_NULL_VALUE;
+  econf_err error = snapshot_materialize(key_file);
+  if (error)
+    return error;
 
   /* Checking if the directory exists*/
   struct stat stats;
@@ -699,6 +1106,15 @@ econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
   return ECONF_SUCCESS;
 }
 
+// Write content of an econf_file struct to a snapshot
+econf_err econf_compileConfig(econf_file *key_file, const char *file_name)
+{
+  if (key_file == NULL || file_name == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
+  return write_snapshot(key_file, file_name);
+}
+
 extern char *econf_getPath(econf_file *kf)
 {
   if (kf->path == NULL)
@@ -706,6 +1122,35 @@ extern char *econf_getPath(econf_file *kf)
   return strdup(kf->path);
 }
 
+econf_err econf_watch(econf_file *kf, int *fd)
+{
+  econf_err error;
+  bool created = false;
+
+  if (kf == NULL || fd == NULL)
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+
+  if (*fd < 0) {
+    if ((*fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+      return errno == ENOMEM ? ECONF_NOMEM : ECONF_ERROR;
+    created = true;
+  }
+  if ((error = watch_key_file(kf, *fd)) && created) {
+    close(*fd);
+    *fd = -1;
+  }
+  return error;
+}
+
+bool econf_isStale(econf_file *kf)
+{
+  if (kf == NULL)
+    return false;
+  if (kf->snapshot)
+    return snapshot_stale(kf);
+  return statvec_changed(&kf->stats);
+}
+
 /* GETTER FUNCTIONS */
 econf_err
 econf_getGroups(econf_file *kf, size_t *length, char ***groups)
@@ -713,11 +1158,13 @@ econf_getGroups(econf_file *kf, size_t *length, char ***groups)
   if (!kf || groups == NULL || length == NULL)
     return  ECONF_ARGUMENT_IS_NULL_VALUE;
 
-  if (kf->group_count <= 0)
+  if (kf->snapshot)
+    return snapshot_get_groups(kf, length, groups);
+  if (kf->group_count == 0)
     return ECONF_NOGROUP;
   *groups = NULL;
   *length = 0;
-  for (int i = 0; i < kf->group_count; i++) {
+  for (size_t i = 0; i < kf->group_count; i++) {
     if (strcmp(kf->groups[i], KEY_FILE_NULL_VALUE)) {
       (*length)++;
       *groups = realloc(*groups, (*length +1) * sizeof(char *));
@@ -746,6 +1193,12 @@ econf_getKeys(econf_file *kf, const char *grp, size_t *length, char ***keys)
   if (group == NULL)
     return ECONF_NOMEM;
 
+  if (kf->snapshot) {
+    econf_err error = snapshot_get_keys(kf, group, length, keys);
+    free(group);
+    return error;
+  }
+
   bool *uniques = calloc(kf->length, sizeof(bool));
   if (uniques == NULL)
     {
@@ -790,9 +1243,7 @@ econf_err econf_get ## FCT_TYPE ## Value(econf_file *kf, const char *group, \
     return ECONF_ERROR; \
 \
   size_t num; \
-  char *grp = group ? strdup(group) : NULL; \
-  econf_err error = find_key(*kf, stripbrackets(grp), key, &num); \
-  free(grp); \
+  econf_err error = find_bracketed_key(*kf, group, key, &num); \
   if (error) \
     return error; \
   if (result == NULL) \
@@ -851,24 +1302,21 @@ econf_file *econf_freeFile(econf_file *key_file) {
   if (!key_file)
     return NULL;
 
-  if (key_file->file_entry)
-  {
-    for (size_t i = 0; i < key_file->alloc_length; i++) {
-      free(key_file->file_entry[i].key);
-      free(key_file->file_entry[i].value);
-      free(key_file->file_entry[i].comment_before_key);
-      free(key_file->file_entry[i].comment_after_value);
-    }
-    free(key_file->file_entry);
-  }
+  free(key_file->file_entry);
+  snapshot_unmap(key_file);
 
   if (key_file->path)
     free(key_file->path);
 
+  econf_freeArray(key_file->sources);
+  statvec_free(&key_file->stats);
   econf_freeArray(key_file->parse_dirs);
-  econf_freeArray(key_file->groups);
+  free(key_file->groups); /* the group names are part of the arena */
   econf_freeArray(key_file->conf_dirs);
   free(key_file->root_prefix);
+  hash_free(&key_file->key_index);
+  hash_free(&key_file->group_index);
+  arena_free(&key_file->arena);
   free(key_file);
 
   return NULL;
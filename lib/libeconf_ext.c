@@ -26,6 +26,7 @@
 #include "helpers.h"
 #include "keyfile.h"
 #include "libeconf_ext.h"
+#include "snapshot.h"
 
 static char *ltrim(char *s)
 {
@@ -123,7 +124,10 @@ econf_setExtValue(econf_file *kf, const char *group,
     return ECONF_ERROR;
 
   size_t num;
-  econf_err error = find_key(*kf, group, key, &num);
+  econf_err error = snapshot_materialize(kf);
+  if (error)
+    return error;
+  error = find_key(*kf, group, key, &num);
   if (error)
     return error;
 
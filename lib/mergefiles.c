@@ -26,212 +26,731 @@
 #include "helpers.h"
 #include "mergefiles.h"
 #include "getfilecontents.h"
+#include "uring.h"
 
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <libgen.h>
+#include <unistd.h>
 
-// Insert the content of "etc_file.file_entry" into "fe" if there is no
-// group specified
-size_t insert_nogroup(econf_file *dest_kf, struct file_entry **fe,
-		      econf_file *ef) {
+// Number of the leading entries of etc_file without group which are put
+// in front of the merged file. This is only done if usr_file starts with a group.
+static size_t
+count_nogroup(econf_file *uf, econf_file *ef) {
   size_t etc_start = 0;
-  if (ef) {
+  if ((ef->length == 0 || !strcmp(ef->file_entry[0].group, KEY_FILE_NULL_VALUE)) &&
+      (uf->length == 0 || strcmp(uf->file_entry[0].group, KEY_FILE_NULL_VALUE))) {
     while (etc_start < ef->length &&
-	   !strcmp(ef->file_entry[etc_start].group, KEY_FILE_NULL_VALUE)) {
-      (*fe)[etc_start] = cpy_file_entry(dest_kf, ef->file_entry[etc_start]);
+	   !strcmp(ef->file_entry[etc_start].group, KEY_FILE_NULL_VALUE))
       etc_start++;
-    }
   }
   return etc_start;
 }
 
-// Merge contents from existing usr_file groups
-// uf: usr_file, ef: etc_file
-size_t merge_existing_groups(econf_file *dest_kf, struct file_entry **fe, econf_file *uf,
-			     econf_file *ef, const size_t etc_start) {
-  bool new_key;
-  size_t merge_length = etc_start, tmp = etc_start, added_keys = etc_start;
-  if (uf && ef) {
-    for (size_t i = 0; i <= uf->length; i++) {
-      // Check if the group has changed in the last iteration
-      if (i == uf->length ||
-	  (i && strcmp(uf->file_entry[i].group, uf->file_entry[i - 1].group))) {
-	for (size_t j = etc_start; j < ef->length; j++) {
-	  // Check for matching groups
-	  if (!strcmp(uf->file_entry[i - 1].group, ef->file_entry[j].group)) {
-	    new_key = true;
-	    for (size_t k = merge_length; k < i + tmp; k++) {
-	      // If an existing key is found in ef take the value from ef
-	      if (!strcmp((*fe)[k].key, ef->file_entry[j].key)) {
-		free((*fe)[k].value);
-		(*fe)[k].value = ef->file_entry[j].value ? strdup(ef->file_entry[j].value) : strdup("");
-		new_key = false;
-		break;
-	      }
-	    }
-	    // If a new key is found for an existing group append it to the group
-	    if (new_key)
-	      (*fe)[i + added_keys++] = cpy_file_entry(dest_kf, ef->file_entry[j]);
-	  }
-	}
-	merge_length = i + added_keys;
-	// Temporary value to reduce amount of iterations in inner for loop
-	tmp = added_keys;
+// Hash join of usr_file (uf) and etc_file (ef). Every entry of etc_file is
+// looked up once in the key index of usr_file. It either replaces the value
+// of the first usr_file entry with the same group/key, is appended to the
+// last entry of its group in usr_file or belongs to a group which does not
+// exist in usr_file.
+econf_err merge_files(econf_file *dest_kf, econf_file *uf, econf_file *ef) {
+  econf_err error = ECONF_NOMEM;
+  size_t etc_start = count_nogroup(uf, ef);
+  size_t *replace = malloc((uf->length + 1) * sizeof(size_t));
+  size_t *last = malloc((uf->group_count + 1) * sizeof(size_t));
+  size_t *head = malloc((uf->group_count + 1) * sizeof(size_t));
+  size_t *tail = malloc((uf->group_count + 1) * sizeof(size_t));
+  size_t *group_map = malloc((ef->group_count + 1) * sizeof(size_t));
+  size_t *next = malloc((ef->length + 1) * sizeof(size_t));
+  size_t count = uf->length + etc_start, num;
+
+  if (!replace || !last || !head || !tail || !group_map || !next)
+    goto out;
+
+  // usr_file entry which is the last one of its group
+  for (size_t i = 0; i < uf->group_count; i++)
+    last[i] = head[i] = tail[i] = SIZE_MAX;
+  for (size_t i = 0; i < uf->length; i++) {
+    replace[i] = SIZE_MAX;
+    last[uf->file_entry[i].group_id] = i;
+  }
+  // etc_file group -> usr_file group which has entries
+  for (size_t i = 0; i < ef->group_count; i++) {
+    if (getFromGroupList(uf, ef->groups[i], &group_map[i]) == NULL ||
+	last[group_map[i]] == SIZE_MAX)
+      group_map[i] = SIZE_MAX;
+  }
+
+  for (size_t j = 0; j < ef->length; j++) {
+    struct file_entry *fe = &ef->file_entry[j];
+    size_t group_id = group_map[fe->group_id];
+    next[j] = SIZE_MAX;
+    if (group_id == SIZE_MAX) {
+      // groups which only exist in etc_file
+      if (strcmp(fe->group, KEY_FILE_NULL_VALUE))
+	count++;
+    } else if (j >= etc_start) {
+      if (find_group_key(uf, group_id, fe->key, &num) == ECONF_SUCCESS) {
+	replace[num] = j;
+      } else {
+	// new key of an existing group
+	if (tail[group_id] == SIZE_MAX)
+	  head[group_id] = j;
+	else
+	  next[tail[group_id]] = j;
+	tail[group_id] = j;
+	count++;
       }
-      if (i != uf->length)
-	(*fe)[i + added_keys] = cpy_file_entry(dest_kf, uf->file_entry[i]);
     }
   }
-  return merge_length;
-}
 
-// Add entries from etc_file exclusive groups
-size_t add_new_groups(econf_file *dest_kf, struct file_entry **fe,
-		      econf_file *uf, econf_file *ef,
-		      const size_t merge_length) {
-  size_t added_keys = merge_length;
-  bool new_key;
-  if (uf && ef) {
-    for (size_t i = 0; i < ef->length; i++) {
-      if (!strcmp(ef->file_entry[i].group, KEY_FILE_NULL_VALUE))
-	continue;
-      new_key = true;
-      for (size_t j = 0; j < uf->length; j++) {
-	if (!strcmp(uf->file_entry[j].group, ef->file_entry[i].group)) {
-	  new_key = false;
-	  break;
-	}
-      }
-      if (new_key)
-	(*fe)[added_keys++] = cpy_file_entry(dest_kf, ef->file_entry[i]);
+  if ((error = econf_reserve(dest_kf, count)))
+    goto out;
+
+  struct file_entry *dest = dest_kf->file_entry;
+  size_t length = 0;
+  for (size_t j = 0; j < etc_start; j++)
+    dest[length++] = cpy_file_entry(dest_kf, ef->file_entry[j]);
+  for (size_t i = 0; i < uf->length; i++) {
+    struct file_entry *fe = &uf->file_entry[i];
+    dest[length] = cpy_file_entry(dest_kf, *fe);
+    if (replace[i] != SIZE_MAX) {
+      const char *value = ef->file_entry[replace[i]].value;
+      dest[length].value = arena_replace(&dest_kf->arena, dest[length].value,
+					 value ? value : "");
+    }
+    length++;
+    if (last[fe->group_id] == i) {
+      for (size_t j = head[fe->group_id]; j != SIZE_MAX; j = next[j])
+	dest[length++] = cpy_file_entry(dest_kf, ef->file_entry[j]);
     }
-    if (added_keys > 0)
-      *fe = realloc(*fe, (added_keys) * sizeof(struct file_entry));
   }
-  return added_keys;
+  for (size_t j = 0; j < ef->length; j++) {
+    struct file_entry *fe = &ef->file_entry[j];
+    if (group_map[fe->group_id] == SIZE_MAX && strcmp(fe->group, KEY_FILE_NULL_VALUE))
+      dest[length++] = cpy_file_entry(dest_kf, *fe);
+  }
+  dest_kf->length = length;
+  error = ECONF_SUCCESS;
+
+ out:
+  free(replace);
+  free(last);
+  free(head);
+  free(tail);
+  free(group_map);
+  free(next);
+  return error;
 }
 
-// Check if the given directory exists. If so look for config files
-// with the given suffix
+// Sort the names of a directory like alphasort
+static int
+compare_names(const void *a, const void *b)
+{
+  return strcoll(strrchr(*(char * const *) a, '/') + 1,
+		 strrchr(*(char * const *) b, '/') + 1);
+}
+
+// Check if the directory name exists in dir_fd, which is the directory
+// path. If so add the config files with the given suffix to files.
+// The directory or its absence is recorded in stats.
 static econf_err
-check_conf_dir(econf_file ***key_files, size_t *size, const char *path,
-	       const char *config_suffix, const char *delim, const char *comment,
-	       const bool join_same_entries, const bool python_style,
-	       bool (*callback)(const char *filename, const void *data),
-	       const void *callback_data)
+check_conf_dir(struct conf_files *files, econf_statvec *stats, int dir_fd,
+	       const char *path, const char *name, const char *config_suffix)
 {
-  struct dirent **de;
-  econf_err error;
+  econf_err error = ECONF_SUCCESS;
+  size_t first = files->count, lensuffix = strlen(config_suffix);
+  struct dirent *de;
+  DIR *dir;
+  int fd, open_errno;
 
-  int num_dirs = scandir(path, &de, NULL, alphasort);
-  if(num_dirs > 0) {
-    for (int i = 0; i < num_dirs; i++) {
-      size_t lenstr = strlen(de[i]->d_name);
-      size_t lensuffix = strlen(config_suffix);
-      if (lensuffix < lenstr &&
-          strncmp(de[i]->d_name + lenstr - lensuffix, config_suffix, lensuffix) == 0 &&
-	  strcmp(de[i]->d_name,".") != 0 && strcmp(de[i]->d_name,"..") != 0) {
-        char *file_path = combine_strings(path, de[i]->d_name, '/');
-        econf_file *key_file = NULL;
-	if ((error = econf_newKeyFile_with_options(&key_file, "")) != ECONF_SUCCESS)
-          return error;
-        key_file->join_same_entries = join_same_entries;
-        key_file->python_style = python_style;
-	error = read_file_with_callback(&key_file, file_path, delim, comment,
-					callback, callback_data);
-        free(file_path);
-        if(!error && key_file) {
-          key_file->on_merge_delete = 1;
-          (*key_files)[(*size) - 1] = key_file;
-          *key_files = realloc(*key_files, ++(*size) * sizeof(econf_file *));
-        } else {
-	  for (int k = i; k < num_dirs; k++)
-	    free(de[k]);
-	  free(de);
-	  return error;
+  /* Most of the directories do not exist */
+  fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  open_errno = errno;
+  if (stats != NULL) {
+    /* path/name */
+    char *dir_path = malloc(strlen(path) + strlen(name) + 2);
+    if (dir_path == NULL) {
+      error = ECONF_NOMEM;
+    } else {
+      stpcpy(stpcpy(stpcpy(dir_path, path), "/"), name);
+      /* The modification time of the directory covers added and removed files */
+      if (fd < 0)
+	error = statvec_add_error(stats, dir_path, open_errno);
+      else
+	error = statvec_add_fd(stats, dir_path, fd);
+      free(dir_path);
+    }
+  }
+  if (fd < 0 && !error && open_error(open_errno) != ECONF_NOFILE)
+    error = open_error(open_errno);
+  if (fd < 0)
+    return error;
+  if (error || (dir = fdopendir(fd)) == NULL) {
+    close(fd);
+    return error;
+  }
+
+  while (!error && (de = readdir(dir)) != NULL) {
+    size_t lenstr = strlen(de->d_name);
+    if (lensuffix < lenstr &&
+	strncmp(de->d_name + lenstr - lensuffix, config_suffix, lensuffix) == 0 &&
+	strcmp(de->d_name,".") != 0 && strcmp(de->d_name,"..") != 0) {
+      if (files->count == files->alloc) {
+	size_t alloc = files->alloc ? files->alloc * 2 : 16;
+	char **paths = realloc(files->paths, alloc * sizeof(char *));
+	if (paths == NULL) {
+	  error = ECONF_NOMEM;
+	  break;
 	}
+	files->paths = paths;
+	files->alloc = alloc;
+      }
+      /* path/name/d_name */
+      char *file_path = malloc(strlen(path) + strlen(name) + lenstr + 3);
+      if (file_path == NULL) {
+	error = ECONF_NOMEM;
+	break;
       }
-      free(de[i]);
+      char *cp = stpcpy(file_path, path);
+      *cp++ = '/';
+      cp = stpcpy(cp, name);
+      *cp++ = '/';
+      stpcpy(cp, de->d_name);
+      files->paths[files->count++] = file_path;
     }
-    free(de);
   }
-  return ECONF_SUCCESS;
+  closedir(dir);
+
+  qsort(files->paths + first, files->count - first, sizeof(char *), compare_names);
+  return error;
 }
 
-econf_err traverse_conf_dirs(econf_file ***key_files,
+econf_err traverse_conf_dirs(struct conf_files *files,
+			     econf_statvec *stats,
 			     char *config_dirs[],
-			     size_t *size, const char *path,
-			     const char *config_suffix,
-			     const char *delim, const char *comment,
-	                     const bool join_same_entries, const bool python_style,
-			     bool (*callback)(const char *filename, const void *data),
-			     const void *callback_data) {
-  int i;
-
+			     int dir_fd, const char *path,
+			     const char *config_name,
+			     const char *config_suffix) {
   if (config_dirs == NULL)
     return ECONF_NOFILE;
 
-  i = 0;
-  while (config_dirs[i] != NULL) {
-    char *fulldir, *cp;
+  for (int i = 0; config_dirs[i] != NULL; i++) {
+    char *name, *cp;
 
-    if ((fulldir = malloc (strlen(path) + strlen (config_dirs[i]) + 1)) == NULL)
+    if ((name = malloc(strlen(config_name) + strlen(config_dirs[i]) + 1)) == NULL)
       return ECONF_NOMEM;
 
-    cp = stpcpy (fulldir, path);
-    stpcpy (cp, config_dirs[i++]);
-    econf_err error = check_conf_dir(key_files, size,
-				     fulldir, config_suffix, delim, comment,
-	                             join_same_entries, python_style,
-				     callback, callback_data);
-    free (fulldir);
+    cp = stpcpy(name, config_name);
+    stpcpy(cp, config_dirs[i]);
+    econf_err error = check_conf_dir(files, stats, dir_fd, path, name, config_suffix);
+    free(name);
     if (error)
       return error;
   }
   return ECONF_SUCCESS;
 }
 
-econf_err merge_econf_files(econf_file **key_files, econf_file **merged_files) {
-  if (*key_files == NULL || merged_files == NULL)
-    return ECONF_ERROR;
+void free_conf_files(struct conf_files *files) {
+  for (size_t i = 0; i < files->count; i++)
+    free(files->paths[i]);
+  free(files->paths);
+  files->paths = NULL;
+  files->count = files->alloc = 0;
+}
 
-  *merged_files = *key_files++;
-  if(*merged_files == NULL)
-    return ECONF_ERROR;
+econf_err
+find_shadowed(const struct conf_files *files, bool *shadowed)
+{
+  econf_hashtable names = { 0 };
+  econf_err error;
+
+  if ((error = hash_reserve(&names, files->count)))
+    return error;
+  for (size_t i = files->count; i-- > 0;) {
+    const char *name = strrchr(files->paths[i], '/') + 1;
+    size_t hash = hashstring(name), pos;
+    shadowed[i] = false;
+    for (size_t n = hash_first(&names, hash, &pos); n != HASH_EMPTY;
+	 n = hash_next(&names, hash, &pos)) {
+      if (!strcmp(strrchr(files->paths[n], '/') + 1, name)) {
+	shadowed[i] = true;
+	break;
+      }
+    }
+    if (!shadowed[i] && (error = hash_insert(&names, hash, i)))
+      break;
+  }
+  hash_free(&names);
+  return error;
+}
+
+/* Drop-in file which is parsed by one of the threads of parse_conf_files.
+   fd is the file opened and checked by open_checked with its status st.  */
+struct parse_job {
+  char *path;
+  int fd;
+  struct stat st;
+  econf_file *key_file;
+  econf_err error;
+  uint64_t line_nr;
+};
+
+struct parse_pool {
+  struct parse_job *jobs;
+  /* Contents of the jobs loaded by uring_load_files or NULL */
+  struct file_load *loads;
+  size_t count, next;
+  pthread_mutex_t lock;
+  const char *delim, *comment;
+};
+
+static void *
+parse_worker(void *arg)
+{
+  struct parse_pool *pool = arg;
+
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    size_t i = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+    if (i >= pool->count)
+      return NULL;
+    struct parse_job *job = &pool->jobs[i];
+    if (pool->loads && pool->loads[i].content)
+      job->error = parse_file_r(job->key_file, job->path, pool->loads[i].content,
+				pool->loads[i].length, pool->delim, pool->comment,
+				&job->line_nr);
+    else
+      job->error = read_file_r(job->key_file, job->path, job->fd, &job->st,
+			       pool->delim, pool->comment, &job->line_nr);
+  }
+}
+
+// Run the jobs of pool on threads threads. The calling thread is one of them.
+static void
+run_parse_pool(struct parse_pool *pool, int threads)
+{
+  pthread_t workers[MAX_PARSE_THREADS];
+  sigset_t all, old;
+  int started = 0;
+
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus < 1 ? 1 : cpus > MAX_PARSE_THREADS ? MAX_PARSE_THREADS : (int) cpus;
+  }
+  if ((size_t) threads > pool->count)
+    threads = (int) pool->count;
+
+  /* Signals of the application must not be delivered to the workers */
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  /* If a thread cannot be created the remaining ones do its work */
+  while (started < threads - 1 &&
+	 pthread_create(&workers[started], NULL, parse_worker, pool) == 0)
+    started++;
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  parse_worker(pool);
+  while (started > 0)
+    pthread_join(workers[--started], NULL);
+}
+
+/* Parse the files which are not shadowed on several threads. The files
+   are handled in chunks of PARSE_CHUNK files, so only a bounded number
+   of them is open at a time. The files of a chunk are opened and checked
+   and the callback runs on the calling thread in the order of the files
+   before they are parsed. With io_uring the opened files of a chunk are
+   loaded in one batch before. As in read_conf_files the files are
+   appended in their order and the first error is returned.  */
+static econf_err
+parse_conf_files(econf_ctx *ctx, struct dir_cache *dirs,
+		 econf_file ***key_files, size_t *size,
+		 const struct conf_files *files, const bool *shadowed,
+		 const char *delim, const char *comment,
+		 const bool join_same_entries, const bool python_style,
+		 const int threads,
+		 bool (*callback)(const char *filename, const void *data),
+		 const void *callback_data)
+{
+  struct parse_job jobs[PARSE_CHUNK];
+#ifdef HAVE_LIBURING
+  struct file_load loads[PARSE_CHUNK];
+#endif
+  struct parse_pool pool = { .jobs = jobs, .delim = delim, .comment = comment };
+  econf_err error = ECONF_SUCCESS, check_error = ECONF_SUCCESS;
+  size_t next = 0;
 
-  while(*key_files) {
-    econf_err error;
-    econf_file *tmp = *merged_files;
-    econf_file **double_key_files = key_files+1;
-    char * current_file = basename((*key_files)->path);
-
-    /* key_files are already sorted. If there is a file with the same name with
-       a higher priority, the current file will be ignored.
-       e.g. /usr/etc/shells.d/tcsh will not be merged if /etc/shells.d/tcsh exists.
-    */
-    while (*double_key_files) {
-      char * compare_file = basename((*double_key_files)->path);
-      if (strcmp(current_file, compare_file) == 0) {
+  pthread_mutex_init(&pool.lock, NULL);
+  while (!error && !check_error && next < files->count) {
+    memset(jobs, 0, sizeof(jobs));
+    pool.count = pool.next = 0;
+    pool.loads = NULL;
+
+    /* Files after a file which failed the checks are not parsed */
+    for (; next < files->count && pool.count < PARSE_CHUNK; next++) {
+      struct parse_job *job = &jobs[pool.count];
+      if (shadowed[next])
+	continue;
+      if ((check_error = open_checked(ctx, dirs, files->paths[next], callback,
+				      callback_data, &job->fd, &job->st)))
+	break;
+      if ((job->path = get_absolute_path(files->paths[next], &check_error)) == NULL) {
+	close(job->fd);
+	break;
+      }
+      if ((check_error = econf_newKeyFile_with_options(&job->key_file, ""))) {
+	close(job->fd);
+	free(job->path);
 	break;
       }
-      double_key_files++;
+      job->key_file->join_same_entries = join_same_entries;
+      job->key_file->python_style = python_style;
+      pool.count++;
     }
 
-    if (*double_key_files == NULL) {
-      error = econf_mergeFiles(merged_files, *merged_files, *key_files);
-      if (error || *merged_files == NULL)
-        return error;
-      (*merged_files)->on_merge_delete = 1;
-      if(tmp->on_merge_delete) { econf_free(tmp); }
+#ifdef HAVE_LIBURING
+    if (pool.count >= URING_MIN_FILES) {
+      memset(loads, 0, sizeof(loads));
+      for (size_t i = 0; i < pool.count; i++) {
+	loads[i].fd = jobs[i].fd;
+	loads[i].st = &jobs[i].st;
+	loads[i].arena = &jobs[i].key_file->arena;
+      }
+      uring_load_files(loads, pool.count);
+      pool.loads = loads;
     }
+#endif
 
-    if((*key_files)->on_merge_delete) { econf_free(*key_files); }
+    if (pool.count > 0)
+      run_parse_pool(&pool, threads);
 
-    key_files++;
+    for (size_t i = 0; i < pool.count; i++) {
+      struct parse_job *job = &jobs[i];
+      /* econf_errLocation as after parsing the files one by one */
+      if (!error && (job->error || job->line_nr > 0))
+	error = set_scan_location(ctx, job->path, job->line_nr, job->error);
+      if (!error) {
+	econf_file **tmp = realloc(*key_files, (*size + 1) * sizeof(econf_file *));
+	if (tmp == NULL) {
+	  error = ECONF_NOMEM;
+	} else {
+	  *key_files = tmp;
+	  job->key_file->on_merge_delete = 1;
+	  (*key_files)[(*size) - 1] = job->key_file;
+	  (*key_files)[(*size)++] = NULL;
+	  job->key_file = NULL;
+	}
+      }
+      econf_free(job->key_file);
+      close(job->fd);
+      free(job->path);
+    }
   }
+  pthread_mutex_destroy(&pool.lock);
+  return error ? error : check_error;
+}
 
-  return ECONF_SUCCESS;
+econf_err read_conf_files(econf_ctx *ctx, struct dir_cache *dirs,
+			  econf_file ***key_files, size_t *size,
+			  const struct conf_files *files,
+			  econf_statvec *stats,
+			  const char *delim, const char *comment,
+			  const bool join_same_entries, const bool python_style,
+			  const int parse_threads,
+			  bool (*callback)(const char *filename, const void *data),
+			  const void *callback_data)
+{
+  econf_err error;
+  bool *shadowed = malloc((files->count + 1) * sizeof(bool));
+
+  if (shadowed == NULL)
+    return ECONF_NOMEM;
+  if ((error = find_shadowed(files, shadowed))) {
+    free(shadowed);
+    return error;
+  }
+  /* Like the main config file, the first file is always merged. If there
+     is no main config file this is the first drop-in file.  */
+  if (*size == 1 && files->count > 0)
+    shadowed[0] = false;
+
+  /* The files are recorded before they are read, so that a change while
+     reading them is noticed by econf_isStale.  */
+  for (size_t i = 0; i < files->count && !error; i++) {
+    if (!shadowed[i])
+      error = statvec_add(stats, files->paths[i]);
+  }
+  if (error) {
+    free(shadowed);
+    return error;
+  }
+
+  /* With io_uring the files are loaded in batches before parsing */
+  bool batched = false;
+#ifdef HAVE_LIBURING
+  size_t parse_count = 0;
+  for (size_t i = 0; i < files->count; i++)
+    parse_count += !shadowed[i];
+  batched = parse_count >= URING_MIN_FILES;
+#endif
+
+  if (parse_threads != 1 || batched) {
+    error = parse_conf_files(ctx, dirs, key_files, size, files, shadowed, delim, comment,
+			     join_same_entries, python_style, parse_threads,
+			     callback, callback_data);
+    free(shadowed);
+    return error;
+  }
+
+  for (size_t i = 0; i < files->count && !error; i++) {
+    if (shadowed[i])
+      continue;
+    econf_file *key_file = NULL;
+    econf_file **tmp = realloc(*key_files, (*size + 1) * sizeof(econf_file *));
+    if (tmp == NULL) {
+      error = ECONF_NOMEM;
+      break;
+    }
+    *key_files = tmp;
+    if ((error = econf_newKeyFile_with_options(&key_file, "")) != ECONF_SUCCESS)
+      break;
+    key_file->join_same_entries = join_same_entries;
+    key_file->python_style = python_style;
+    error = read_file_with_callback(ctx, dirs, &key_file, files->paths[i], delim, comment,
+				    callback, callback_data);
+    if (!error && key_file) {
+      key_file->on_merge_delete = 1;
+      (*key_files)[(*size) - 1] = key_file;
+      (*key_files)[(*size)++] = NULL;
+    } else {
+      econf_free(key_file);
+    }
+  }
+  free(shadowed);
+  return error;
+}
+
+/* State of merge_econf_files. The merged entries are kept in a linked
+   list of nodes, so new keys can be inserted after the last entry of their
+   group without moving the following entries. Node 0 is the head of the
+   list, entries without group are inserted after it.  */
+struct kway_node {
+  const struct file_entry *fe;
+  char *value;           /* replaced value if replaced is true */
+  bool replaced;
+  size_t group_id;       /* number of the group in kway.groups */
+  size_t file;           /* number of the file which added the node */
+  size_t value_file;     /* number of the file of the replaced value */
+  size_t next;
+};
+
+struct kway {
+  struct kway_node *nodes;
+  size_t length, tail;
+  /* group names of all files. last is the last node of the group,
+     file the number of the file which added the group */
+  econf_file groups;
+  size_t *last, *file;
+  /* first node of every group/key combination */
+  econf_hashtable keys;
+};
+
+static size_t
+kway_key_hash(size_t group_id, const char *key)
+{
+  return hashstring(key) * 31 + group_id;
+}
+
+static size_t
+kway_find(const struct kway *kw, size_t group_id, const char *key)
+{
+  size_t hash = kway_key_hash(group_id, key), pos;
+  for (size_t n = hash_first(&kw->keys, hash, &pos); n != HASH_EMPTY;
+       n = hash_next(&kw->keys, hash, &pos)) {
+    if (kw->nodes[n].group_id == group_id && !strcmp(kw->nodes[n].fe->key, key))
+      return n;
+  }
+  return HASH_EMPTY;
+}
+
+/* Insert a node for fe after node prev */
+static econf_err
+kway_insert(struct kway *kw, size_t prev, const struct file_entry *fe,
+	    size_t group_id, size_t file)
+{
+  size_t n = kw->length++;
+  struct kway_node *node = &kw->nodes[n];
+  node->fe = fe;
+  node->value = NULL;
+  node->replaced = false;
+  node->group_id = group_id;
+  node->file = file;
+  node->next = kw->nodes[prev].next;
+  kw->nodes[prev].next = n;
+  if (prev == kw->tail)
+    kw->tail = n;
+  kw->last[group_id] = n;
+  if (kway_find(kw, group_id, fe->key) != HASH_EMPTY)
+    return ECONF_SUCCESS;  // the first node wins
+  return hash_insert(&kw->keys, kway_key_hash(group_id, fe->key), n);
+}
+
+/* Merge file number file like econf_mergeFiles(merged, merged, kf) */
+static econf_err
+kway_add(struct kway *kw, econf_file *kf, size_t file)
+{
+  econf_err error = ECONF_SUCCESS;
+  size_t *group_map = malloc((kf->group_count + 1) * sizeof(size_t));
+
+  if (group_map == NULL)
+    return ECONF_NOMEM;
+  for (size_t i = 0; i < kf->group_count; i++) {
+    size_t count = kw->groups.group_count;
+    if (setGroupList(&kw->groups, kf->groups[i], &group_map[i]) == NULL) {
+      free(group_map);
+      return ECONF_NOMEM;
+    }
+    if (kw->groups.group_count > count)
+      kw->last[group_map[i]] = HASH_EMPTY;
+  }
+
+  for (size_t i = 0; i < kf->length && !error; i++) {
+    const struct file_entry *fe = &kf->file_entry[i];
+    size_t group_id = group_map[fe->group_id];
+    bool nogroup = !strcmp(fe->group, KEY_FILE_NULL_VALUE);
+
+    if (kw->last[group_id] == HASH_EMPTY) {
+      // new group: entries without group at the beginning, other ones at the end
+      kw->file[group_id] = file;
+      error = kway_insert(kw, nogroup ? 0 : kw->tail, fe, group_id, file);
+    } else if (kw->file[group_id] == file) {
+      // group which only exists in this file
+      error = kway_insert(kw, nogroup ? kw->last[group_id] : kw->tail, fe, group_id, file);
+    } else {
+      size_t n = kway_find(kw, group_id, fe->key);
+      if (n != HASH_EMPTY && kw->nodes[n].file != file) {
+	kw->nodes[n].value = fe->value;
+	kw->nodes[n].value_file = file;
+	kw->nodes[n].replaced = true;
+      } else {
+	// new key of an existing group
+	error = kway_insert(kw, kw->last[group_id], fe, group_id, file);
+      }
+    }
+  }
+  free(group_map);
+  return error;
+}
+
+/* Entry of a file with on_merge_delete. The strings are taken over. */
+static struct file_entry
+move_file_entry(econf_file *dest_kf, const struct file_entry *fe)
+{
+  struct file_entry moved_fe = *fe;
+  moved_fe.group = setGroupList(dest_kf, fe->group, &moved_fe.group_id);
+  moved_fe.quotes = false;
+  return moved_fe;
+}
+
+econf_err merge_key_files(econf_file **key_files, size_t count, econf_file **merged_file)
+{
+  struct kway kw = { NULL, 1, 0, { 0 }, NULL, NULL, { 0 } };
+  econf_err error = ECONF_NOMEM;
+  size_t entries = 1, groups = 1;
+
+  *merged_file = NULL;
+  for (size_t i = 0; i < count; i++) {
+    entries += key_files[i]->length;
+    groups += key_files[i]->group_count;
+  }
+  kw.nodes = malloc(entries * sizeof(struct kway_node));
+  kw.last = malloc(groups * sizeof(size_t));
+  kw.file = malloc(groups * sizeof(size_t));
+  if (!kw.nodes || !kw.last || !kw.file ||
+      hash_reserve(&kw.keys, entries) || hash_reserve(&kw.groups.group_index, groups))
+    goto out;
+  kw.nodes[0].next = HASH_EMPTY;
+
+  for (size_t i = 0; i < count; i++) {
+    if ((error = kway_add(&kw, key_files[i], i)))
+      goto out;
+  }
+
+  error = ECONF_NOMEM;
+  *merged_file = calloc(1, sizeof(econf_file));
+  if (*merged_file == NULL)
+    goto out;
+  (*merged_file)->delimiter = key_files[0]->delimiter;
+  (*merged_file)->comment = key_files[0]->comment;
+  if ((error = econf_reserve(*merged_file, kw.length - 1)))
+    goto out;
+  struct file_entry *dest = (*merged_file)->file_entry;
+  size_t length = 0;
+  for (size_t n = kw.nodes[0].next; n != HASH_EMPTY; n = kw.nodes[n].next) {
+    struct kway_node *node = &kw.nodes[n];
+    if (key_files[node->file]->on_merge_delete)
+      dest[length] = move_file_entry(*merged_file, node->fe);
+    else
+      dest[length] = cpy_file_entry(*merged_file, *node->fe);
+    if (dest[length].group == NULL) {
+      error = ECONF_NOMEM;
+      goto out;
+    }
+    if (node->replaced) {
+      if (node->value && key_files[node->value_file]->on_merge_delete)
+	dest[length].value = node->value;
+      else
+	dest[length].value = arena_replace(&(*merged_file)->arena, dest[length].value,
+					   node->value ? node->value : "");
+    }
+    length++;
+  }
+  (*merged_file)->length = length;
+  if ((error = key_index_rebuild(*merged_file)))
+    goto out;
+  for (size_t i = 0; i < count; i++) {
+    if (key_files[i]->on_merge_delete)
+      arena_move(&(*merged_file)->arena, &key_files[i]->arena);
+  }
+
+ out:
+  if (error && *merged_file)
+    *merged_file = econf_freeFile(*merged_file);
+  for (size_t i = 0; i < count; i++) {
+    if (key_files[i]->on_merge_delete)
+      econf_free(key_files[i]);
+  }
+  free(kw.nodes);
+  free(kw.last);
+  free(kw.file);
+  hash_free(&kw.keys);
+  free(kw.groups.groups);
+  hash_free(&kw.groups.group_index);
+  arena_free(&kw.groups.arena);
+  return error;
+}
+
+econf_err merge_econf_files(econf_file **key_files, econf_file **merged_files) {
+  size_t count = 0;
+
+  if (*key_files == NULL || merged_files == NULL)
+    return ECONF_ERROR;
+
+  /* shadowed files have already been skipped by read_conf_files */
+  while (key_files[count])
+    count++;
+  if (count == 1) {
+    *merged_files = key_files[0];
+    return ECONF_SUCCESS;
+  }
+  econf_err error = merge_key_files(key_files, count, merged_files);
+  if (*merged_files)
+    (*merged_files)->on_merge_delete = 1;
+  return error;
 }
@@ -24,37 +24,73 @@
 #pragma once
 
 #include "keyfile.h"
+#include "statvec.h"
 
 #include <stddef.h>
 
+struct dir_cache;
+
 /* This file contains the declaration of the functions used by econf_mergeFiles
    to merge the contents of two econf_files.  */
 
 
-/* Insert the content of "etc_file.file_entry" into "fe" if there is no
-   group specified.  */
-size_t insert_nogroup(econf_file *dest_kf, struct file_entry **fe, econf_file *ef);
-
-/* Merge contents from existing usr_file groups */
-size_t merge_existing_groups(econf_file *dest_kf, struct file_entry **fe, econf_file *uf, econf_file *ef,
-                             const size_t etc_start);
+/* Copy the entries of usr_file (uf) and etc_file (ef) into the empty
+   dest_kf. Values of etc_file replace the values of the same group/key in
+   usr_file, new keys of a group are added after the last usr_file entry
+   of this group and groups which only exist in etc_file are added at the
+   end. Entries without group of etc_file are put in front if usr_file
+   starts with a group. The key index of dest_kf is not updated.  */
+econf_err merge_files(econf_file *dest_kf, econf_file *uf, econf_file *ef);
 
-/* Add entries from etc_file exclusive groups */
-size_t add_new_groups(econf_file *dest_kf, struct file_entry **fe,
-		      econf_file *uf, econf_file *ef,
-                      const size_t merge_length);
+/* Merge count files in one pass. The result is the same as merging them
+   one by one with econf_mergeFiles, but every entry is copied only once.
+   Files with on_merge_delete are consumed: their strings are moved into
+   merged_file instead of being copied and they are freed, also in case of
+   an error.  */
+econf_err merge_key_files(econf_file **key_files, size_t count, econf_file **merged_file);
 
 /* Returns the default dirs to iterate through when merging */
 char **get_default_dirs(const char *usr_conf_dir, const char *etc_conf_dir);
 
-/* Receives a list of config directories to look for and calls 'check_conf_dir' */
-econf_err traverse_conf_dirs(econf_file ***key_files, char *conf_dirs[],
-			     size_t *size, const char *path,
-			     const char *config_suffix,
-			     const char *delim, const char *comment,
-			     const bool join_same_entries, const bool python_style,
-			     bool (*callback)(const char *filename, const void *data),
-			     const void *callback_data);
+/* List of the paths of drop-in files in the order of their priority */
+struct conf_files {
+  char **paths;
+  size_t count, alloc;
+};
+
+/* Receives a list of config directories to look for and calls 'check_conf_dir',
+   which adds the files with the given suffix in the directories
+   <path>/<config_name><conf_dir> to files. dir_fd is the opened directory
+   path, the directories are opened relative to it. The directories are
+   recorded in stats, if it is not NULL.  */
+econf_err traverse_conf_dirs(struct conf_files *files, econf_statvec *stats,
+			     char *conf_dirs[],
+			     int dir_fd, const char *path,
+			     const char *config_name, const char *config_suffix);
+
+/* Free the paths of files */
+void free_conf_files(struct conf_files *files);
+
+/* Mark the files which are shadowed by a later file with the same name.
+   e.g. /usr/etc/shells.d/tcsh is not used if /etc/shells.d/tcsh exists.  */
+econf_err find_shadowed(const struct conf_files *files, bool *shadowed);
+
+/* Parse the files which are not shadowed by a later file with the same
+   name and append them to key_files. size is the length of key_files
+   including the NULL at the end. With parse_threads other than 1 the files
+   are parsed in parallel, see the PARSING_THREADS option. If built with
+   liburing, the files are loaded with io_uring. The parsed files are
+   recorded in stats, if it is not NULL. The files are checked with the
+   settings of ctx, which gets the location of an error, their parent
+   directories are kept in dirs.  */
+econf_err read_conf_files(econf_ctx *ctx, struct dir_cache *dirs,
+			  econf_file ***key_files, size_t *size,
+			  const struct conf_files *files, econf_statvec *stats,
+			  const char *delim, const char *comment,
+			  const bool join_same_entries, const bool python_style,
+			  const int parse_threads,
+			  bool (*callback)(const char *filename, const void *data),
+			  const void *callback_data);
 
 /* Merge an array of given econf_files into one */
 econf_err merge_econf_files(econf_file **key_files, econf_file **merged_files);
@@ -9,35 +9,84 @@
 
 #include <libgen.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-econf_err readConfigHistoryWithCallback(econf_file ***key_files,
-					size_t *size,
-					char **parse_dirs,
-					const int parse_dirs_count,
-					const char *config_name,
-					const char *config_suffix,
-					const char *delim,
-					const char *comment,
-					const bool join_same_entries,
-					const bool python_style,
-					char **conf_dirs,
-					const int conf_count,
-					bool (*callback)(const char *filename, const void *data),
-					const void *callback_data)
+/* Open the parse dirs for looking up files relative to them into
+   dir_fds. The fd of a directory which does not exist is -1, its absence
+   is recorded in stats.  */
+static econf_err
+open_parse_dirs(char **parse_dirs, const int parse_dirs_count,
+		econf_statvec *stats, int **dir_fds)
+{
+  econf_err error = ECONF_SUCCESS;
+
+  if ((*dir_fds = malloc((parse_dirs_count + 1) * sizeof(int))) == NULL)
+    return ECONF_NOMEM;
+  for (int i = 0; i < parse_dirs_count; i++) {
+    /* files are searched in "<parse_dir>/", so "" is the root directory */
+    const char *dir = *parse_dirs[i] ? parse_dirs[i] : "/";
+    if (((*dir_fds)[i] = open(dir, O_PATH | O_DIRECTORY | O_CLOEXEC)) < 0 &&
+	(error = open_error(errno)) == ECONF_NOFILE)
+      error = statvec_add_error(stats, dir, errno);
+    if (error) {
+      while (i-- > 0) {
+	if ((*dir_fds)[i] >= 0)
+	  close((*dir_fds)[i]);
+      }
+      free(*dir_fds);
+      *dir_fds = NULL;
+      return error;
+    }
+  }
+  return ECONF_SUCCESS;
+}
+
+static void
+close_parse_dirs(int *dir_fds, const int parse_dirs_count)
+{
+  for (int i = 0; i < parse_dirs_count; i++) {
+    if (dir_fds[i] >= 0)
+      close(dir_fds[i]);
+  }
+  free(dir_fds);
+}
+
+/* readConfigHistoryWithCallback with the parent directories of the
+   files kept in dirs */
+static econf_err
+read_config_history(econf_ctx *ctx, struct dir_cache *dirs,
+		    econf_file ***key_files, size_t *size,
+		    char **parse_dirs, const int parse_dirs_count,
+		    const char *config_name, const char *config_suffix,
+		    const char *delim, const char *comment,
+		    const bool join_same_entries, const bool python_style,
+		    const int parse_threads, char **conf_dirs, const int conf_count,
+		    bool (*callback)(const char *filename, const void *data),
+		    const void *callback_data, econf_statvec *stats)
 {
   const char *suffix = "";
   char *filename, *cp;
   econf_file *key_file = NULL;
   econf_err error = ECONF_SUCCESS;
+  int *dir_fds;
 
   *size = 0;
 
   if (delim == NULL)
     return ECONF_ERROR;
 
+  /* Every parse dir is opened once. Files and directories are looked up
+     relative to it and a missing parse dir is skipped completely.  */
+  if ((error = open_parse_dirs(parse_dirs, parse_dirs_count, stats, &dir_fds)))
+    return error;
+
   if (config_name != NULL && strlen (config_name) != 0)
   {
     /* Reading main configuration file. */
@@ -59,6 +108,10 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
        to parse the "main" configuration file */
     for (int i = parse_dirs_count; i > 0; i--)
     {
+       if (dir_fds[i-1] < 0) {
+	 error = ECONF_NOFILE;
+	 continue;
+       }
        filename = alloca(strlen (parse_dirs[i-1]) + strlen (config_name) +
 			 strlen (suffix) + 2);
        cp = stpcpy (filename, parse_dirs[i-1]);
@@ -66,15 +119,24 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
        cp = stpcpy (cp, config_name);
        stpcpy (cp, suffix);
        if (key_file == NULL) {
-	 if ((error = econf_newKeyFile_with_options(&key_file, "")) != ECONF_SUCCESS)
+	 if ((error = econf_newKeyFile_with_options(&key_file, "")) != ECONF_SUCCESS) {
+	   close_parse_dirs(dir_fds, parse_dirs_count);
            return error;
+	 }
 	 key_file->join_same_entries = join_same_entries;
 	 key_file->python_style = python_style;
        }
-       error = read_file_with_callback(&key_file, filename, delim, comment,
+       /* Also a missing file is recorded, it could be created later on */
+       if ((error = statvec_add(stats, filename)) != ECONF_SUCCESS) {
+	  econf_free(key_file);
+	  close_parse_dirs(dir_fds, parse_dirs_count);
+	  return error;
+       }
+       error = read_file_with_callback(ctx, dirs, &key_file, filename, delim, comment,
 				       callback, callback_data);
        if (error && error != ECONF_NOFILE) {
 	  econf_free(key_file);
+	  close_parse_dirs(dir_fds, parse_dirs_count);
 	  return error;
        }
        if (error == ECONF_SUCCESS)
@@ -90,6 +152,7 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
   *key_files = calloc(*size, sizeof(econf_file*));
   if (*key_files == NULL) {
     econf_freeFile(key_file);
+    close_parse_dirs(dir_fds, parse_dirs_count);
     return ECONF_NOMEM;
   }
 
@@ -115,6 +178,7 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
   {
     free(*key_files);
     *key_files = NULL;
+    close_parse_dirs(dir_fds, parse_dirs_count);
     return ECONF_NOMEM;
   }
 
@@ -125,6 +189,7 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
       free(*key_files);
       *key_files = NULL;
       econf_freeArray(configure_dirs);
+      close_parse_dirs(dir_fds, parse_dirs_count);
       return ECONF_NOMEM;
     }
     cp = stpcpy(suffix_d, suffix);
@@ -140,23 +205,29 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
   }
 
   /* merge all files in e.g. <dist_conf_dir>, <run_conf_dir> and <etc_conf_dir> */
-  for (int i = 0; i < parse_dirs_count; i++) {
-    char *project_path = combine_strings(parse_dirs[i], config_name, '/');
-    error = traverse_conf_dirs(key_files, configure_dirs, size, project_path,
-			       suffix, delim, comment, join_same_entries, python_style,
-			       callback, callback_data);
-    free(project_path);
-    if (error != ECONF_SUCCESS)
+  struct conf_files files = { NULL, 0, 0 };
+  error = ECONF_SUCCESS;
+  for (int i = 0; i < parse_dirs_count && error == ECONF_SUCCESS; i++) {
+    if (dir_fds[i] >= 0)
+      error = traverse_conf_dirs(&files, stats, configure_dirs, dir_fds[i], parse_dirs[i],
+				 config_name, suffix);
+  }
+  close_parse_dirs(dir_fds, parse_dirs_count);
+  if (error == ECONF_SUCCESS)
+    error = read_conf_files(ctx, dirs, key_files, size, &files, stats, delim, comment,
+			    join_same_entries, python_style, parse_threads,
+			    callback, callback_data);
+  free_conf_files(&files);
+  if (error != ECONF_SUCCESS)
+  {
+    for(size_t k = 0; k < *size-1; k++)
     {
-      for(size_t k = 0; k < *size-1; k++)
-      {
-	econf_freeFile((*key_files)[k]);
-      }
-      free(*key_files);
-      *key_files = NULL;
-      econf_freeArray(configure_dirs);
-      return error;
+      econf_freeFile((*key_files)[k]);
     }
+    free(*key_files);
+    *key_files = NULL;
+    econf_freeArray(configure_dirs);
+    return error;
   }
 
   (*size)--;
@@ -172,19 +243,67 @@ econf_err readConfigHistoryWithCallback(econf_file ***key_files,
   return ECONF_SUCCESS;
 }
 
+econf_err readConfigHistoryWithCallback(econf_ctx *ctx,
+					econf_file ***key_files,
+					size_t *size,
+					char **parse_dirs,
+					const int parse_dirs_count,
+					const char *config_name,
+					const char *config_suffix,
+					const char *delim,
+					const char *comment,
+					const bool join_same_entries,
+					const bool python_style,
+					const int parse_threads,
+					char **conf_dirs,
+					const int conf_count,
+					bool (*callback)(const char *filename, const void *data),
+					const void *callback_data,
+					econf_statvec *stats)
+{
+  /* Every parent directory is opened and checked once per call */
+  struct dir_cache dirs = { NULL, 0, 0 };
+  econf_err error;
+
+  error = read_config_history(ctx, &dirs, key_files, size, parse_dirs, parse_dirs_count,
+			      config_name, config_suffix, delim, comment,
+			      join_same_entries, python_style, parse_threads,
+			      conf_dirs, conf_count, callback, callback_data, stats);
+  free_dir_cache(&dirs);
+  return error;
+}
+
+
+// Paths of the files which are merged into the result of readConfigWithCallback
+static char **
+source_list(econf_file **key_files)
+{
+  size_t count = 0;
+  while (key_files[count])
+    count++;
+  char **sources = calloc(count + 1, sizeof(char *));
+  if (sources == NULL)
+    return NULL;
+  for (size_t i = 0; i < count; i++) {
+    sources[i] = strdup(key_files[i]->path ? key_files[i]->path : "");
+    if (sources[i] == NULL)
+      return econf_freeArray(sources);
+  }
+  return sources;
+}
 
-econf_err readConfigWithCallback(econf_file **result,
+econf_err readConfigWithCallback(econf_ctx *ctx,
+				 econf_file **result,
 				 const char *config_name,
 				 const char *config_suffix,
 				 const char *delim,
 				 const char *comment,
-				 char **conf_dirs,
-				 const int conf_count,
 				 bool (*callback)(const char *filename, const void *data),
 				 const void *callback_data)
 {
   size_t size = 0;
   econf_file **key_files = NULL;
+  econf_statvec stats = { NULL, 0, 0 };
   econf_err error = ECONF_SUCCESS;
 
   if (*result == NULL)
@@ -192,7 +311,8 @@ econf_err readConfigWithCallback(econf_file **result,
 
   if ((*result)->conf_count > 0) {
     /* Setting defined in econf_file have higher priority */
-    error = readConfigHistoryWithCallback(&key_files,
+    error = readConfigHistoryWithCallback(ctx,
+					  &key_files,
 					  &size,
 					  (*result)->parse_dirs,
 					  (*result)->parse_dirs_count,
@@ -202,12 +322,15 @@ econf_err readConfigWithCallback(econf_file **result,
 					  comment,
 					  (*result)->join_same_entries,
 					  (*result)->python_style,
+					  (*result)->parse_threads,
 					  (*result)->conf_dirs,
 					  (*result)->conf_count,
 					  callback,
-					  callback_data);
+					  callback_data,
+					  &stats);
   } else {
-    error = readConfigHistoryWithCallback(&key_files,
+    error = readConfigHistoryWithCallback(ctx,
+					  &key_files,
 					  &size,
 					  (*result)->parse_dirs,
 					  (*result)->parse_dirs_count,
@@ -217,22 +340,397 @@ econf_err readConfigWithCallback(econf_file **result,
 					  comment,
 					  (*result)->join_same_entries,
 					  (*result)->python_style,
-					  conf_dirs,
-					  conf_count,
+					  (*result)->parse_threads,
+					  ctx->conf_dirs,
+					  ctx->conf_count,
 					  callback,
-					  callback_data);
+					  callback_data,
+					  &stats);
   }
 
-  if (error != ECONF_SUCCESS)
+  if (error != ECONF_SUCCESS) {
+    statvec_free(&stats);
     return error;
+  }
 
   if (key_files) {
+    char **sources = source_list(key_files);
     econf_free(*result);
     *result = NULL;
     // Merge the list of acquired key_files into merged_file
     error = merge_econf_files(key_files, result);
     free(key_files);
+    if (error == ECONF_SUCCESS && sources == NULL)
+      error = ECONF_NOMEM;
+    if (error == ECONF_SUCCESS) {
+      (*result)->sources = sources;
+      (*result)->stats = stats;
+      stats = (econf_statvec) { NULL, 0, 0 };
+    } else {
+      econf_freeArray(sources);
+      *result = econf_freeFile(*result);
+    }
+  }
+
+  statvec_free(&stats);
+  return error;
+}
+
+/* Main config file and drop-in files of a handle in the order of their
+   priority. The consulted directories and files are recorded in stats.
+   If there is a main config file, it is the first file and main_stat is
+   the number of its entry in stats, otherwise main_stat is SIZE_MAX.  */
+static econf_err
+list_handle_files(econf_handle *handle, struct conf_files *files,
+		  econf_statvec *stats, size_t *main_stat)
+{
+  econf_file *options = handle->options;
+  struct conf_files dropins = { NULL, 0, 0 };
+  const char *suffix = "";
+  char *cp, *suffix_d = NULL;
+  char *default_dirs[2] = { NULL, NULL };
+  char **configure_dirs = options->conf_dirs;
+  bool *shadowed = NULL;
+  econf_err error = ECONF_SUCCESS;
+  int *dir_fds;
+
+  *main_stat = SIZE_MAX;
+  if (handle->config_suffix && *handle->config_suffix) {
+    if (handle->config_suffix[0] == '.') {
+      suffix = handle->config_suffix;
+    } else {
+      cp = alloca(strlen(handle->config_suffix) + 2);
+      cp[0] = '.';
+      strcpy(cp + 1, handle->config_suffix);
+      suffix = cp;
+    }
+  }
+
+  if ((error = open_parse_dirs(options->parse_dirs, options->parse_dirs_count,
+			       stats, &dir_fds)))
+    return error;
+
+  /* the main config file with the highest priority */
+  for (int i = options->parse_dirs_count; i > 0 && !error; i--) {
+    char *filename;
+    if (dir_fds[i-1] < 0)
+      continue;
+    if (asprintf(&filename, "%s/%s%s", options->parse_dirs[i-1],
+		 handle->config_name, suffix) < 0) {
+      error = ECONF_NOMEM;
+      break;
+    }
+    if ((error = statvec_add(stats, filename)) == ECONF_SUCCESS &&
+	stats->entries[stats->count - 1].st.error == 0) {
+      files->paths = malloc(sizeof(char *));
+      if (files->paths == NULL) {
+	free(filename);
+	error = ECONF_NOMEM;
+	break;
+      }
+      files->paths[0] = filename;
+      files->count = files->alloc = 1;
+      *main_stat = stats->count - 1;
+      break;
+    }
+    free(filename);
   }
 
+  /* as in readConfigHistoryWithCallback */
+  if (!error && options->conf_count == 0) {
+    if (asprintf(&suffix_d, "%s.d", suffix) < 0)
+      error = ECONF_NOMEM;
+    default_dirs[0] = suffix_d;
+    configure_dirs = default_dirs;
+  }
+  for (int i = 0; i < options->parse_dirs_count && !error; i++) {
+    if (dir_fds[i] >= 0)
+      error = traverse_conf_dirs(&dropins, stats, configure_dirs, dir_fds[i],
+				 options->parse_dirs[i], handle->config_name, suffix);
+  }
+  close_parse_dirs(dir_fds, options->parse_dirs_count);
+  free(suffix_d);
+
+  if (!error && (shadowed = malloc((dropins.count + 1) * sizeof(bool))) == NULL)
+    error = ECONF_NOMEM;
+  if (!error)
+    error = find_shadowed(&dropins, shadowed);
+  if (!error && files->count == 0 && dropins.count > 0)
+    shadowed[0] = false;
+  if (!error) {
+    char **paths = realloc(files->paths, (files->count + dropins.count + 1) * sizeof(char *));
+    if (paths == NULL) {
+      error = ECONF_NOMEM;
+    } else {
+      files->paths = paths;
+      files->alloc = files->count + dropins.count + 1;
+      /* the paths are taken over */
+      for (size_t i = 0; i < dropins.count; i++) {
+	if (shadowed[i])
+	  continue;
+	files->paths[files->count++] = dropins.paths[i];
+	dropins.paths[i] = NULL;
+      }
+    }
+  }
+  free(shadowed);
+  free_conf_files(&dropins);
   return error;
 }
+
+/* Settings of ctx without its conf dirs and error location */
+static econf_ctx *
+copy_settings(const econf_ctx *ctx)
+{
+  econf_ctx *copy = malloc(sizeof(econf_ctx));
+
+  if (copy == NULL)
+    return NULL;
+  *copy = *ctx;
+  copy->conf_dirs = NULL;
+  copy->conf_count = 0;
+  copy->last_scanned_line_nr = 0;
+  copy->last_scanned_filename = NULL;
+  return copy;
+}
+
+econf_err
+open_handle(econf_ctx *ctx, econf_handle **handle, econf_file *options,
+	    const char *config_name, const char *config_suffix,
+	    const char *delim, const char *comment)
+{
+  econf_err error;
+
+  if (config_name == NULL || *config_name == '\0' || delim == NULL) {
+    econf_freeFile(options);
+    return ECONF_ARGUMENT_IS_NULL_VALUE;
+  }
+  if ((*handle = calloc(1, sizeof(econf_handle))) == NULL) {
+    econf_freeFile(options);
+    return ECONF_NOMEM;
+  }
+  (*handle)->ctx = ctx == &default_ctx ? ctx : NULL;
+  (*handle)->options = options;
+  pthread_mutex_init(&(*handle)->lock, NULL);
+  atomic_init(&(*handle)->current, NULL);
+  atomic_init(&(*handle)->epoch, 0);
+  atomic_init(&(*handle)->readers[0], 0);
+  atomic_init(&(*handle)->readers[1], 0);
+  if (((*handle)->ctx == NULL && ((*handle)->ctx = copy_settings(ctx)) == NULL) ||
+      ((*handle)->config_name = strdup(config_name)) == NULL ||
+      (config_suffix && ((*handle)->config_suffix = strdup(config_suffix)) == NULL) ||
+      ((*handle)->delim = strdup(delim)) == NULL ||
+      (comment && ((*handle)->comment = strdup(comment)) == NULL)) {
+    free_handle(*handle);
+    *handle = NULL;
+    return ECONF_NOMEM;
+  }
+  if ((error = reload_handle(*handle, NULL))) {
+    if ((*handle)->ctx != ctx) {
+      free(ctx->last_scanned_filename);
+      last_scanned_file((*handle)->ctx, &ctx->last_scanned_filename,
+			&ctx->last_scanned_line_nr);
+    }
+    free_handle(*handle);
+    *handle = NULL;
+  }
+  return error;
+}
+
+econf_file *
+handle_acquire(econf_handle *handle)
+{
+  econf_file *key_file;
+  uint64_t epoch;
+
+  /* A reload may advance epoch between loading it and announcing the
+     reader, then the reload does not wait for it.  */
+  for (;;) {
+    epoch = atomic_load(&handle->epoch);
+    atomic_fetch_add(&handle->readers[epoch & 1], 1);
+    if (atomic_load(&handle->epoch) == epoch)
+      break;
+    atomic_fetch_sub(&handle->readers[epoch & 1], 1);
+  }
+  if ((key_file = atomic_load(&handle->current)) != NULL)
+    atomic_fetch_add(&key_file->handle_refs, 1);
+  atomic_fetch_sub(&handle->readers[epoch & 1], 1);
+  return key_file;
+}
+
+void
+handle_release(econf_file *key_file)
+{
+  if (key_file && atomic_fetch_sub(&key_file->handle_refs, 1) == 1)
+    econf_freeFile(key_file);
+}
+
+/* Replace the configuration of handle by key_file and drop the
+   reference of handle to the old one after all readers which may have
+   loaded it hold their own reference.  */
+static void
+publish(econf_handle *handle, econf_file *key_file)
+{
+  atomic_store(&key_file->handle_refs, 1);
+  econf_file *old = atomic_exchange(&handle->current, key_file);
+  if (old == NULL)
+    return;
+  uint64_t epoch = atomic_fetch_add(&handle->epoch, 1);
+  while (atomic_load(&handle->readers[epoch & 1]) != 0)
+    sched_yield();
+  handle_release(old);
+}
+
+static void
+free_handle_files(struct handle_file *files, size_t count)
+{
+  for (size_t i = 0; i < count; i++) {
+    free(files[i].path);
+    econf_freeFile(files[i].key_file);
+  }
+  free(files);
+}
+
+econf_err
+reload_handle(econf_handle *handle, bool *changed)
+{
+  struct conf_files paths = { NULL, 0, 0 };
+  econf_statvec stats = { NULL, 0, 0 };
+  econf_hashtable cached = { NULL, 0, 0 };
+  struct dir_cache dirs = { NULL, 0, 0 };
+  struct handle_file *files = NULL;
+  econf_file **key_files = NULL, *merged = NULL;
+  /* reused[i]: files[i] is taken from the last reload, kept[n]: the
+     parsed file n of the last reload is reused */
+  bool *reused = NULL, *kept = NULL;
+  size_t main_stat;
+  econf_err error;
+
+  if (changed)
+    *changed = false;
+  pthread_mutex_lock(&handle->lock);
+  /* nothing has been changed since the last reload */
+  econf_file *current = atomic_load(&handle->current);
+  if (current && !statvec_changed(&current->stats)) {
+    pthread_mutex_unlock(&handle->lock);
+    return ECONF_SUCCESS;
+  }
+
+  if ((error = list_handle_files(handle, &paths, &stats, &main_stat)))
+    goto out;
+  if (paths.count == 0) {
+    error = ECONF_NOFILE;
+    goto out;
+  }
+  files = calloc(paths.count, sizeof(struct handle_file));
+  key_files = calloc(paths.count + 1, sizeof(econf_file *));
+  reused = calloc(paths.count + handle->count, sizeof(bool));
+  if (files == NULL || key_files == NULL || reused == NULL ||
+      (error = hash_reserve(&cached, handle->count))) {
+    error = ECONF_NOMEM;
+    goto out;
+  }
+  kept = reused + paths.count;
+  for (size_t i = 0; i < handle->count; i++) {
+    if ((error = hash_insert(&cached, hashstring(handle->files[i].path), i)))
+      goto out;
+  }
+
+  for (size_t i = 0; i < paths.count; i++) {
+    struct handle_file *file = &files[i];
+    size_t hash = hashstring(paths.paths[i]), pos;
+
+    /* recorded before reading, like readConfigWithCallback does. The
+       main file has been recorded by list_handle_files already.  */
+    size_t stat_nr = i == 0 && main_stat != SIZE_MAX ? main_stat : stats.count;
+    if (stat_nr == stats.count && (error = statvec_add(&stats, paths.paths[i])))
+      goto out;
+    file->st = stats.entries[stat_nr].st;
+    file->path = paths.paths[i];
+    paths.paths[i] = NULL;
+
+    /* an unchanged file is taken from the last reload */
+    for (size_t n = hash_first(&cached, hash, &pos); n != HASH_EMPTY;
+	 n = hash_next(&cached, hash, &pos)) {
+      struct handle_file *old = &handle->files[n];
+      if (!strcmp(old->path, file->path) &&
+	  !memcmp(&old->st, &file->st, sizeof(file->st))) {
+	file->key_file = old->key_file;
+	reused[i] = kept[n] = true;
+	break;
+      }
+    }
+    if (file->key_file == NULL) {
+      if ((error = econf_newKeyFile_with_options(&file->key_file, "")))
+	goto out;
+      file->key_file->join_same_entries = handle->options->join_same_entries;
+      file->key_file->python_style = handle->options->python_style;
+      if ((error = read_file_with_callback(handle->ctx, &dirs, &file->key_file,
+					   file->path, handle->delim, handle->comment,
+					   NULL, NULL)))
+	goto out;
+    }
+    key_files[i] = file->key_file;
+  }
+
+  /* the cached files are copied, not consumed */
+  if ((error = merge_key_files(key_files, paths.count, &merged)))
+    goto out;
+  if ((merged->sources = source_list(key_files)) == NULL) {
+    error = ECONF_NOMEM;
+    goto out;
+  }
+  merged->stats = stats;
+  stats = (econf_statvec) { NULL, 0, 0 };
+
+  /* files which have been changed or removed */
+  for (size_t n = 0; n < handle->count; n++) {
+    if (kept[n])
+      handle->files[n].key_file = NULL;
+  }
+  free_handle_files(handle->files, handle->count);
+  handle->files = files;
+  handle->count = paths.count;
+  publish(handle, merged);
+  files = NULL;
+  merged = NULL;
+  if (changed)
+    *changed = true;
+
+ out:
+  /* the files taken from the last reload are still part of handle */
+  if (files) {
+    for (size_t i = 0; i < paths.count; i++) {
+      if (reused && reused[i])
+	files[i].key_file = NULL;
+    }
+    free_handle_files(files, paths.count);
+  }
+  econf_freeFile(merged);
+  free(reused);
+  free(key_files);
+  hash_free(&cached);
+  free_dir_cache(&dirs);
+  statvec_free(&stats);
+  free_conf_files(&paths);
+  pthread_mutex_unlock(&handle->lock);
+  return error;
+}
+
+void
+free_handle(econf_handle *handle)
+{
+  if (handle == NULL)
+    return;
+  free_handle_files(handle->files, handle->count);
+  handle_release(atomic_load(&handle->current));
+  pthread_mutex_destroy(&handle->lock);
+  if (handle->ctx != &default_ctx)
+    econf_freeCtx(handle->ctx);
+  econf_freeFile(handle->options);
+  free(handle->config_name);
+  free(handle->config_suffix);
+  free(handle->delim);
+  free(handle->comment);
+  free(handle);
+}
@@ -3,8 +3,18 @@
 
 #include "libeconf.h"
 #include "keyfile.h"
+#include "statvec.h"
 
-extern econf_err readConfigHistoryWithCallback(econf_file ***key_files,
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* Read the main config file and the drop-in files into key_files.
+   The consulted files and directories are recorded in stats, which
+   may be NULL. The files are checked with the settings of ctx, which
+   gets the location of an error.  */
+extern econf_err readConfigHistoryWithCallback(econf_ctx *ctx,
+					       econf_file ***key_files,
 					       size_t *size,
 					       char **parse_dirs,
 					       const int parse_dirs_count,
@@ -14,17 +24,76 @@ extern econf_err readConfigHistoryWithCallback(econf_file ***key_files,
 					       const char *comment,
 					       const bool join_same_entries,
 					       const bool python_style,
+					       const int parse_threads,
 					       char **conf_dirs,
 					       const int conf_count,
 					       bool (*callback)(const char *filename, const void *data),
-					       const void *callback_data);
+					       const void *callback_data,
+					       econf_statvec *stats);
+
+/* Parsed file of a reloadable handle with its identity at the time it
+   has been parsed.  */
+struct handle_file {
+  char *path;
+  struct file_stat st;
+  econf_file *key_file;
+};
+
+/* Reloadable configuration, see econf_openConfig. The parsed files are
+   kept in the order of their priority, econf_reload parses only the
+   changed ones again and publishes the merged result in current.
+
+   Readers never lock: handle_acquire announces itself in readers[] of
+   the parity of epoch while it loads current and takes a reference.
+   A reload replaces current, advances epoch and waits until all
+   readers of the previous parity are gone. Afterwards nobody can take a
+   new reference to the old configuration, it is freed by the release of
+   its last reference.  */
+struct econf_handle {
+  /* settings which are used for every reload, default_ctx or a copy
+     owned by the handle */
+  econf_ctx *ctx;
+  /* parse_dirs, conf_dirs and the options of econf_newKeyFile_with_options */
+  econf_file *options;
+  char *config_name, *config_suffix, *delim, *comment;
+  /* files and count are only used by reload_handle under lock */
+  struct handle_file *files;
+  size_t count;
+  pthread_mutex_t lock;
+  _Atomic(econf_file *) current;
+  _Atomic uint64_t epoch;
+  atomic_size_t readers[2];
+};
+
+/* Create a handle for the parse dirs and conf dirs of options, which is
+   taken over also in case of an error, and load it. The files are read
+   with a copy of the settings of ctx, default_ctx is used directly.
+   The location of an error of the first load is stored in ctx.  */
+extern econf_err open_handle(econf_ctx *ctx, econf_handle **handle,
+			     econf_file *options,
+			     const char *config_name, const char *config_suffix,
+			     const char *delim, const char *comment);
+
+/* Parse the files which have been changed since the last call and merge
+   them again. changed may be NULL.  */
+extern econf_err reload_handle(econf_handle *handle, bool *changed);
+
+/* Return a reference to the current configuration of handle, which is
+   valid until it is released by handle_release.  */
+extern econf_file *handle_acquire(econf_handle *handle);
+
+extern void handle_release(econf_file *key_file);
+
+/* Free handle, the configuration is freed with its last reference */
+extern void free_handle(econf_handle *handle);
 
-extern econf_err readConfigWithCallback(econf_file **result,
+/* Read the configuration of the parse dirs of result and merge it into
+   result. The conf dirs of ctx are used if result has none.  */
+extern econf_err readConfigWithCallback(econf_ctx *ctx,
+					econf_file **result,
 					const char *config_name,
 					const char *config_suffix,
 					const char *delim,
 					const char *comment,
-					char **conf_dirs,
-					const int conf_count,
 					bool (*callback)(const char *filename, const void *data),
 					const void *callback_data);
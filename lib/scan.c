@@ -0,0 +1,198 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define SCAN_X86 1
+#  include <immintrin.h>
+#endif
+
+/* Build the ranges of structural bytes. If there are too many of them,
+   neighbouring ranges with the smallest gap are joined.  */
+void
+scan_init(econf_scanner *scanner, const unsigned char *cc)
+{
+  int n = 0, c = 0;
+  unsigned char lo[256], hi[256];
+
+  while (c <= 255) {
+    if (!cc[c]) {
+      c++;
+      continue;
+    }
+    lo[n] = (unsigned char) c;
+    while (c < 255 && cc[c + 1])
+      c++;
+    hi[n++] = (unsigned char) c++;
+  }
+
+  while (n > SCAN_MAX_RANGES) {
+    int best = 0;
+    for (int i = 1; i < n - 1; i++) {
+      if (lo[i + 1] - hi[i] < lo[best + 1] - hi[best])
+	best = i;
+    }
+    hi[best] = hi[best + 1];
+    memmove(lo + best + 1, lo + best + 2, (size_t) (n - best - 2));
+    memmove(hi + best + 1, hi + best + 2, (size_t) (n - best - 2));
+    n--;
+  }
+
+  scanner->cc = cc;
+  scanner->ranges = n;
+  memcpy(scanner->lo, lo, (size_t) n);
+  memcpy(scanner->hi, hi, (size_t) n);
+
+  scanner->kernel = scan_scalar;
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    scanner->kernel = scan_avx2;
+  else if (__builtin_cpu_supports("sse2"))
+    scanner->kernel = scan_sse2;
+#endif
+}
+
+uint64_t *
+scan_buffer(const econf_scanner *scanner, const char *buf, size_t length)
+{
+  uint64_t *bits = malloc((length / 64 + 1) * sizeof(uint64_t));
+
+  if (bits != NULL)
+    scanner->kernel(scanner, buf, length, bits);
+  return bits;
+}
+
+/* Bitmap of up to 64 bytes, using the character class table */
+static uint64_t
+scan_word(const unsigned char *cc, const char *buf, size_t length)
+{
+  uint64_t w = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    if (cc[(unsigned char) buf[i]])
+      w |= (uint64_t) 1 << i;
+  }
+  return w;
+}
+
+void
+scan_scalar(const econf_scanner *scanner, const char *buf, size_t length,
+	    uint64_t *bits)
+{
+  for (size_t i = 0; i < length; i += 64)
+    *bits++ = scan_word(scanner->cc, buf + i, length - i < 64 ? length - i : 64);
+}
+
+#ifdef SCAN_X86
+
+/* A byte x is in [lo, hi] if (x - lo) <= (hi - lo) for unsigned bytes,
+   i.e. if min(x - lo, hi - lo) == x - lo.  */
+
+__attribute__((target("sse2"))) static inline uint64_t
+scan_sse2_16(const __m128i *lo, const __m128i *width, int ranges, const char *buf)
+{
+  __m128i x = _mm_loadu_si128((const __m128i *) (const void *) buf);
+  __m128i match = _mm_setzero_si128();
+
+  for (int i = 0; i < ranges; i++) {
+    __m128i d = _mm_sub_epi8(x, lo[i]);
+    match = _mm_or_si128(match, _mm_cmpeq_epi8(_mm_min_epu8(d, width[i]), d));
+  }
+  return (uint16_t) _mm_movemask_epi8(match);
+}
+
+__attribute__((target("sse2"))) void
+scan_sse2(const econf_scanner *scanner, const char *buf, size_t length,
+	  uint64_t *bits)
+{
+  __m128i lo[SCAN_MAX_RANGES], width[SCAN_MAX_RANGES];
+  size_t i;
+
+  for (int r = 0; r < scanner->ranges; r++) {
+    lo[r] = _mm_set1_epi8((char) scanner->lo[r]);
+    width[r] = _mm_set1_epi8((char) (scanner->hi[r] - scanner->lo[r]));
+  }
+
+  for (i = 0; i + 64 <= length; i += 64) {
+    *bits++ = scan_sse2_16(lo, width, scanner->ranges, buf + i) |
+      scan_sse2_16(lo, width, scanner->ranges, buf + i + 16) << 16 |
+      scan_sse2_16(lo, width, scanner->ranges, buf + i + 32) << 32 |
+      scan_sse2_16(lo, width, scanner->ranges, buf + i + 48) << 48;
+  }
+  *bits = scan_word(scanner->cc, buf + i, length - i);
+}
+
+__attribute__((target("avx2"))) static inline uint64_t
+scan_avx2_32(const __m256i *lo, const __m256i *width, int ranges, const char *buf)
+{
+  __m256i x = _mm256_loadu_si256((const __m256i *) (const void *) buf);
+  __m256i match = _mm256_setzero_si256();
+
+  for (int i = 0; i < ranges; i++) {
+    __m256i d = _mm256_sub_epi8(x, lo[i]);
+    match = _mm256_or_si256(match, _mm256_cmpeq_epi8(_mm256_min_epu8(d, width[i]), d));
+  }
+  return (uint32_t) _mm256_movemask_epi8(match);
+}
+
+__attribute__((target("avx2"))) void
+scan_avx2(const econf_scanner *scanner, const char *buf, size_t length,
+	  uint64_t *bits)
+{
+  __m256i lo[SCAN_MAX_RANGES], width[SCAN_MAX_RANGES];
+  size_t i;
+
+  for (int r = 0; r < scanner->ranges; r++) {
+    lo[r] = _mm256_set1_epi8((char) scanner->lo[r]);
+    width[r] = _mm256_set1_epi8((char) (scanner->hi[r] - scanner->lo[r]));
+  }
+
+  for (i = 0; i + 64 <= length; i += 64) {
+    *bits++ = scan_avx2_32(lo, width, scanner->ranges, buf + i) |
+      scan_avx2_32(lo, width, scanner->ranges, buf + i + 32) << 32;
+  }
+  *bits = scan_word(scanner->cc, buf + i, length - i);
+}
+
+#else
+
+void
+scan_sse2(const econf_scanner *scanner, const char *buf, size_t length,
+	  uint64_t *bits)
+{
+  scan_scalar(scanner, buf, length, bits);
+}
+
+void
+scan_avx2(const econf_scanner *scanner, const char *buf, size_t length,
+	  uint64_t *bits)
+{
+  scan_scalar(scanner, buf, length, bits);
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+/* --- scan.h --- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Search a buffer for the structural characters of the parser, i.e. all
+   bytes with a class in its character class table (whitespace,
+   delimiters, comments, quotes, newline and null byte). The result is a
+   bitmap with one bit per byte, so the parser only has to look at these
+   positions. The bitmap can contain more bits than needed, but never
+   misses a structural character.
+
+   The kernels use SSE2 or AVX2 if the CPU supports it. They test every
+   byte against a few ranges of byte values, which are derived from the
+   character class table by scan_init.  */
+
+#define SCAN_MAX_RANGES 8
+
+typedef struct econf_scanner {
+  /* Character class table, a byte is structural if its entry is not 0 */
+  const unsigned char *cc;
+  /* Structural bytes are in [lo[i], hi[i]] */
+  unsigned char lo[SCAN_MAX_RANGES], hi[SCAN_MAX_RANGES];
+  int ranges;
+  void (*kernel)(const struct econf_scanner *scanner, const char *buf,
+		 size_t length, uint64_t *bits);
+} econf_scanner;
+
+/* Set up the ranges for the table cc (256 entries) and choose the
+   fastest kernel for this CPU.  */
+void scan_init(econf_scanner *scanner, const unsigned char *cc);
+
+/* Return the bitmap of buf, which has to be freed by the caller.
+   Returns NULL if there is not enough memory.  */
+uint64_t *scan_buffer(const econf_scanner *scanner, const char *buf, size_t length);
+
+/* Kernels which write the bitmap of buf into bits, which has room for
+   length / 64 + 1 elements. Kernels not supported by the compiler or
+   CPU are replaced by scan_scalar.  */
+void scan_scalar(const econf_scanner *scanner, const char *buf, size_t length,
+		 uint64_t *bits);
+void scan_sse2(const econf_scanner *scanner, const char *buf, size_t length,
+	       uint64_t *bits);
+void scan_avx2(const econf_scanner *scanner, const char *buf, size_t length,
+	       uint64_t *bits);
+
+/* Return the position of the first bit set at or after pos, or length if
+   there is none.  */
+static inline size_t
+scan_next(const uint64_t *bits, size_t pos, size_t length)
+{
+  size_t word = pos / 64;
+  uint64_t w;
+
+  if (pos >= length)
+    return length;
+  w = bits[word] & (~(uint64_t) 0 << (pos % 64));
+  while (w == 0) {
+    if (++word >= (length + 63) / 64)
+      return length;
+    w = bits[word];
+  }
+#ifdef __GNUC__
+  pos = word * 64 + (size_t) __builtin_ctzll(w);
+#else
+  for (pos = word * 64; !(w & 1); w >>= 1)
+    pos++;
+#endif
+  return pos < length ? pos : length;
+}
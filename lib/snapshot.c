@@ -0,0 +1,616 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "libeconf.h"
+#include "defines.h"
+#include "getfilecontents.h"
+#include "helpers.h"
+#include "keyfile.h"
+#include "snapshot.h"
+#include "strbuf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_ALIGN(offset) (((offset) + 7) & ~(uint64_t) 7)
+
+/* Hash value of the group/key combination in the hash table of a
+   snapshot. The group name is part of it, so a lookup does not have to
+   find the number of the group first.  */
+static uint32_t
+snapshot_hash(const char *group, size_t group_len, const char *key)
+{
+  uint32_t hash = 5381;
+  for (size_t i = 0; i < group_len; i++)
+    hash = ((hash << 5) + hash) + (unsigned char) group[i];
+  hash = (hash << 5) + hash;
+  while (*key)
+    hash = ((hash << 5) + hash) + (unsigned char) *key++;
+  return hash;
+}
+
+/* Pointer to the table at offset of the snapshot */
+static const void *
+snapshot_table(const void *snapshot, uint32_t offset)
+{
+  return (const char *) snapshot + offset;
+}
+
+/* String table of a snapshot which is being written */
+struct string_table {
+  econf_strbuf data;
+  /* Maps the hash value of a string to its offset in data */
+  econf_hashtable index;
+};
+
+/* Add str to the string table if it is not already part of it */
+static econf_err
+add_string(struct string_table *st, const char *str, uint32_t *offset)
+{
+  size_t hash, pos, len;
+
+  if (str == NULL) {
+    *offset = SNAPSHOT_NULL;
+    return ECONF_SUCCESS;
+  }
+  hash = hashstring(str);
+  for (size_t n = hash_first(&st->index, hash, &pos); n != HASH_EMPTY;
+       n = hash_next(&st->index, hash, &pos)) {
+    if (!strcmp(st->data.data + n, str)) {
+      *offset = n;
+      return ECONF_SUCCESS;
+    }
+  }
+  len = strlen(str) + 1;
+  if (st->data.length + len >= SNAPSHOT_NULL)
+    return ECONF_WRITEERROR;
+  *offset = st->data.length;
+  if (strbuf_append(&st->data, str, len))
+    return ECONF_NOMEM;
+  return hash_insert(&st->index, hash, *offset);
+}
+
+/* Write the size bytes of image to a temporary file which is renamed to
+   file_name.  */
+static econf_err
+write_image(const char *file_name, const void *image, size_t size)
+{
+  char *tmp_name = NULL;
+  int fd;
+
+  if (asprintf(&tmp_name, "%s.XXXXXX", file_name) < 0)
+    return ECONF_NOMEM;
+  if ((fd = mkstemp(tmp_name)) < 0) {
+    free(tmp_name);
+    return ECONF_WRITEERROR;
+  }
+  /* the snapshot is meant to be read by every process */
+  bool ok = fchmod(fd, 0644) == 0;
+  while (ok && size > 0) {
+    ssize_t n = write(fd, image, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      ok = false;
+      break;
+    }
+    image = (const char *) image + n;
+    size -= n;
+  }
+  ok = ok && fsync(fd) == 0;
+  ok = close(fd) == 0 && ok;
+  ok = ok && rename(tmp_name, file_name) == 0;
+  if (!ok)
+    unlink(tmp_name);
+  free(tmp_name);
+  return ok ? ECONF_SUCCESS : ECONF_WRITEERROR;
+}
+
+econf_err
+write_snapshot(econf_file *kf, const char *file_name)
+{
+  struct string_table st = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+  struct snapshot_header header;
+  struct snapshot_entry *entries = NULL;
+  uint32_t *groups = NULL, *sources = NULL, *hash = NULL;
+  struct snapshot_stat *stats = NULL;
+  char *image = NULL;
+  const char *path_source[2] = { kf->path, NULL };
+  const char * const *source_names =
+    kf->sources ? (const char * const *) kf->sources : path_source;
+  size_t source_count = 0, hash_size = 8;
+  econf_err error = ECONF_SUCCESS;
+
+  /* unchanged snapshot */
+  if (kf->snapshot)
+    return write_image(file_name, kf->snapshot, kf->snapshot_size);
+
+  if (kf->length >= SNAPSHOT_NULL || kf->group_count >= SNAPSHOT_NULL ||
+      kf->stats.count >= SNAPSHOT_NULL)
+    return ECONF_WRITEERROR;
+  while (source_names[source_count])
+    source_count++;
+  while (hash_size < 2 * kf->length)
+    hash_size *= 2;
+
+  entries = calloc(kf->length ? kf->length : 1, sizeof(struct snapshot_entry));
+  groups = calloc(kf->group_count + 1, sizeof(uint32_t));
+  sources = calloc(source_count + 1, sizeof(uint32_t));
+  stats = calloc(kf->stats.count + 1, sizeof(struct snapshot_stat));
+  hash = malloc(hash_size * sizeof(uint32_t));
+  if (entries == NULL || groups == NULL || sources == NULL || stats == NULL ||
+      hash == NULL) {
+    error = ECONF_NOMEM;
+    goto out;
+  }
+
+  for (size_t g = 0; g < kf->group_count && !error; g++)
+    error = add_string(&st, kf->groups[g], &groups[g]);
+  for (size_t s = 0; s < source_count && !error; s++)
+    error = add_string(&st, source_names[s], &sources[s]);
+  for (size_t s = 0; s < kf->stats.count && !error; s++) {
+    stats[s].st = kf->stats.entries[s].st;
+    error = add_string(&st, kf->stats.entries[s].path, &stats[s].path);
+  }
+  memset(hash, 0xff, hash_size * sizeof(uint32_t));
+  for (size_t i = 0; i < kf->length && !error; i++) {
+    struct file_entry *fe = &kf->file_entry[i];
+    struct snapshot_entry *se = &entries[i];
+    size_t first;
+
+    se->line_number = fe->line_number;
+    se->group = fe->group_id;
+    se->quotes = fe->quotes;
+    if ((error = add_string(&st, fe->key, &se->key)) ||
+	(error = add_string(&st, fe->value, &se->value)) ||
+	(error = add_string(&st, fe->comment_before_key, &se->comment_before_key)) ||
+	(error = add_string(&st, fe->comment_after_value, &se->comment_after_value)))
+      break;
+    /* like the key index, the hash table only contains the first entry
+       of every group/key combination */
+    if (find_group_key(kf, fe->group_id, fe->key, &first) || first != i)
+      continue;
+    const char *group = kf->groups[fe->group_id];
+    size_t pos = snapshot_hash(group, strlen(group), fe->key) & (hash_size - 1);
+    while (hash[pos] != SNAPSHOT_NULL)
+      pos = (pos + 1) & (hash_size - 1);
+    hash[pos] = i;
+  }
+  if (error)
+    goto out;
+
+  uint64_t offset = sizeof(header);
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.delimiter = kf->delimiter;
+  header.comment = kf->comment;
+  header.entry_offset = offset;
+  header.entry_count = kf->length;
+  offset = SNAPSHOT_ALIGN(offset + kf->length * sizeof(struct snapshot_entry));
+  header.group_offset = offset;
+  header.group_count = kf->group_count;
+  offset = SNAPSHOT_ALIGN(offset + kf->group_count * sizeof(uint32_t));
+  header.source_offset = offset;
+  header.source_count = source_count;
+  offset = SNAPSHOT_ALIGN(offset + source_count * sizeof(uint32_t));
+  header.stat_offset = offset;
+  header.stat_count = kf->stats.count;
+  offset = SNAPSHOT_ALIGN(offset + kf->stats.count * sizeof(struct snapshot_stat));
+  header.hash_offset = offset;
+  header.hash_size = hash_size;
+  offset = SNAPSHOT_ALIGN(offset + hash_size * sizeof(uint32_t));
+  header.string_offset = offset;
+  header.string_size = st.data.length;
+  header.size = offset + st.data.length;
+  if (header.size >= SNAPSHOT_NULL) {
+    error = ECONF_WRITEERROR;
+    goto out;
+  }
+
+  if ((image = calloc(1, header.size)) == NULL) {
+    error = ECONF_NOMEM;
+    goto out;
+  }
+  memcpy(image, &header, sizeof(header));
+  memcpy(image + header.entry_offset, entries, kf->length * sizeof(struct snapshot_entry));
+  memcpy(image + header.group_offset, groups, kf->group_count * sizeof(uint32_t));
+  memcpy(image + header.source_offset, sources, source_count * sizeof(uint32_t));
+  memcpy(image + header.stat_offset, stats,
+	 kf->stats.count * sizeof(struct snapshot_stat));
+  memcpy(image + header.hash_offset, hash, hash_size * sizeof(uint32_t));
+  if (st.data.length)
+    memcpy(image + header.string_offset, st.data.data, st.data.length);
+  error = write_image(file_name, image, header.size);
+
+ out:
+  free(image);
+  free(entries);
+  free(groups);
+  free(sources);
+  free(stats);
+  free(hash);
+  strbuf_free(&st.data);
+  hash_free(&st.index);
+  return error;
+}
+
+/* A table of count elements of size bytes has to be within the
+   snapshot.  */
+static bool
+valid_table(const struct snapshot_header *header, uint32_t offset,
+	    uint64_t count, size_t size)
+{
+  return offset % 8 == 0 && offset >= sizeof(*header) && offset <= header->size &&
+    count * size <= header->size - offset;
+}
+
+static bool
+valid_string(const struct snapshot_header *header, uint32_t offset, bool nullable)
+{
+  return offset == SNAPSHOT_NULL ? nullable : offset < header->string_size;
+}
+
+/* Check that the size bytes of snapshot are a snapshot of this version
+   which only refers to data within these size bytes.  */
+static econf_err
+check_snapshot(const void *snapshot, size_t size)
+{
+  const struct snapshot_header *header = snapshot;
+
+  if (size < sizeof(*header) ||
+      memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) ||
+      header->version != SNAPSHOT_VERSION ||
+      header->byte_order != SNAPSHOT_BYTE_ORDER ||
+      header->size != size)
+    return ECONF_PARSE_ERROR;
+  if (!valid_table(header, header->entry_offset, header->entry_count,
+		   sizeof(struct snapshot_entry)) ||
+      !valid_table(header, header->group_offset, header->group_count, sizeof(uint32_t)) ||
+      !valid_table(header, header->source_offset, header->source_count, sizeof(uint32_t)) ||
+      !valid_table(header, header->stat_offset, header->stat_count,
+		   sizeof(struct snapshot_stat)) ||
+      !valid_table(header, header->hash_offset, header->hash_size, sizeof(uint32_t)) ||
+      !valid_table(header, header->string_offset, header->string_size, 1))
+    return ECONF_PARSE_ERROR;
+  /* a power of two with room for every entry */
+  if (header->hash_size <= header->entry_count ||
+      (header->hash_size & (header->hash_size - 1)))
+    return ECONF_PARSE_ERROR;
+
+  const char *strings = snapshot_table(snapshot, header->string_offset);
+  if (header->string_size > 0 && strings[header->string_size - 1] != '\0')
+    return ECONF_PARSE_ERROR;
+  const uint32_t *groups = snapshot_table(snapshot, header->group_offset);
+  for (uint32_t g = 0; g < header->group_count; g++) {
+    if (!valid_string(header, groups[g], false))
+      return ECONF_PARSE_ERROR;
+  }
+  const uint32_t *sources = snapshot_table(snapshot, header->source_offset);
+  for (uint32_t s = 0; s < header->source_count; s++) {
+    if (!valid_string(header, sources[s], false))
+      return ECONF_PARSE_ERROR;
+  }
+  const struct snapshot_stat *stats = snapshot_table(snapshot, header->stat_offset);
+  for (uint32_t s = 0; s < header->stat_count; s++) {
+    if (!valid_string(header, stats[s].path, false))
+      return ECONF_PARSE_ERROR;
+  }
+  const struct snapshot_entry *entries = snapshot_table(snapshot, header->entry_offset);
+  for (uint32_t i = 0; i < header->entry_count; i++) {
+    const struct snapshot_entry *se = &entries[i];
+    if (se->group >= header->group_count ||
+	!valid_string(header, se->key, false) ||
+	!valid_string(header, se->value, true) ||
+	!valid_string(header, se->comment_before_key, true) ||
+	!valid_string(header, se->comment_after_value, true))
+      return ECONF_PARSE_ERROR;
+  }
+  /* Every entry is in at most one slot, so there is at least one free
+     slot, otherwise a lookup of a missing key would not end.  */
+  const uint32_t *hash = snapshot_table(snapshot, header->hash_offset);
+  unsigned char *used = calloc(header->entry_count / 8 + 1, 1);
+  econf_err error = ECONF_SUCCESS;
+  if (used == NULL)
+    return ECONF_NOMEM;
+  for (uint32_t h = 0; h < header->hash_size && !error; h++) {
+    if (hash[h] == SNAPSHOT_NULL)
+      continue;
+    if (hash[h] >= header->entry_count || (used[hash[h] / 8] & (1 << hash[h] % 8)))
+      error = ECONF_PARSE_ERROR;
+    else
+      used[hash[h] / 8] |= 1 << hash[h] % 8;
+  }
+  free(used);
+  return error;
+}
+
+/* Copy the string at offset of the string table into the arena of kf.
+   Every entry gets its own copy, because arena_replace may overwrite
+   it later on.  */
+static econf_err
+copy_string(econf_file *kf, const char *strings, uint32_t offset, char **result)
+{
+  if (offset == SNAPSHOT_NULL) {
+    *result = NULL;
+    return ECONF_SUCCESS;
+  }
+  *result = arena_strdup(&kf->arena, strings + offset);
+  return *result ? ECONF_SUCCESS : ECONF_NOMEM;
+}
+
+/* Fill kf with the entries of the checked snapshot */
+static econf_err
+load_snapshot(econf_file *kf, const void *snapshot)
+{
+  const struct snapshot_header *header = snapshot;
+  const struct snapshot_entry *entries = snapshot_table(snapshot, header->entry_offset);
+  const uint32_t *groups = snapshot_table(snapshot, header->group_offset);
+  const uint32_t *sources = snapshot_table(snapshot, header->source_offset);
+  const struct snapshot_stat *stats = snapshot_table(snapshot, header->stat_offset);
+  const char *strings = snapshot_table(snapshot, header->string_offset);
+  econf_err error;
+
+  for (uint32_t g = 0; g < header->group_count; g++) {
+    size_t id;
+    if (setGroupList(kf, strings + groups[g], &id) == NULL)
+      return ECONF_NOMEM;
+    /* the group numbers of the entries refer to the order of the table */
+    if (id != g)
+      return ECONF_PARSE_ERROR;
+  }
+
+  if ((error = key_file_reserve(kf, header->entry_count)))
+    return error;
+  for (uint32_t i = 0; i < header->entry_count; i++) {
+    const struct snapshot_entry *se = &entries[i];
+    struct file_entry *fe = &kf->file_entry[i];
+
+    fe->group_id = se->group;
+    fe->group = kf->groups[se->group];
+    fe->line_number = se->line_number;
+    fe->quotes = se->quotes;
+    if ((error = copy_string(kf, strings, se->key, &fe->key)) ||
+	(error = copy_string(kf, strings, se->value, &fe->value)) ||
+	(error = copy_string(kf, strings, se->comment_before_key,
+			     &fe->comment_before_key)) ||
+	(error = copy_string(kf, strings, se->comment_after_value,
+			     &fe->comment_after_value)))
+      return error;
+    kf->length++;
+  }
+
+  if ((kf->sources = calloc(header->source_count + 1, sizeof(char *))) == NULL)
+    return ECONF_NOMEM;
+  for (uint32_t s = 0; s < header->source_count; s++) {
+    if ((kf->sources[s] = strdup(strings + sources[s])) == NULL)
+      return ECONF_NOMEM;
+  }
+  for (uint32_t s = 0; s < header->stat_count; s++) {
+    if ((error = statvec_add_error(&kf->stats, strings + stats[s].path, 0)))
+      return error;
+    kf->stats.entries[s].st = stats[s].st;
+  }
+
+  return key_index_rebuild(kf);
+}
+
+econf_err
+read_snapshot(const econf_ctx *ctx, econf_file *kf, const char *file_name)
+{
+  struct stat sb;
+  void *snapshot;
+  econf_err error;
+  int fd;
+
+  /* the checked file is mapped */
+  if ((error = open_checked(ctx, NULL, file_name, NULL, NULL, &fd, &sb)))
+    return error;
+  if (!S_ISREG(sb.st_mode)) {
+    close(fd);
+    return ECONF_NOFILE;
+  }
+  if (sb.st_size < (off_t) sizeof(struct snapshot_header) ||
+      (uint64_t) sb.st_size >= SNAPSHOT_NULL) {
+    close(fd);
+    return ECONF_PARSE_ERROR;
+  }
+  snapshot = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (snapshot == MAP_FAILED)
+    return ECONF_NOMEM;
+
+  if ((error = check_snapshot(snapshot, sb.st_size)) ||
+      (error = setPath(kf, file_name))) {
+    munmap(snapshot, sb.st_size);
+    return error;
+  }
+  const struct snapshot_header *header = snapshot;
+  kf->delimiter = header->delimiter;
+  kf->comment = header->comment;
+  kf->snapshot = snapshot;
+  kf->snapshot_size = sb.st_size;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+snapshot_materialize(econf_file *kf)
+{
+  econf_err error;
+
+  if (kf->snapshot == NULL)
+    return ECONF_SUCCESS;
+  if ((error = load_snapshot(kf, kf->snapshot)))
+    return error;
+  snapshot_unmap(kf);
+  return ECONF_SUCCESS;
+}
+
+void
+snapshot_unmap(econf_file *kf)
+{
+  if (kf->snapshot == NULL)
+    return;
+  /* the mapping is read-only, munmap does not take a const pointer */
+  munmap((void *) (uintptr_t) kf->snapshot, kf->snapshot_size);
+  kf->snapshot = NULL;
+  kf->snapshot_size = 0;
+}
+
+const struct snapshot_entry *
+snapshot_entry(const econf_file *kf, size_t num)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  const struct snapshot_entry *entries = snapshot_table(kf->snapshot, header->entry_offset);
+  return &entries[num];
+}
+
+const char *
+snapshot_string(const econf_file *kf, uint32_t offset)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  if (offset == SNAPSHOT_NULL)
+    return NULL;
+  return (const char *) snapshot_table(kf->snapshot, header->string_offset) + offset;
+}
+
+/* Name of group number g */
+static const char *
+group_name(const econf_file *kf, uint32_t g)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  const uint32_t *groups = snapshot_table(kf->snapshot, header->group_offset);
+  return snapshot_string(kf, groups[g]);
+}
+
+econf_err
+snapshot_find_key(const econf_file *kf, const char *group, size_t group_len,
+		  const char *key, size_t *num)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  const uint32_t *hash = snapshot_table(kf->snapshot, header->hash_offset);
+  size_t mask = header->hash_size - 1;
+
+  for (size_t pos = snapshot_hash(group, group_len, key) & mask;
+       hash[pos] != SNAPSHOT_NULL; pos = (pos + 1) & mask) {
+    const struct snapshot_entry *se = snapshot_entry(kf, hash[pos]);
+    const char *name = group_name(kf, se->group);
+    if (!strncmp(name, group, group_len) && name[group_len] == '\0' &&
+	!strcmp(snapshot_string(kf, se->key), key)) {
+      *num = hash[pos];
+      return ECONF_SUCCESS;
+    }
+  }
+  return ECONF_NOKEY;
+}
+
+const struct snapshot_stat *
+snapshot_stats(const econf_file *kf, size_t *count)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  *count = header->stat_count;
+  return snapshot_table(kf->snapshot, header->stat_offset);
+}
+
+bool
+snapshot_stale(const econf_file *kf)
+{
+  size_t count;
+  const struct snapshot_stat *stats = snapshot_stats(kf, &count);
+
+  for (size_t s = 0; s < count; s++) {
+    if (file_stat_changed(snapshot_string(kf, stats[s].path), &stats[s].st))
+      return true;
+  }
+  return false;
+}
+
+econf_err
+snapshot_get_groups(const econf_file *kf, size_t *length, char ***groups)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  size_t count = 0;
+
+  if (header->group_count == 0)
+    return ECONF_NOGROUP;
+  *groups = NULL;
+  *length = 0;
+  for (uint32_t g = 0; g < header->group_count; g++) {
+    if (strcmp(group_name(kf, g), KEY_FILE_NULL_VALUE))
+      count++;
+  }
+  if (count == 0)
+    return ECONF_SUCCESS;
+  if ((*groups = calloc(count + 1, sizeof(char *))) == NULL)
+    return ECONF_NOMEM;
+  for (uint32_t g = 0; g < header->group_count; g++) {
+    const char *name = group_name(kf, g);
+    if (!strcmp(name, KEY_FILE_NULL_VALUE))
+      continue;
+    if (((*groups)[*length] = strdup(name)) == NULL) {
+      *groups = econf_freeArray(*groups);
+      *length = 0;
+      return ECONF_NOMEM;
+    }
+    (*length)++;
+  }
+  return ECONF_SUCCESS;
+}
+
+econf_err
+snapshot_get_keys(const econf_file *kf, const char *group, size_t *length,
+		  char ***keys)
+{
+  const struct snapshot_header *header = kf->snapshot;
+  uint32_t g = 0;
+  size_t count = 0;
+
+  while (g < header->group_count && strcmp(group_name(kf, g), group))
+    g++;
+  for (uint32_t i = 0; i < header->entry_count; i++) {
+    if (snapshot_entry(kf, i)->group == g)
+      count++;
+  }
+  if (count == 0)
+    return ECONF_NOKEY;
+  if ((*keys = calloc(count + 1, sizeof(char *))) == NULL)
+    return ECONF_NOMEM;
+  for (uint32_t i = 0, k = 0; i < header->entry_count; i++) {
+    const struct snapshot_entry *se = snapshot_entry(kf, i);
+    if (se->group != g)
+      continue;
+    if (((*keys)[k++] = strdup(snapshot_string(kf, se->key))) == NULL) {
+      *keys = econf_freeArray(*keys);
+      return ECONF_NOMEM;
+    }
+  }
+  if (length != NULL)
+    *length = count;
+  return ECONF_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+/* --- snapshot.h --- */
+
+#include "libeconf.h"
+#include "statvec.h"
+
+#include <stdint.h>
+
+/* A snapshot is the binary image of an econf_file written by
+   econf_compileConfig. It is read by econf_openSnapshot without parsing
+   any config file.
+
+   Layout (all numbers in host byte order, every table 8 byte aligned):
+     struct snapshot_header
+     struct snapshot_entry   entries[entry_count]
+     uint32_t                groups[group_count]   string offsets
+     uint32_t                sources[source_count] string offsets
+     struct snapshot_stat    stats[stat_count]
+     uint32_t                hash[hash_size]       entry numbers
+     char                    strings[string_size]  null terminated strings
+
+   Strings are referenced by their offset in the string table, equal
+   strings are stored only once. SNAPSHOT_NULL stands for a NULL string.
+   hash is an open addressing table (linear probing, hash_size is a power
+   of two) of the first entry of every group/key combination, see
+   snapshot_hash. sources are the paths of the files the configuration
+   has been read from, stats the files and directories which have been
+   consulted with their identity at that time (see econf_isStale).
+
+   econf_openSnapshot maps the snapshot read-only and shared, so all
+   processes using it share the same pages. Lookups are done on the
+   mapping, the entries are only copied into file_entry if the econf_file
+   is changed (see snapshot_materialize). Snapshots are replaced by
+   renaming, so a mapping never changes.  */
+
+#define SNAPSHOT_MAGIC "ECONFSNP"
+#define SNAPSHOT_VERSION 2
+/* Written in host byte order, so snapshots of other machines are refused */
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_NULL UINT32_MAX
+
+struct snapshot_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  /* size of the whole snapshot */
+  uint64_t size;
+  uint32_t entry_offset, entry_count;
+  uint32_t group_offset, group_count;
+  uint32_t source_offset, source_count;
+  uint32_t stat_offset, stat_count;
+  uint32_t hash_offset, hash_size;
+  uint32_t string_offset, string_size;
+  char delimiter, comment;
+  char reserved[6];
+};
+
+struct snapshot_entry {
+  uint64_t line_number;
+  /* number of the group in the group table */
+  uint32_t group;
+  uint32_t key, value, comment_before_key, comment_after_value;
+  uint8_t quotes;
+  uint8_t reserved[3];
+};
+
+struct snapshot_stat {
+  struct file_stat st;
+  uint32_t path;
+  uint32_t reserved;
+};
+
+/* Write key_file to file_name. The snapshot is written to a temporary
+   file first which replaces file_name afterwards, so readers never see a
+   partly written snapshot.  */
+econf_err write_snapshot(econf_file *key_file, const char *file_name);
+
+/* Map the snapshot file_name into the empty key_file. The file is
+   checked with the security settings of ctx.
+   Returns ECONF_PARSE_ERROR if it is no valid snapshot.  */
+econf_err read_snapshot(const econf_ctx *ctx, econf_file *key_file,
+			const char *file_name);
+
+/* Copy the entries of the snapshot mapped by key_file into its
+   file_entry array and unmap it, so key_file can be changed. Does
+   nothing if key_file does not map a snapshot.  */
+econf_err snapshot_materialize(econf_file *key_file);
+
+/* Unmap the snapshot of key_file without copying its entries */
+void snapshot_unmap(econf_file *key_file);
+
+/* Entry num of the mapped snapshot of key_file and its strings.
+   snapshot_string returns NULL for SNAPSHOT_NULL.  */
+const struct snapshot_entry *snapshot_entry(const econf_file *key_file, size_t num);
+const char *snapshot_string(const econf_file *key_file, uint32_t offset);
+
+/* Same as find_key for a mapped snapshot. group does not have to be
+   null terminated.  */
+econf_err snapshot_find_key(const econf_file *key_file, const char *group,
+			    size_t group_len, const char *key, size_t *num);
+
+/* Recorded files of the mapped snapshot of key_file, see statvec.h */
+const struct snapshot_stat *snapshot_stats(const econf_file *key_file, size_t *count);
+
+/* Same as statvec_changed for the stats of a mapped snapshot */
+bool snapshot_stale(const econf_file *key_file);
+
+/* Same as econf_getGroups and econf_getKeys for a mapped snapshot */
+econf_err snapshot_get_groups(const econf_file *key_file, size_t *length,
+			      char ***groups);
+econf_err snapshot_get_keys(const econf_file *key_file, const char *group,
+			    size_t *length, char ***keys);
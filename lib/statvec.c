@@ -0,0 +1,138 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "statvec.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Only these fields are compared */
+#define STATVEC_MASK (STATX_INO | STATX_MTIME | STATX_SIZE)
+
+static void
+get_file_stat(int dir_fd, const char *path, int flags, struct file_stat *st)
+{
+  struct statx stx;
+
+  memset(st, 0, sizeof(*st));
+  if (statx(dir_fd, path, flags, STATVEC_MASK, &stx) < 0) {
+    st->error = errno;
+    return;
+  }
+  st->dev = ((uint64_t) stx.stx_dev_major << 32) | stx.stx_dev_minor;
+  st->ino = stx.stx_ino;
+  st->size = stx.stx_size;
+  st->mtime_sec = stx.stx_mtime.tv_sec;
+  st->mtime_nsec = stx.stx_mtime.tv_nsec;
+}
+
+/* Append a new element for path and return it */
+static struct stat_entry *
+new_entry(econf_statvec *sv, const char *path)
+{
+  if (sv->count == sv->alloc) {
+    size_t alloc = sv->alloc ? sv->alloc * 2 : 16;
+    struct stat_entry *entries = realloc(sv->entries, alloc * sizeof(struct stat_entry));
+    if (entries == NULL)
+      return NULL;
+    sv->entries = entries;
+    sv->alloc = alloc;
+  }
+  struct stat_entry *entry = &sv->entries[sv->count];
+  if ((entry->path = strdup(path)) == NULL)
+    return NULL;
+  sv->count++;
+  return entry;
+}
+
+econf_err
+statvec_add(econf_statvec *sv, const char *path)
+{
+  struct stat_entry *entry;
+
+  if (sv == NULL)
+    return ECONF_SUCCESS;
+  if ((entry = new_entry(sv, path)) == NULL)
+    return ECONF_NOMEM;
+  get_file_stat(AT_FDCWD, path, AT_STATX_SYNC_AS_STAT, &entry->st);
+  return ECONF_SUCCESS;
+}
+
+econf_err
+statvec_add_fd(econf_statvec *sv, const char *path, int fd)
+{
+  struct stat_entry *entry;
+
+  if (sv == NULL)
+    return ECONF_SUCCESS;
+  if ((entry = new_entry(sv, path)) == NULL)
+    return ECONF_NOMEM;
+  get_file_stat(fd, "", AT_EMPTY_PATH | AT_STATX_SYNC_AS_STAT, &entry->st);
+  return ECONF_SUCCESS;
+}
+
+econf_err
+statvec_add_error(econf_statvec *sv, const char *path, int error)
+{
+  struct stat_entry *entry;
+
+  if (sv == NULL)
+    return ECONF_SUCCESS;
+  if ((entry = new_entry(sv, path)) == NULL)
+    return ECONF_NOMEM;
+  memset(&entry->st, 0, sizeof(entry->st));
+  entry->st.error = error;
+  return ECONF_SUCCESS;
+}
+
+bool
+file_stat_changed(const char *path, const struct file_stat *st)
+{
+  struct file_stat current;
+
+  get_file_stat(AT_FDCWD, path, AT_STATX_SYNC_AS_STAT, &current);
+  return memcmp(&current, st, sizeof(current)) != 0;
+}
+
+bool
+statvec_changed(const econf_statvec *sv)
+{
+  for (size_t i = 0; i < sv->count; i++) {
+    if (file_stat_changed(sv->entries[i].path, &sv->entries[i].st))
+      return true;
+  }
+  return false;
+}
+
+void
+statvec_free(econf_statvec *sv)
+{
+  for (size_t i = 0; i < sv->count; i++)
+    free(sv->entries[i].path);
+  free(sv->entries);
+  sv->entries = NULL;
+  sv->count = sv->alloc = 0;
+}
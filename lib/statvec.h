@@ -0,0 +1,75 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+/* --- statvec.h --- */
+
+#include "libeconf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Stat vector of the files and directories consulted by econf_readConfig.
+   Every element holds the identity of a path at the time it was consulted,
+   before it has been read. econf_isStale compares it with the current
+   identity, so any change afterwards is noticed.
+
+   Paths which did not exist are recorded with their error (ENOENT,
+   ENOTDIR), because the result relies on their absence, too.  */
+
+/* Identity of a path. The layout is fixed, it is part of snapshots.  */
+struct file_stat {
+  uint64_t dev, ino, size;
+  int64_t mtime_sec;
+  uint32_t mtime_nsec;
+  /* errno of statx or 0 */
+  int32_t error;
+};
+
+typedef struct econf_statvec {
+  struct stat_entry {
+    char *path;
+    struct file_stat st;
+  } *entries;
+  size_t count, alloc;
+} econf_statvec;
+
+/* Record the current identity of path. Nothing is done if sv is NULL.  */
+econf_err statvec_add(econf_statvec *sv, const char *path);
+
+/* Record the identity of path which is opened as fd */
+econf_err statvec_add_fd(econf_statvec *sv, const char *path, int fd);
+
+/* Record that path could not be opened because of error (an errno) */
+econf_err statvec_add_error(econf_statvec *sv, const char *path, int error);
+
+/* Has the identity of path changed since st has been recorded? */
+bool file_stat_changed(const char *path, const struct file_stat *st);
+
+/* Has any path of sv changed? */
+bool statvec_changed(const econf_statvec *sv);
+
+/* Free all elements of sv */
+void statvec_free(econf_statvec *sv);
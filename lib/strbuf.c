@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "strbuf.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRBUF_MIN_SIZE 256
+
+econf_err
+strbuf_append(econf_strbuf *sb, const char *str, size_t len)
+{
+  if (len >= SIZE_MAX - sb->length)
+    return ECONF_NOMEM;
+  if (sb->length + len + 1 > sb->size) {
+    size_t size = sb->size ? sb->size : STRBUF_MIN_SIZE;
+    while (size < sb->length + len + 1)
+      size = size > SIZE_MAX / 2 ? sb->length + len + 1 : size * 2;
+    char *data = realloc(sb->data, size);
+    if (data == NULL)
+      return ECONF_NOMEM;
+    sb->data = data;
+    sb->size = size;
+  }
+  memcpy(sb->data + sb->length, str, len);
+  sb->length += len;
+  sb->data[sb->length] = '\0';
+  return ECONF_SUCCESS;
+}
+
+void
+strbuf_free(econf_strbuf *sb)
+{
+  free(sb->data);
+  sb->data = NULL;
+  sb->length = sb->size = 0;
+}
@@ -0,0 +1,45 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+/* --- strbuf.h --- */
+
+#include "libeconf.h"
+
+#include <stddef.h>
+
+/* Growing string buffer. Appending is amortized O(1) per byte, so
+   strings which are built from many pieces (e.g. multiline values) do
+   not have to be copied again for every piece.  */
+
+typedef struct econf_strbuf {
+  char *data;     /* null terminated if length > 0 */
+  size_t length, size;
+} econf_strbuf;
+
+/* Append len bytes of str. */
+econf_err strbuf_append(econf_strbuf *sb, const char *str, size_t len);
+
+/* Free the buffer and reset sb to an empty string. */
+void strbuf_free(econf_strbuf *sb);
@@ -0,0 +1,106 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+
+#include "uring.h"
+
+#include <liburing.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+/* Size of the submission queue, one entry per file of a batch */
+#define URING_ENTRIES 64
+
+/* Submit the prepared entries and wait until all of them are completed.
+   result[user_data] is set to the result of each entry. Returns false if
+   not all entries could be submitted.  */
+static bool
+submit_and_reap(struct io_uring *ring, unsigned count, int *result)
+{
+  struct io_uring_cqe *cqe;
+  int submitted = io_uring_submit_and_wait(ring, count);
+
+  if (submitted < 0)
+    return false;
+  for (int i = 0; i < submitted; i++) {
+    if (io_uring_wait_cqe(ring, &cqe) < 0)
+      return false;
+    result[cqe->user_data] = cqe->res;
+    io_uring_cqe_seen(ring, cqe);
+  }
+  return (unsigned) submitted == count;
+}
+
+/* Load up to URING_ENTRIES files. Returns false if the ring cannot be
+   used anymore.  */
+static bool
+load_batch(struct io_uring *ring, struct file_load *files, size_t count)
+{
+  struct io_uring_sqe *sqe;
+  int nread[URING_ENTRIES];
+  char *buf[URING_ENTRIES];
+  unsigned reads = 0;
+  bool ok = true;
+
+  /* One byte more than the size is read to see that the file did not grow.
+     An entry is only taken if it is prepared, everything which has been
+     taken is submitted.  */
+  for (size_t i = 0; i < count; i++) {
+    const struct stat *st = files[i].st;
+    buf[i] = NULL;
+    nread[i] = -1;
+    if (!S_ISREG(st->st_mode) || (uint64_t) st->st_size >= UINT32_MAX - 1 ||
+	(buf[i] = arena_alloc(files[i].arena, st->st_size + 2)) == NULL ||
+	(sqe = io_uring_get_sqe(ring)) == NULL)
+      continue;
+    io_uring_prep_read(sqe, files[i].fd, buf[i], st->st_size + 1, 0);
+    sqe->user_data = i;
+    reads++;
+  }
+  if (reads > 0)
+    ok = submit_and_reap(ring, reads, nread);
+
+  for (size_t i = 0; i < count; i++) {
+    if (buf[i] != NULL && nread[i] >= 0 && nread[i] <= files[i].st->st_size) {
+      buf[i][nread[i]] = '\0';
+      files[i].content = buf[i];
+      files[i].length = nread[i];
+    }
+  }
+  return ok;
+}
+
+void
+uring_load_files(struct file_load *files, size_t count)
+{
+  struct io_uring ring;
+
+  if (io_uring_queue_init(URING_ENTRIES, &ring, 0) < 0)
+    return;
+  for (size_t i = 0; i < count; i += URING_ENTRIES) {
+    if (!load_batch(&ring, files + i, count - i < URING_ENTRIES ? count - i : URING_ENTRIES))
+      break;
+  }
+  io_uring_queue_exit(&ring);
+}
@@ -0,0 +1,58 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+
+#pragma once
+
+/* --- uring.h --- */
+
+#include "arena.h"
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+/* A config file which is loaded into memory before it is parsed. fd is
+   the opened file with its status st, it stays open.  */
+struct file_load {
+  int fd;
+  const struct stat *st;
+  /* The content is allocated in arena */
+  econf_arena *arena;
+  /* Null terminated content of the file and its length. content is NULL
+     if the file has not been loaded, it has to be read the usual way
+     then.  */
+  char *content;
+  size_t length;
+};
+
+/* Below this number of files setting up a ring does not pay off */
+#define URING_MIN_FILES 4
+
+#ifdef HAVE_LIBURING
+/* Load count opened files with io_uring. The reads of a batch of files
+   are submitted at once. Files which cannot be loaded this way (e.g.
+   because they are no regular files or changed in between) are left
+   unloaded, as are all files if io_uring is not available. Errors are
+   reported by the usual way of reading the file.  */
+void uring_load_files(struct file_load *files, size_t count);
+#endif
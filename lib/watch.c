@@ -0,0 +1,115 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "watch.h"
+#include "keyfile.h"
+#include "snapshot.h"
+
+#include <errno.h>
+#include <libgen.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/* Changes of an existing file or directory and of the entries of a
+   directory */
+#define WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | \
+		    IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | \
+		    IN_MOVE_SELF | IN_MASK_ADD)
+/* Creation of a missing path below a parent directory */
+#define WATCH_PARENT_MASK (IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | \
+			   IN_MOVE_SELF | IN_ONLYDIR | IN_MASK_ADD)
+
+static econf_err
+watch_error(int error)
+{
+  return error == ENOMEM ? ECONF_NOMEM : ECONF_ERROR;
+}
+
+/* Watch path or, if it does not exist, the nearest existing parent */
+static econf_err
+watch_path(int fd, const char *path)
+{
+  char *dir;
+
+  if (inotify_add_watch(fd, path, WATCH_MASK) >= 0)
+    return ECONF_SUCCESS;
+  if (errno != ENOENT && errno != ENOTDIR && errno != EACCES)
+    return watch_error(errno);
+
+  if ((dir = strdup(path)) == NULL)
+    return ECONF_NOMEM;
+  for (;;) {
+    char *parent = dirname(dir);
+    if (inotify_add_watch(fd, parent, WATCH_PARENT_MASK) >= 0)
+      break;
+    /* "/" and "." always exist, but may not be accessible */
+    if ((errno != ENOENT && errno != ENOTDIR) || !strcmp(parent, "/") ||
+	!strcmp(parent, ".")) {
+      int error = errno;
+      free(dir);
+      return watch_error(error);
+    }
+    /* dirname may return a static string, the result is copied */
+    memmove(dir, parent, strlen(parent) + 1);
+  }
+  free(dir);
+  return ECONF_SUCCESS;
+}
+
+/* Read the pending events of the non blocking inotify instance fd */
+static void
+drain_events(int fd)
+{
+  char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+  }
+}
+
+econf_err
+watch_key_file(const econf_file *kf, int fd)
+{
+  const struct snapshot_stat *stats = NULL;
+  econf_err error = ECONF_SUCCESS;
+  size_t count = kf->stats.count;
+
+  if (kf->snapshot)
+    stats = snapshot_stats(kf, &count);
+  if (count == 0)
+    return ECONF_NOFILE;
+
+  drain_events(fd);
+  for (size_t i = 0; i < count && !error; i++) {
+    if (stats)
+      error = watch_path(fd, snapshot_string(kf, stats[i].path));
+    else
+      error = watch_path(fd, kf->stats.entries[i].path);
+  }
+  return error;
+}
@@ -0,0 +1,132 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testhelpers.h"
+
+int
+write_file(const char *path, const char *content)
+{
+  FILE *f;
+
+  if ((f = fopen(path, "w")) == NULL || fputs(content, f) < 0 || fclose(f)) {
+    fprintf (stderr, "ERROR: couldn't write %s\n", path);
+    return 1;
+  }
+  return 0;
+}
+
+static int
+remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+  (void) sb;
+  (void) flag;
+  (void) ftw;
+  remove(path);
+  return 0;
+}
+
+void
+remove_tree(const char *path)
+{
+  nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+econf_err
+read_config(econf_file **key_file, const char *options,
+	    bool (*callback)(const char *filename, const void *data))
+{
+  econf_err error;
+
+  *key_file = NULL;
+  if ((error = econf_newKeyFile_with_options(key_file, options)))
+    return error;
+  error = econf_readConfigWithCallback(key_file, "foo", "/usr/etc", "bar", "conf",
+				       "=", "#", callback, NULL);
+  if (error)
+    *key_file = econf_freeFile(*key_file);
+  return error;
+}
+
+econf_file *
+parse_buffer(const char *data, size_t length)
+{
+  econf_file *key_file = NULL;
+  econf_err error = econf_readBuffer(&key_file, data, length, "=", "#");
+
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readBuffer returned: %s\n", econf_errString(error));
+    return NULL;
+  }
+  return key_file;
+}
+
+int
+check_value(econf_file *key_file, const char *group, const char *key,
+	    const char *expected)
+{
+  char *value = NULL;
+  econf_err error = econf_getStringValue(key_file, group, key, &value);
+
+  if (expected == NULL ? error != ECONF_NOKEY :
+      error || value == NULL || strcmp(value, expected)) {
+    fprintf (stderr, "ERROR: %s/%s: expected <%s>, got <%s>: %s\n", group, key,
+	     expected ? expected : "missing", value, econf_errString(error));
+    free(value);
+    return 1;
+  }
+  free(value);
+  return 0;
+}
+
+int
+compare_files(econf_file *expected, econf_file *key_file)
+{
+  char **exp_groups = NULL, **groups = NULL;
+  size_t exp_len = 0, len = 0;
+  econf_err exp_error, error;
+  int ret = 0;
+
+  exp_error = econf_getGroups(expected, &exp_len, &exp_groups);
+  error = econf_getGroups(key_file, &len, &groups);
+  if (exp_error != error || exp_len != len) {
+    fprintf (stderr, "ERROR: different number of groups\n");
+    ret = 1;
+  }
+  /* The last round compares the entries without group */
+  for (size_t i = 0; !ret && i <= len; i++) {
+    const char *group = i < len ? groups[i] : NULL;
+    char **exp_keys = NULL, **keys = NULL;
+    size_t exp_key_len = 0, key_len = 0;
+
+    exp_error = econf_getKeys(expected, group, &exp_key_len, &exp_keys);
+    error = econf_getKeys(key_file, group, &key_len, &keys);
+    if ((group && strcmp(exp_groups[i], group)) || exp_error != error ||
+	exp_key_len != key_len) {
+      fprintf (stderr, "ERROR: group %s differs\n", group ? group : "(none)");
+      ret = 1;
+    }
+    for (size_t k = 0; !ret && k < key_len; k++) {
+      char *exp_value = NULL, *value = NULL;
+      if (strcmp(exp_keys[k], keys[k]) ||
+	  econf_getStringValue(expected, group, keys[k], &exp_value) ||
+	  econf_getStringValue(key_file, group, keys[k], &value) ||
+	  strcmp(exp_value, value)) {
+	fprintf (stderr, "ERROR: %s/%s differs\n", group ? group : "(none)", keys[k]);
+	ret = 1;
+      }
+      free(exp_value);
+      free(value);
+    }
+    econf_freeArray(exp_keys);
+    econf_freeArray(keys);
+  }
+  econf_freeArray(exp_groups);
+  econf_freeArray(groups);
+  return ret;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libeconf.h"
+
+/* Helpers shared by the tests which create configurations at runtime.
+   They print an error message on failure.  */
+
+/* Write content into the file path. Returns 1 on error.  */
+int write_file(const char *path, const char *content);
+
+/* Remove path with everything in it. A missing path is ignored.  */
+void remove_tree(const char *path);
+
+/* econf_readConfigWithCallback of foo/bar.conf in /usr/etc with the
+   given options of econf_newKeyFile_with_options. callback may be NULL.
+   key_file is NULL on error.  */
+econf_err read_config(econf_file **key_file, const char *options,
+		      bool (*callback)(const char *filename, const void *data));
+
+/* econf_readBuffer of length bytes of data, NULL on error */
+econf_file *parse_buffer(const char *data, size_t length);
+
+/* The value of group/key must be expected, expected NULL means that
+   the key must not exist. Returns 1 otherwise.  */
+int check_value(econf_file *key_file, const char *group, const char *key,
+		const char *expected);
+
+/* Both files must have the same groups, keys and values in the same
+   order. Returns 1 otherwise.  */
+int compare_files(econf_file *expected, econf_file *key_file);
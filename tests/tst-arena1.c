@@ -0,0 +1,86 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Values built from many lines and values which are overwritten
+   with shorter and longer strings must keep their content.
+*/
+
+#define LINES 40
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  char expected[LINES * 10] = "", buf[512];
+  char *value = NULL;
+  int ret = 0;
+
+  error = econf_readFile(&key_file, TESTSDIR "tst-arena1-data/multiline.conf", "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  for (int i = 0; i < LINES; i++) {
+    snprintf(buf, sizeof(buf), i ? "\n  line%d" : "line%d", i);
+    strcat(expected, buf);
+  }
+  if ((error = econf_getStringValue(key_file, "", "key", &value)) ||
+      strcmp(value, expected)) {
+    fprintf (stderr, "ERROR: multiline value: expected <%s>, got <%s>: %s\n",
+	     expected, value, econf_errString(error));
+    ret = 1;
+    goto out;
+  }
+  free(value);
+  value = NULL;
+
+  if ((error = econf_getStringValue(key_file, "", "other", &value)) ||
+      strcmp(value, "value")) {
+    fprintf (stderr, "ERROR: other: got <%s>: %s\n", value, econf_errString(error));
+    ret = 1;
+    goto out;
+  }
+  free(value);
+  value = NULL;
+
+  /* shrink and grow the same value again and again */
+  for (int i = 0; i < 200; i++) {
+    memset(buf, 'a' + i % 26, sizeof(buf));
+    buf[(i * 37) % (sizeof(buf) - 1)] = '\0';
+    if ((error = econf_setStringValue(key_file, "", "key", buf))) {
+      fprintf (stderr, "ERROR: couldn't set key: %s\n", econf_errString(error));
+      ret = 1;
+      goto out;
+    }
+    if ((error = econf_getStringValue(key_file, "", "key", &value)) ||
+	strcmp(value, buf)) {
+      fprintf (stderr, "ERROR: key: expected <%s>, got <%s>: %s\n",
+	       buf, value, econf_errString(error));
+      ret = 1;
+      goto out;
+    }
+    free(value);
+    value = NULL;
+  }
+
+  if ((error = econf_getStringValue(key_file, "", "other", &value)) ||
+      strcmp(value, "value")) {
+    fprintf (stderr, "ERROR: other has been changed: got <%s>: %s\n", value,
+	     econf_errString(error));
+    ret = 1;
+  }
+
+ out:
+  free(value);
+  econf_free(key_file);
+  return ret;
+}
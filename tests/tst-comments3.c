@@ -0,0 +1,80 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+
+   more than one comment and delimiter character
+
+*/
+
+static int
+check_key(econf_file *key_file, char *key, char *expected_val)
+{
+  char *val = NULL;
+  econf_err error = econf_getStringValue (key_file, "", key, &val);
+  if (expected_val == NULL)
+    {
+      if (error == ECONF_NOKEY)
+	return 0;
+
+      fprintf (stderr, "ERROR: %s has value \"%s\"\n", key, val);
+      free (val);
+      return 1;
+    }
+  if (val == NULL)
+    {
+      fprintf (stderr, "ERROR: %s returns nothing! (%s)\n", key,
+	       econf_errString(error));
+      return 1;
+    }
+  if (strcmp (val, expected_val) != 0)
+    {
+      fprintf (stderr, "ERROR: %s is not \"%s\", got [%s]\n", key, expected_val, val);
+      free (val);
+      return 1;
+    }
+
+  printf("Ok: %s=%s\n", key, val);
+  free (val);
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  int retval = 0;
+  econf_err error;
+
+  error = econf_readFile (&key_file, TESTSDIR "tst-comments3-data/multichar.conf",
+			  "=:", ";#");
+  if (error)
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  if (check_key(key_file, "key1", "value1") != 0)
+    retval = 1;
+  if (check_key(key_file, "key2", "a;b#c") != 0)
+    retval = 1;
+  if (check_key(key_file, "key3", "value3") != 0)
+    retval = 1;
+  if (check_key(key_file, "key4", "quoted") != 0)
+    retval = 1;
+  if (check_key(key_file, "key5", NULL) != 0)
+    retval = 1;
+  if (check_key(key_file, "key6", "value6") != 0)
+    retval = 1;
+
+  econf_free (key_file);
+
+  return retval;
+}
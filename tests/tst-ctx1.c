@@ -0,0 +1,300 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Every econf_ctx has its own security settings, conf dirs and error
+   location. They do not influence each other nor the global settings,
+   so threads can read configurations with different contexts at the
+   same time. A handle of econf_ctxOpenConfig keeps a copy of the
+   settings of its context. All read functions have a context variant.
+*/
+
+#define ROOT TESTSDIR "tst-ctx1-data"
+#define THREADS 4
+#define ROUNDS 200
+
+static const char *broken[2] = { ROOT "/missing_bracket.conf",
+				 ROOT "/missing_delim.conf" };
+static const econf_err broken_error[2] = { ECONF_MISSING_BRACKET,
+					   ECONF_MISSING_DELIMITER };
+static const uint64_t broken_line[2] = { 3, 3 };
+
+static econf_err
+read_bar(econf_ctx *ctx, econf_file **key_file)
+{
+  econf_err error;
+
+  if ((error = econf_newKeyFile_with_options(key_file, "ROOT_PREFIX=" ROOT)))
+    return error;
+  if (ctx)
+    return econf_ctxReadConfig(ctx, key_file, "foo", "/usr/etc", "bar", "conf",
+			       "=", "#");
+  return econf_readConfig(key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+}
+
+static int
+check_dropin(econf_ctx *ctx, const char *expected, const char *label)
+{
+  econf_file *key_file = NULL;
+  char *value = NULL;
+  econf_err error;
+  int ret = 0;
+
+  if ((error = read_bar(ctx, &key_file))) {
+    fprintf (stderr, "ERROR: %s: reading bar.conf: %s\n", label, econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_getStringValue(key_file, "main", "dropin", &value)) ||
+      strcmp(value, expected) != 0) {
+    fprintf (stderr, "ERROR: %s: dropin is %s instead of %s\n", label,
+	     value ? value : econf_errString(error), expected);
+    ret = 1;
+  }
+  free(value);
+  econf_free(key_file);
+  return ret;
+}
+
+static int
+check_location(econf_ctx *ctx, int n, const char *label)
+{
+  char *filename = NULL;
+  uint64_t line_nr = 0;
+  int ret = 0;
+
+  if (ctx)
+    econf_ctxErrLocation(ctx, &filename, &line_nr);
+  else
+    econf_errLocation(&filename, &line_nr);
+  if (n < 0) {
+    if (filename != NULL) {
+      fprintf (stderr, "ERROR: %s: unexpected error location %s\n", label, filename);
+      ret = 1;
+    }
+  } else if (filename == NULL || strcmp(filename, broken[n]) != 0 ||
+	     line_nr != broken_line[n]) {
+    fprintf (stderr, "ERROR: %s: error location %s:%d instead of %s:%d\n", label,
+	     filename ? filename : "(null)", (int) line_nr, broken[n],
+	     (int) broken_line[n]);
+    ret = 1;
+  }
+  free(filename);
+  return ret;
+}
+
+/* Open bar.conf with ctx, which is freed before the handle is used */
+static int
+check_handle(econf_ctx *ctx, const char *expected, const char *label)
+{
+  econf_handle *handle = NULL;
+  char *value = NULL, *filename = NULL;
+  uint64_t line_nr = 0;
+  econf_err error;
+  int ret = 0;
+
+  error = econf_ctxOpenConfig(ctx, &handle, "ROOT_PREFIX=" ROOT, "foo", "/usr/etc",
+			      "bar", "conf", "=", "#");
+  econf_free(ctx);
+  if (error) {
+    fprintf (stderr, "ERROR: %s: opening bar.conf: %s\n", label, econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_reload(handle, NULL))) {
+    fprintf (stderr, "ERROR: %s: econf_reload: %s\n", label, econf_errString(error));
+    ret = 1;
+  }
+  if ((error = econf_getStringValue(econf_getConfig(handle), "main", "dropin", &value)) ||
+      strcmp(value, expected) != 0) {
+    fprintf (stderr, "ERROR: %s: dropin is %s instead of %s\n", label,
+	     value ? value : econf_errString(error), expected);
+    ret = 1;
+  }
+  econf_handleErrLocation(handle, &filename, &line_nr);
+  if (filename != NULL) {
+    fprintf (stderr, "ERROR: %s: unexpected error location %s\n", label, filename);
+    ret = 1;
+  }
+  free(filename);
+  free(value);
+  econf_free(handle);
+  return ret;
+}
+
+/* The read functions besides econf_ctxReadFile and econf_ctxReadConfig */
+static int
+check_read_functions(econf_ctx *owner, econf_ctx *plain)
+{
+  static const char broken_data[] = "[main]\n[broken\n";
+  econf_file *key_file = NULL, **key_files = NULL;
+  char *filename = NULL;
+  uint64_t line_nr = 0;
+  size_t size = 0;
+  econf_err error;
+  int ret = 0;
+
+  if ((error = econf_ctxReadDirsHistory(owner, &key_files, &size, ROOT "/usr/etc/foo",
+					ROOT "/etc/foo", "bar", "conf", "=", "#")) !=
+      ECONF_WRONG_OWNER) {
+    fprintf (stderr, "ERROR: history with wrong owner: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if ((error = econf_ctxReadDirsHistory(plain, &key_files, &size, ROOT "/usr/etc/foo",
+					ROOT "/etc/foo", "bar", "conf", "=", "#")) ||
+      size != 2) {
+    fprintf (stderr, "ERROR: history of %d files: %s\n", (int) size, econf_errString(error));
+    ret = 1;
+  }
+  for (size_t i = 0; key_files && i < size; i++)
+    econf_free(key_files[i]);
+  free(key_files);
+  if ((error = econf_ctxOpenSnapshot(owner, &key_file, broken[0])) != ECONF_WRONG_OWNER) {
+    fprintf (stderr, "ERROR: snapshot with wrong owner: %s\n", econf_errString(error));
+    econf_free(key_file);
+    key_file = NULL;
+    ret = 1;
+  }
+  if ((error = econf_ctxReadBuffer(plain, &key_file, broken_data, sizeof(broken_data) - 1,
+				   "=", "#")) != ECONF_MISSING_BRACKET) {
+    fprintf (stderr, "ERROR: reading a broken buffer: %s\n", econf_errString(error));
+    econf_free(key_file);
+    key_file = NULL;
+    ret = 1;
+  }
+  econf_ctxErrLocation(plain, &filename, &line_nr);
+  if (line_nr != 2) {
+    fprintf (stderr, "ERROR: broken buffer in line %d\n", (int) line_nr);
+    ret = 1;
+  }
+  free(filename);
+  ret |= check_location(NULL, -1, "global location after reading a buffer");
+  return ret;
+}
+
+/* Every thread reads a broken file with its own context and finds the
+   location of its own error.  */
+static void *
+reader(void *arg)
+{
+  int n = (int) (size_t) arg % 2;
+  econf_ctx *ctx = NULL;
+  void *ret = NULL;
+
+  if (econf_newCtx(&ctx))
+    return (void *) 1;
+  for (int i = 0; i < ROUNDS && ret == NULL; i++) {
+    econf_file *key_file = NULL;
+    econf_err error = econf_ctxReadFile(ctx, &key_file, broken[n], "=", "#");
+    econf_free(key_file);
+    if (error != broken_error[n]) {
+      fprintf (stderr, "ERROR: reading %s: %s\n", broken[n], econf_errString(error));
+      ret = (void *) 1;
+    } else if (check_location(ctx, n, "thread")) {
+      ret = (void *) 1;
+    }
+  }
+  econf_free(ctx);
+  return ret;
+}
+
+int
+main(void)
+{
+  econf_ctx *owner = NULL, *dirs = NULL, *plain = NULL, *handle_ctx = NULL;
+  econf_file *key_file = NULL;
+  econf_handle *handle = NULL;
+  pthread_t threads[THREADS];
+  const char *conf_dirs[] = { ".d", NULL };
+  econf_err error;
+  int ret = 0, started = 0;
+
+  if (econf_newCtx(&owner) || econf_newCtx(&dirs) || econf_newCtx(&plain)) {
+    fprintf (stderr, "ERROR: couldn't create contexts\n");
+    return 1;
+  }
+
+  /* security settings of one context */
+  econf_ctxRequireOwner(owner, getuid() + 1);
+  error = read_bar(owner, &key_file);
+  econf_free(key_file);
+  key_file = NULL;
+  if (error != ECONF_WRONG_OWNER) {
+    fprintf (stderr, "ERROR: wrong owner has been accepted: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  ret |= check_dropin(plain, "conf.d", "plain context");
+  ret |= check_dropin(NULL, "conf.d", "global settings");
+
+  /* conf dirs of one context */
+  if ((error = econf_ctxSetConfDirs(dirs, conf_dirs))) {
+    fprintf (stderr, "ERROR: econf_ctxSetConfDirs: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  ret |= check_dropin(dirs, "d", "conf dirs context");
+  ret |= check_dropin(plain, "conf.d", "plain context");
+  ret |= check_dropin(NULL, "conf.d", "global settings");
+  /* global conf dirs are not used by a context */
+  econf_set_conf_dirs(conf_dirs);
+  ret |= check_dropin(plain, "conf.d", "plain context with global conf dirs");
+  ret |= check_dropin(NULL, "d", "global conf dirs");
+  conf_dirs[0] = ".conf.d";
+  econf_set_conf_dirs(conf_dirs);
+
+  /* error location of one context */
+  error = econf_ctxReadFile(plain, &key_file, broken[0], "=", "#");
+  econf_free(key_file);
+  key_file = NULL;
+  if (error != broken_error[0]) {
+    fprintf (stderr, "ERROR: reading %s: %s\n", broken[0], econf_errString(error));
+    ret = 1;
+  }
+  ret |= check_location(plain, 0, "plain context");
+  ret |= check_location(NULL, -1, "global location");
+  ret |= check_location(owner, -1, "owner context");
+
+  /* handles use the settings of their context */
+  error = econf_ctxOpenConfig(owner, &handle, "ROOT_PREFIX=" ROOT, "foo", "/usr/etc",
+			      "bar", "conf", "=", "#");
+  if (error != ECONF_WRONG_OWNER || handle != NULL) {
+    fprintf (stderr, "ERROR: handle with wrong owner: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if (econf_ctxOpenConfig(NULL, &handle, NULL, "foo", "/usr/etc", "bar", "conf",
+			  "=", "#") != ECONF_ARGUMENT_IS_NULL_VALUE) {
+    fprintf (stderr, "ERROR: handle without context has been opened\n");
+    ret = 1;
+  }
+  conf_dirs[0] = ".d";
+  if (econf_newCtx(&handle_ctx) || econf_ctxSetConfDirs(handle_ctx, conf_dirs)) {
+    fprintf (stderr, "ERROR: couldn't create the handle context\n");
+    ret = 1;
+  } else {
+    ret |= check_handle(handle_ctx, "d", "handle context");
+  }
+  ret |= check_read_functions(owner, plain);
+
+  while (started < THREADS &&
+	 pthread_create(&threads[started], NULL, reader, (void *) (size_t) started) == 0)
+    started++;
+  while (started > 0) {
+    void *result;
+    pthread_join(threads[--started], &result);
+    if (result)
+      ret = 1;
+  }
+
+  econf_free(owner);
+  econf_free(dirs);
+  econf_free(plain);
+  return ret;
+}
@@ -0,0 +1,84 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Parse a file with many sections which are partly repeated and check
+   that every section keeps its keys and that econf_getGroups returns
+   every group once in the order of appearance.
+*/
+
+#define GROUPS 20000
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  char *config = malloc(GROUPS * 2 * 40), *p = config;
+  char group[32], **groups = NULL;
+  size_t length = 0;
+  econf_err error;
+  int ret = 0;
+
+  if (config == NULL) {
+    fprintf (stderr, "ERROR: out of memory\n");
+    return 1;
+  }
+  for (int i = 0; i < GROUPS; i++)
+    p += sprintf(p, "[host%d]\nid=%d\n", i, i);
+  /* the same sections again */
+  for (int i = 0; i < GROUPS; i++)
+    p += sprintf(p, "[host%d]\nnext=%d\n", i, i + 1);
+
+  error = econf_readBuffer(&key_file, config, (size_t)(p - config), "=", "#");
+  free(config);
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readBuffer returned: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  for (int i = 0; i < GROUPS; i++) {
+    int id = -1, next = -1;
+    snprintf(group, sizeof(group), "host%d", i);
+    if ((error = econf_getIntValue(key_file, group, "id", &id)) ||
+	(error = econf_getIntValue(key_file, group, "next", &next)) ||
+	id != i || next != i + 1) {
+      fprintf (stderr, "ERROR: %s: id=%d next=%d: %s\n", group, id, next,
+	       econf_errString(error));
+      ret = 1;
+      break;
+    }
+  }
+
+  error = econf_getStringValue(key_file, "host", "id", &p);
+  if (error != ECONF_NOKEY) {
+    fprintf (stderr, "ERROR: unknown group: %s\n", econf_errString(error));
+    ret = 1;
+  }
+
+  if ((error = econf_getGroups(key_file, &length, &groups))) {
+    fprintf (stderr, "ERROR: econf_getGroups returned: %s\n", econf_errString(error));
+    ret = 1;
+  } else if (length != GROUPS) {
+    fprintf (stderr, "ERROR: expected %d groups, got %zu\n", GROUPS, length);
+    ret = 1;
+  } else {
+    for (size_t i = 0; i < length; i++) {
+      snprintf(group, sizeof(group), "host%zu", i);
+      if (strcmp(groups[i], group)) {
+	fprintf (stderr, "ERROR: group %zu: expected %s, got %s\n", i, group, groups[i]);
+	ret = 1;
+	break;
+      }
+    }
+  }
+  econf_freeArray(groups);
+  econf_free(key_file);
+  return ret;
+}
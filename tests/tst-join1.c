@@ -0,0 +1,72 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   A key which is repeated many times is joined into one entry with
+   JOIN_SAME_ENTRIES. An empty value resets the entries before.
+*/
+
+#define ENTRIES 1000
+#define RESET 500
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  char expected[ENTRIES * 10] = "", *p = expected;
+  char *value = NULL;
+  char **keys;
+  size_t length;
+  int ret = 0;
+
+  if ((error = econf_newKeyFile_with_options(&key_file, "JOIN_SAME_ENTRIES=1"))) {
+    fprintf (stderr, "ERROR: couldn't create new file: %s\n", econf_errString(error));
+    return 1;
+  }
+  error = econf_readConfig(&key_file, NULL, TESTSDIR "tst-join1-data", "input", "conf",
+			   "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  if ((error = econf_getKeys(key_file, "main", &length, &keys))) {
+    fprintf (stderr, "ERROR: econf_getKeys returned: %s\n", econf_errString(error));
+    ret = 1;
+    goto out;
+  }
+  econf_freeArray(keys);
+  if (length != 2) {
+    fprintf (stderr, "ERROR: expected 2 keys, got %zu\n", length);
+    ret = 1;
+  }
+
+  for (int i = RESET; i < ENTRIES; i++)
+    p += sprintf(p, "\ncmd%d", i);
+  if ((error = econf_getStringValue(key_file, "main", "Exec", &value)) ||
+      strcmp(value, expected)) {
+    fprintf (stderr, "ERROR: Exec: expected <%s>, got <%s>: %s\n", expected, value,
+	     econf_errString(error));
+    ret = 1;
+  }
+  free(value);
+  value = NULL;
+
+  if ((error = econf_getStringValue(key_file, "main", "Other", &value)) ||
+      strcmp(value, "value")) {
+    fprintf (stderr, "ERROR: Other: got <%s>: %s\n", value, econf_errString(error));
+    ret = 1;
+  }
+  free(value);
+
+ out:
+  econf_free(key_file);
+  return ret;
+}
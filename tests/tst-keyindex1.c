@@ -0,0 +1,113 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Create a file with a lot of groups and keys in memory and look up
+   all of them again. Groups can be given with or without brackets.
+   Entries which have been merged have to be found too.
+*/
+
+#define GROUPS 50
+#define KEYS 100
+
+int
+main(void)
+{
+  econf_file *key_file = NULL, *etc_file = NULL, *merged = NULL;
+  econf_err error;
+  char group[32], key[32];
+  int32_t value;
+
+  if ((error = econf_newIniFile(&key_file))) {
+    fprintf (stderr, "ERROR: couldn't create new file: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  for (int g = 0; g < GROUPS; g++) {
+    snprintf(group, sizeof(group), "group%d", g);
+    for (int k = 0; k < KEYS; k++) {
+      snprintf(key, sizeof(key), "key%d", k);
+      if ((error = econf_setIntValue(key_file, group, key, g * KEYS + k))) {
+	fprintf (stderr, "ERROR: couldn't set %s/%s: %s\n", group, key, econf_errString(error));
+	econf_free(key_file);
+	return 1;
+      }
+    }
+  }
+  /* overwriting an existing key must not create a new entry */
+  if ((error = econf_setIntValue(key_file, "[group3]", "key7", -1))) {
+    fprintf (stderr, "ERROR: couldn't overwrite group3/key7: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+
+  for (int g = 0; g < GROUPS; g++) {
+    for (int k = 0; k < KEYS; k++) {
+      int32_t expected = (g == 3 && k == 7) ? -1 : g * KEYS + k;
+      snprintf(group, sizeof(group), (k % 2) ? "[group%d]" : "group%d", g);
+      snprintf(key, sizeof(key), "key%d", k);
+      if ((error = econf_getIntValue(key_file, group, key, &value)) || value != expected) {
+	fprintf (stderr, "ERROR: %s/%s: expected %d, got %d: %s\n", group, key,
+		 expected, value, econf_errString(error));
+	econf_free(key_file);
+	return 1;
+      }
+    }
+  }
+
+  if ((error = econf_getIntValue(key_file, "group1", "key1000", &value)) != ECONF_NOKEY) {
+    fprintf (stderr, "ERROR: group1/key1000 should not exist: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+  if ((error = econf_getIntValue(key_file, "group1000", "key1", &value)) != ECONF_NOKEY) {
+    fprintf (stderr, "ERROR: group1000/key1 should not exist: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+
+  /* merging */
+  if ((error = econf_newIniFile(&etc_file))) {
+    fprintf (stderr, "ERROR: couldn't create new file: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+  econf_setIntValue(etc_file, "group1", "key1", 4711);
+  econf_setIntValue(etc_file, "new_group", "key1", 4712);
+  if ((error = econf_mergeFiles(&merged, key_file, etc_file))) {
+    fprintf (stderr, "ERROR: couldn't merge: %s\n", econf_errString(error));
+    econf_free(key_file);
+    econf_free(etc_file);
+    return 1;
+  }
+  econf_free(key_file);
+  econf_free(etc_file);
+
+  if ((error = econf_getIntValue(merged, "group1", "key1", &value)) || value != 4711) {
+    fprintf (stderr, "ERROR: merged group1/key1: expected 4711, got %d: %s\n",
+	     value, econf_errString(error));
+    econf_free(merged);
+    return 1;
+  }
+  if ((error = econf_getIntValue(merged, "new_group", "key1", &value)) || value != 4712) {
+    fprintf (stderr, "ERROR: merged new_group/key1: expected 4712, got %d: %s\n",
+	     value, econf_errString(error));
+    econf_free(merged);
+    return 1;
+  }
+  if ((error = econf_getIntValue(merged, "group49", "key99", &value)) || value != 4999) {
+    fprintf (stderr, "ERROR: merged group49/key99: expected 4999, got %d: %s\n",
+	     value, econf_errString(error));
+    econf_free(merged);
+    return 1;
+  }
+
+  econf_free(merged);
+  return 0;
+}
@@ -0,0 +1,116 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+ * Merge two large files. The etc file changes half of the values,
+ * adds a key to every group and adds new groups. One group of the usr file
+ * is split in two parts. Check values and the order of groups and keys.
+ * Merge a file into an empty file.
+*/
+
+#define GROUPS 100
+#define KEYS 100
+
+static int
+check_merged(econf_file *key_file)
+{
+  char group[32], key[32], value[32];
+  char **list = NULL;
+  size_t length = 0;
+  int ret = 0;
+
+  for (int g = 0; g < GROUPS && !ret; g++) {
+    snprintf(group, sizeof(group), "g%d", g);
+    for (int k = 0; k < KEYS; k++) {
+      snprintf(key, sizeof(key), "k%d", k);
+      snprintf(value, sizeof(value), "%s%d", k % 2 ? "usr" : "etc", g * KEYS + k);
+      ret |= check_value(key_file, group, key, value);
+    }
+    ret |= check_value(key_file, group, "new", "etc");
+  }
+  ret |= check_value(key_file, "g0", "late", "usr");
+  ret |= check_value(key_file, "etc0", "key", "etc");
+
+  /* new keys follow the last usr entry of the group */
+  if (econf_getKeys(key_file, "g0", &length, &list) ||
+      length != KEYS + 2 || strcmp(list[KEYS], "late") || strcmp(list[KEYS + 1], "new")) {
+    fprintf (stderr, "ERROR: wrong keys of g0\n");
+    ret = 1;
+  }
+  econf_freeArray(list);
+  list = NULL;
+
+  /* usr groups first, then the groups of etc */
+  if (econf_getGroups(key_file, &length, &list) || length != 2 * GROUPS ||
+      strcmp(list[0], "g0") || strcmp(list[GROUPS], "etc0")) {
+    fprintf (stderr, "ERROR: wrong groups\n");
+    ret = 1;
+  }
+  econf_freeArray(list);
+  return ret;
+}
+
+int
+main(void)
+{
+  char *usr = malloc(GROUPS * (KEYS + 1) * 32 + 32), *u = usr;
+  char *etc = malloc(GROUPS * (KEYS + 4) * 32), *e = etc;
+  econf_file *usr_file = NULL, *etc_file = NULL, *empty_file = NULL, *merged = NULL;
+  econf_err error;
+  int ret = 0;
+
+  if (usr == NULL || etc == NULL) {
+    fprintf (stderr, "ERROR: out of memory\n");
+    return 1;
+  }
+  for (int g = 0; g < GROUPS; g++) {
+    u += sprintf(u, "[g%d]\n", g);
+    e += sprintf(e, "[g%d]\n", g);
+    for (int k = 0; k < KEYS; k++) {
+      u += sprintf(u, "k%d=usr%d\n", k, g * KEYS + k);
+      if (k % 2 == 0)
+	e += sprintf(e, "k%d=etc%d\n", k, g * KEYS + k);
+    }
+    e += sprintf(e, "new=etc\n");
+  }
+  u += sprintf(u, "[g0]\nlate=usr\n");
+  for (int g = 0; g < GROUPS; g++)
+    e += sprintf(e, "[etc%d]\nkey=etc\n", g);
+
+  usr_file = parse_buffer(usr, (size_t)(u - usr));
+  etc_file = parse_buffer(etc, (size_t)(e - etc));
+  empty_file = parse_buffer("", 0);
+  free(usr);
+  free(etc);
+  if (!usr_file || !etc_file || !empty_file)
+    return 1;
+
+  if ((error = econf_mergeFiles(&merged, usr_file, etc_file))) {
+    fprintf (stderr, "ERROR: econf_mergeFiles returned: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret |= check_merged(merged);
+  econf_free(merged);
+  merged = NULL;
+
+  if ((error = econf_mergeFiles(&merged, empty_file, usr_file))) {
+    fprintf (stderr, "ERROR: merging into empty file: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret |= check_value(merged, "g0", "late", "usr");
+  ret |= check_value(merged, "g99", "k99", "usr9999");
+
+  econf_free(merged);
+  econf_free(usr_file);
+  econf_free(etc_file);
+  econf_free(empty_file);
+  return ret;
+}
@@ -0,0 +1,94 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   Merge a main configuration file with many drop-ins. Every 4th drop-in
+   of /usr/etc is replaced by a drop-in with the same name in /etc.
+   Check values and the order of the groups.
+*/
+
+#define ROOT TESTSDIR "tst-merge7-data"
+#define USR_DIR ROOT "/usr/etc/foo/bar.conf.d"
+#define ETC_DIR ROOT "/etc/foo/bar.conf.d"
+#define DROPINS 200
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  char name[32], path[256], content[64], **groups = NULL;
+  size_t length = 0;
+  int ret = 0;
+
+  remove_tree(USR_DIR);
+  remove_tree(ROOT "/etc");
+  if (mkdir(USR_DIR, 0755) || mkdir(ROOT "/etc", 0755) ||
+      mkdir(ROOT "/etc/foo", 0755) || mkdir(ETC_DIR, 0755)) {
+    fprintf (stderr, "ERROR: couldn't create drop-in directories\n");
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  for (int i = 0; i < DROPINS && !ret; i++) {
+    snprintf(name, sizeof(name), "%03d.conf", i);
+    snprintf(content, sizeof(content), "[main]\ncount = %d\n[g%03d]\nkey = usr\n", i, i);
+    snprintf(path, sizeof(path), "%s/%s", USR_DIR, name);
+    ret |= write_file(path, content);
+    if (i % 4 == 0) {
+      snprintf(content, sizeof(content), "[g%03d]\nkey = etc\n", i);
+      snprintf(path, sizeof(path), "%s/%s", ETC_DIR, name);
+      ret |= write_file(path, content);
+    }
+  }
+  ret |= write_file(ETC_DIR "/200.conf", "[main]\nbase = etc\n");
+  if (ret) {
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+
+  if ((error = econf_newKeyFile_with_options(&key_file, "ROOT_PREFIX=" ROOT))) {
+    fprintf (stderr, "ERROR: couldn't allocate new file: %s\n", econf_errString(error));
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  error = econf_readConfig(&key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+  remove_tree(USR_DIR);
+  remove_tree(ROOT "/etc");
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readConfig: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+
+  ret |= check_value(key_file, "main", "base", "etc");
+  /* the drop-ins which are replaced in /etc do not set count */
+  ret |= check_value(key_file, "main", "count", "199");
+  for (int i = 0; i < DROPINS; i++) {
+    snprintf(name, sizeof(name), "g%03d", i);
+    ret |= check_value(key_file, name, "key", i % 4 ? "usr" : "etc");
+  }
+
+  /* groups of /etc drop-ins follow the groups of /usr/etc drop-ins */
+  if ((error = econf_getGroups(key_file, &length, &groups)) || length != DROPINS + 1 ||
+      strcmp(groups[0], "main") || strcmp(groups[1], "g001") ||
+      strcmp(groups[DROPINS * 3 / 4 + 1], "g000")) {
+    fprintf (stderr, "ERROR: wrong groups: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  econf_freeArray(groups);
+  econf_free(key_file);
+  return ret;
+}
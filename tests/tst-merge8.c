@@ -0,0 +1,79 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+ * Merge two files with econf_mergeFilesConsume and compare the result
+ * with econf_mergeFiles. The consumed files are freed, even if an
+ * argument is missing.
+*/
+
+static const char usr_config[] =
+  "nogroup = usr\n"
+  "[main]\n"
+  "# comment\n"
+  "key = usr\n"
+  "long = a value which is longer than the one in etc\n"
+  "empty = usr\n"
+  "[usr]\n"
+  "key = usr # comment after value\n";
+
+static const char etc_config[] =
+  "[main]\n"
+  "key = etc\n"
+  "long = short\n"
+  "empty =\n"
+  "new = etc\n"
+  "[etc]\n"
+  "key = etc\n";
+
+int
+main(void)
+{
+  econf_file *usr_file = parse_buffer(usr_config, strlen(usr_config));
+  econf_file *etc_file = parse_buffer(etc_config, strlen(etc_config));
+  econf_file *expected = NULL, *merged = NULL;
+  econf_err error;
+  int ret = 0;
+
+  if (!usr_file || !etc_file)
+    return 1;
+  if ((error = econf_mergeFiles(&expected, usr_file, etc_file))) {
+    fprintf (stderr, "ERROR: econf_mergeFiles returned: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  if ((error = econf_mergeFilesConsume(&merged, usr_file, etc_file))) {
+    fprintf (stderr, "ERROR: econf_mergeFilesConsume returned: %s\n",
+	     econf_errString(error));
+    econf_free(expected);
+    return 1;
+  }
+  ret |= compare_files(expected, merged);
+  econf_free(expected);
+
+  /* The consumed strings stay valid after changing the merged file */
+  if ((error = econf_setStringValue(merged, "main", "new", "changed value")) ||
+      (error = econf_setStringValue(merged, "usr", "added", "value"))) {
+    fprintf (stderr, "ERROR: econf_setStringValue returned: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  econf_free(merged);
+
+  /* Missing arguments */
+  usr_file = parse_buffer(usr_config, strlen(usr_config));
+  if (econf_mergeFilesConsume(&merged, usr_file, NULL) != ECONF_ARGUMENT_IS_NULL_VALUE ||
+      merged != NULL) {
+    fprintf (stderr, "ERROR: econf_mergeFilesConsume accepted NULL\n");
+    ret = 1;
+  }
+
+  return ret;
+}
@@ -0,0 +1,55 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   /usr/etc/foo/bar.conf.d/10-broken.conf has a parse error but is
+   shadowed by /etc/foo/bar.conf.d/10-broken.conf. The shadowed file
+   must not be parsed at all.
+*/
+
+#define ROOT TESTSDIR "tst-merge9-data"
+
+static int files_read = 0;
+
+static bool
+count_files(const char *filename, const void *data)
+{
+  if (strstr(filename, "/usr/etc/foo/bar.conf.d/10-broken.conf")) {
+    fprintf (stderr, "ERROR: shadowed file %s has been read\n", filename);
+    return false;
+  }
+  (void) data;
+  files_read++;
+  return true;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int ret = 0;
+
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT, count_files))) {
+    fprintf (stderr, "ERROR: econf_readConfigWithCallback: %s\n", econf_errString(error));
+    return 1;
+  }
+  if (files_read != 3) {
+    fprintf (stderr, "ERROR: %d files read, expected 3\n", files_read);
+    ret = 1;
+  }
+  ret |= check_value(key_file, "main", "base", "usr");
+  ret |= check_value(key_file, "main", "usr", "true");
+  ret |= check_value(key_file, "main", "key", "etc");
+
+  econf_free(key_file);
+  return ret;
+}
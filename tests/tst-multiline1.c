@@ -0,0 +1,126 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf_ext.h"
+
+/* Test case:
+   Parse a long multiline value (e.g. a certificate) with comments before
+   the key and after some of the value lines and check that all lines
+   are collected in the right order.
+*/
+
+#define LINES 5000
+
+static void
+add(char **p, const char *str)
+{
+  *p = stpcpy(*p, str);
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  char *config = malloc(LINES * 80);
+  char *value_exp = malloc(LINES * 80);
+  char *after_exp = malloc(LINES * 80);
+  char *before_exp = malloc(LINES * 80);
+  char *c = config, *v = value_exp, *a = after_exp, *b = before_exp;
+  char line[80];
+  char *value = NULL;
+  econf_ext_value *ext_val = NULL;
+  econf_err error;
+  int ret = 0;
+
+  if (!config || !value_exp || !after_exp || !before_exp) {
+    fprintf (stderr, "ERROR: out of memory\n");
+    return 1;
+  }
+
+  add(&c, "[main]\n");
+  for (int i = 0; i < LINES; i++) {
+    snprintf(line, sizeof(line), "before %d", i);
+    add(&c, "#"); add(&c, line); add(&c, "\n");
+    if (i) add(&b, "\n");
+    add(&b, line);
+  }
+  add(&c, "cert = -----BEGIN CERTIFICATE-----\n");
+  add(&v, "-----BEGIN CERTIFICATE-----");
+  for (int i = 0; i < LINES; i++) {
+    snprintf(line, sizeof(line), "MIIDdzCCAl+gAwIBAgIE%08d", i);
+    add(&c, " "); add(&c, line);
+    add(&v, "\n "); add(&v, line);
+    /* lines without comment before the first comment are not counted,
+       the key line itself counts as empty comment */
+    if (i > 0)
+      add(&a, "\n");
+    if (i % 3 == 1) {
+      snprintf(line, sizeof(line), "after %d", i);
+      add(&c, "#"); add(&c, line);
+      add(&a, line);
+    }
+    add(&c, "\n");
+  }
+  add(&c, "next = single\n");
+
+  error = econf_readBuffer(&key_file, config, (size_t)(c - config), "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readBuffer returned: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  if ((error = econf_getStringValue(key_file, "main", "cert", &value)) ||
+      strcmp(value, value_exp)) {
+    fprintf (stderr, "ERROR: cert: wrong value: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if ((error = econf_getExtValue(key_file, "main", "cert", &ext_val))) {
+    fprintf (stderr, "ERROR: cert: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    if (ext_val->comment_before_key == NULL ||
+	strcmp(ext_val->comment_before_key, before_exp)) {
+      fprintf (stderr, "ERROR: cert: wrong comment before key\n");
+      ret = 1;
+    }
+    if (ext_val->comment_after_value == NULL ||
+	strcmp(ext_val->comment_after_value, after_exp)) {
+      fprintf (stderr, "ERROR: cert: wrong comment after value\n");
+      ret = 1;
+    }
+    econf_freeExtValue(ext_val);
+    ext_val = NULL;
+  }
+  free(value);
+  value = NULL;
+
+  /* The following entry has not taken over any comment */
+  if ((error = econf_getStringValue(key_file, "main", "next", &value)) ||
+      strcmp(value, "single")) {
+    fprintf (stderr, "ERROR: next: wrong value: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  free(value);
+  if ((error = econf_getExtValue(key_file, "main", "next", &ext_val))) {
+    fprintf (stderr, "ERROR: next: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    if (ext_val->comment_before_key != NULL || ext_val->comment_after_value != NULL) {
+      fprintf (stderr, "ERROR: next: unexpected comments\n");
+      ret = 1;
+    }
+    econf_freeExtValue(ext_val);
+  }
+
+  econf_free(key_file);
+  free(config);
+  free(value_exp);
+  free(after_exp);
+  free(before_exp);
+  return ret;
+}
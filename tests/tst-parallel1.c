@@ -0,0 +1,163 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   Parse many drop-ins with the PARSING_THREADS option. The result has
+   to be the same as parsing them one after another, and the first
+   broken file in the order of the drop-ins has to be reported.
+   More drop-ins than free file descriptors can be parsed, running out
+   of file descriptors is not reported as a missing file.
+*/
+
+#define ROOT TESTSDIR "tst-parallel1-data"
+#define USR_DIR ROOT "/usr/etc/foo/bar.conf.d"
+#define ETC_DIR ROOT "/etc/foo/bar.conf.d"
+#define DROPINS 64
+/* RLIMIT_NOFILE which is lower than the number of drop-ins */
+#define FD_LIMIT 48
+
+static int callbacks = 0;
+
+static bool
+count_callbacks(const char *filename, const void *data)
+{
+  (void) filename;
+  (void) data;
+  callbacks++;
+  return true;
+}
+
+int
+main(void)
+{
+  econf_file *expected = NULL, *key_file = NULL;
+  econf_err error;
+  char content[128], path[256], *filename = NULL;
+  uint64_t line_nr = 0;
+  int ret = 0;
+
+  remove_tree(USR_DIR);
+  remove_tree(ROOT "/etc");
+  if (mkdir(USR_DIR, 0755) || mkdir(ROOT "/etc", 0755) ||
+      mkdir(ROOT "/etc/foo", 0755) || mkdir(ETC_DIR, 0755)) {
+    fprintf (stderr, "ERROR: couldn't create drop-in directories\n");
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  for (int i = 0; i < DROPINS && !ret; i++) {
+    snprintf(content, sizeof(content),
+	     "[main]\ncount = %d\n[g%02d]\nkey = usr\n[g%02d]\nnext = %d\n",
+	     i, i, (i + 1) % DROPINS, i);
+    snprintf(path, sizeof(path), "%s/%02d.conf", USR_DIR, i);
+    ret |= write_file(path, content);
+    if (i % 3 == 0) {
+      snprintf(content, sizeof(content), "[g%02d]\nkey = etc\n", i);
+      snprintf(path, sizeof(path), "%s/%02d.conf", ETC_DIR, i);
+      ret |= write_file(path, content);
+    }
+  }
+  if (ret) {
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+
+  if ((error = read_config(&expected, "ROOT_PREFIX=" ROOT, count_callbacks))) {
+    fprintf (stderr, "ERROR: sequential econf_readConfig: %s\n", econf_errString(error));
+    remove_tree(USR_DIR);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT ";PARSING_THREADS=4", count_callbacks))) {
+    fprintf (stderr, "ERROR: parallel econf_readConfig: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    ret |= compare_files(expected, key_file);
+  }
+  econf_free(key_file);
+  key_file = NULL;
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT ";PARSING_THREADS=0", count_callbacks))) {
+    fprintf (stderr, "ERROR: econf_readConfig with all CPUs: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    ret |= compare_files(expected, key_file);
+  }
+  econf_free(key_file);
+  key_file = NULL;
+
+  struct rlimit old_limit, limit;
+  if (getrlimit(RLIMIT_NOFILE, &old_limit) == 0 && old_limit.rlim_cur > FD_LIMIT) {
+    limit = old_limit;
+    limit.rlim_cur = FD_LIMIT;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT ";PARSING_THREADS=2", count_callbacks))) {
+    fprintf (stderr, "ERROR: econf_readConfig with %d fds: %s\n", FD_LIMIT,
+	     econf_errString(error));
+    ret = 1;
+  } else {
+    ret |= compare_files(expected, key_file);
+  }
+  econf_free(key_file);
+  key_file = NULL;
+  /* no file descriptor is left */
+  int fd = dup(0);
+  if (fd >= 0) {
+    close(fd);
+    limit = old_limit;
+    limit.rlim_cur = fd;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT ";PARSING_THREADS=2", NULL)) !=
+      ECONF_ERROR) {
+    fprintf (stderr, "ERROR: econf_readConfig without fds: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  setrlimit(RLIMIT_NOFILE, &old_limit);
+  econf_free(expected);
+
+  /* main file and the drop-ins which are not shadowed, four times */
+  if (callbacks != 4 * (1 + DROPINS)) {
+    fprintf (stderr, "ERROR: %d callbacks\n", callbacks);
+    ret = 1;
+  }
+
+  /* the first broken drop-in is reported */
+  ret |= write_file(ETC_DIR "/40.conf", "[g40]\n[broken\n");
+  ret |= write_file(USR_DIR "/10.conf", "key = usr\n\n[broken\n");
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT ";PARSING_THREADS=4", count_callbacks)) != ECONF_MISSING_BRACKET) {
+    fprintf (stderr, "ERROR: broken drop-ins: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  econf_errLocation(&filename, &line_nr);
+  if (filename == NULL || strstr(filename, "/usr/etc/foo/bar.conf.d/10.conf") == NULL ||
+      line_nr != 3) {
+    fprintf (stderr, "ERROR: wrong error location %s:%d\n", filename, (int) line_nr);
+    ret = 1;
+  }
+  free(filename);
+  econf_free(key_file);
+  remove_tree(USR_DIR);
+  remove_tree(ROOT "/etc");
+
+  if (econf_newKeyFile_with_options(&key_file, "PARSING_THREADS=many") !=
+      ECONF_VALUE_CONVERSION_ERROR) {
+    fprintf (stderr, "ERROR: PARSING_THREADS=many accepted\n");
+    ret = 1;
+  }
+  econf_free(key_file);
+
+  return ret;
+}
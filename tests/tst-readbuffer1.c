@@ -0,0 +1,113 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Parse configurations from memory and from a pipe instead of a file.
+*/
+
+static const char config[] =
+  "# comment\n"
+  "[main]\n"
+  "key = value # comment after value\n"
+  "multi = first\n"
+  "  second\n"
+  "number=42\n"
+  "last=end of buffer";
+
+static int
+check(econf_file *key_file, const char *name, const char *key, const char *expected)
+{
+  char *value = NULL;
+  econf_err error = econf_getStringValue(key_file, "main", key, &value);
+
+  if (error || strcmp(value, expected)) {
+    fprintf (stderr, "ERROR: %s: %s: expected <%s>, got <%s>: %s\n", name, key,
+	     expected, value, econf_errString(error));
+    free(value);
+    return 1;
+  }
+  free(value);
+  return 0;
+}
+
+static int
+check_file(econf_file *key_file, const char *name)
+{
+  int ret = 0;
+  ret |= check(key_file, name, "key", "value");
+  ret |= check(key_file, name, "multi", "first\n  second");
+  ret |= check(key_file, name, "number", "42");
+  ret |= check(key_file, name, "last", "end of buffer");
+  return ret;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int fds[2], ret = 0;
+
+  /* The buffer does not have to be null terminated */
+  char buffer[sizeof(config) + 4];
+  memcpy(buffer, config, sizeof(config) - 1);
+  memcpy(buffer + sizeof(config) - 1, " xyz", 4);
+  error = econf_readBuffer(&key_file, buffer, sizeof(config) - 1, "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readBuffer returned: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret |= check_file(key_file, "buffer");
+  econf_free(key_file);
+  key_file = NULL;
+
+  /* Empty buffer */
+  error = econf_readBuffer(&key_file, NULL, 0, "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: empty buffer: %s\n", econf_errString(error));
+    return 1;
+  }
+  econf_free(key_file);
+  key_file = NULL;
+
+  /* Parse errors are reported like for files */
+  error = econf_readBuffer(&key_file, "[main\nkey=value\n", 16, "=", "#");
+  if (error != ECONF_MISSING_BRACKET || key_file != NULL) {
+    fprintf (stderr, "ERROR: missing bracket: got %s\n", econf_errString(error));
+    return 1;
+  }
+
+  if (pipe(fds) == -1) {
+    perror("pipe");
+    return 1;
+  }
+  if (write(fds[1], config, sizeof(config) - 1) != sizeof(config) - 1) {
+    perror("write");
+    return 1;
+  }
+  close(fds[1]);
+  error = econf_readFd(&key_file, fds[0], "=", "#");
+  close(fds[0]);
+  if (error) {
+    fprintf (stderr, "ERROR: econf_readFd returned: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret |= check_file(key_file, "fd");
+  econf_free(key_file);
+  key_file = NULL;
+
+  error = econf_readFd(&key_file, -1, "=", "#");
+  if (error != ECONF_NOFILE) {
+    fprintf (stderr, "ERROR: invalid fd: got %s\n", econf_errString(error));
+    ret = 1;
+  }
+
+  return ret;
+}
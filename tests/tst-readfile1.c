@@ -0,0 +1,125 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Files are loaded completely before they are parsed. Check a file
+   without newline at the end, a large file and a pipe whose size is
+   not known in advance.
+*/
+
+#define ENTRIES 20000
+#define FIFO TESTSDIR "tst-readfile1-data/fifo.conf"
+#define LARGE TESTSDIR "tst-readfile1-data/large.conf"
+
+static int
+write_entries(FILE *f)
+{
+  for (int i = 0; i < ENTRIES; i++)
+    if (fprintf(f, "# comment %d\nkey%d = value%d\n", i, i, i) < 0)
+      return 1;
+  return 0;
+}
+
+static int
+check_entries(econf_file *key_file, const char *name)
+{
+  econf_err error;
+  char key[32], expected[32], *value = NULL;
+  size_t length = 0;
+  char **keys;
+
+  if ((error = econf_getKeys(key_file, NULL, &length, &keys))) {
+    fprintf (stderr, "ERROR: %s: econf_getKeys returned: %s\n", name, econf_errString(error));
+    return 1;
+  }
+  econf_freeArray(keys);
+  if (length != ENTRIES) {
+    fprintf (stderr, "ERROR: %s: expected %d keys, got %zu\n", name, ENTRIES, length);
+    return 1;
+  }
+  for (int i = 0; i < ENTRIES; i += 997) {
+    snprintf(key, sizeof(key), "key%d", i);
+    snprintf(expected, sizeof(expected), "value%d", i);
+    if ((error = econf_getStringValue(key_file, NULL, key, &value)) ||
+	strcmp(value, expected)) {
+      fprintf (stderr, "ERROR: %s: %s: expected %s, got %s: %s\n", name, key, expected,
+	       value, econf_errString(error));
+      free(value);
+      return 1;
+    }
+    free(value);
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  char *value = NULL;
+  FILE *f;
+  pid_t pid;
+  int ret, status;
+
+  error = econf_readFile(&key_file, TESTSDIR "tst-readfile1-data/nonewline.conf", "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: couldn't read nonewline.conf: %s\n", econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_getStringValue(key_file, "main", "last", &value)) ||
+      strcmp(value, "end of file")) {
+    fprintf (stderr, "ERROR: nonewline.conf: got <%s>: %s\n", value, econf_errString(error));
+    free(value);
+    econf_free(key_file);
+    return 1;
+  }
+  free(value);
+  econf_free(key_file);
+
+  if ((f = fopen(LARGE, "w")) == NULL || write_entries(f) || fclose(f)) {
+    fprintf (stderr, "ERROR: couldn't write %s\n", LARGE);
+    return 1;
+  }
+  error = econf_readFile(&key_file, LARGE, "=", "#");
+  remove(LARGE);
+  if (error) {
+    fprintf (stderr, "ERROR: couldn't read large.conf: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret = check_entries(key_file, "large.conf");
+  econf_free(key_file);
+  if (ret)
+    return ret;
+
+  remove(FIFO);
+  if (mkfifo(FIFO, 0600)) {
+    fprintf (stderr, "ERROR: couldn't create %s\n", FIFO);
+    return 1;
+  }
+  if ((pid = fork()) == 0) {
+    f = fopen(FIFO, "w");
+    _exit(f == NULL || write_entries(f) || fclose(f));
+  }
+  error = econf_readFile(&key_file, FIFO, "=", "#");
+  waitpid(pid, &status, 0);
+  remove(FIFO);
+  if (error || !WIFEXITED(status) || WEXITSTATUS(status)) {
+    fprintf (stderr, "ERROR: couldn't read fifo.conf: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+  ret = check_entries(key_file, "fifo.conf");
+  econf_free(key_file);
+
+  return ret;
+}
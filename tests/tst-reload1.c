@@ -0,0 +1,148 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   econf_reload parses only the changed files again. The merged result
+   is the same as the one of econf_readConfig, a file which has been
+   changed without changing its identity is taken from the last reload.
+*/
+
+#define ROOT TESTSDIR "tst-reload1-data"
+#define OPTIONS "ROOT_PREFIX=" ROOT
+#define ETC_DIR ROOT "/etc/foo/bar.conf.d"
+#define ETC_MAIN ROOT "/etc/foo/bar.conf"
+
+/* The configuration of handle has to be the one of econf_readConfig */
+static int
+compare(econf_handle *handle)
+{
+  econf_file *expected = NULL;
+  econf_err error;
+  int ret;
+
+  if ((error = read_config(&expected, OPTIONS, NULL))) {
+    fprintf (stderr, "ERROR: econf_readConfig: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret = compare_files(expected, econf_getConfig(handle));
+  econf_free(expected);
+  return ret;
+}
+
+static int
+reload(econf_handle *handle, bool expected, const char *what)
+{
+  bool changed = !expected;
+  econf_err error;
+
+  if ((error = econf_reload(handle, &changed)) || changed != expected) {
+    fprintf (stderr, "ERROR: reload after %s: %s, changed %d\n", what,
+	     econf_errString(error), changed);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_handle *handle = NULL;
+  econf_err error;
+  struct stat sb;
+  int ret = 0;
+
+  remove_tree(ROOT "/etc");
+  if ((error = econf_openConfig(&handle, OPTIONS, "foo", "/usr/etc", "bar", "conf",
+				"=", "#"))) {
+    fprintf (stderr, "ERROR: econf_openConfig: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret |= compare(handle);
+  ret |= reload(handle, false, "nothing");
+
+  if (mkdir(ROOT "/etc", 0755) || mkdir(ROOT "/etc/foo", 0755) || mkdir(ETC_DIR, 0755)) {
+    fprintf (stderr, "ERROR: couldn't create %s\n", ETC_DIR);
+    econf_free(handle);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  ret |= write_file(ETC_DIR "/30-c.conf", "[main]\nc = 1\n");
+  ret |= reload(handle, true, "adding a drop-in");
+  ret |= compare(handle);
+
+  /* The content of 30-c.conf is changed, but not its identity. Only the
+     new drop-in is parsed, so the old value of c is kept.  */
+  if (stat(ETC_DIR "/30-c.conf", &sb)) {
+    fprintf (stderr, "ERROR: couldn't stat 30-c.conf\n");
+    ret = 1;
+  }
+  ret |= write_file(ETC_DIR "/30-c.conf", "[main]\nc = 2\n");
+  struct timespec times[2] = { sb.st_atim, sb.st_mtim };
+  if (utimensat(AT_FDCWD, ETC_DIR "/30-c.conf", times, 0)) {
+    fprintf (stderr, "ERROR: couldn't reset the time of 30-c.conf\n");
+    ret = 1;
+  }
+  ret |= write_file(ETC_DIR "/40-d.conf", "[main]\nd = 1\nb = etc\n");
+  ret |= reload(handle, true, "adding another drop-in");
+  ret |= check_value(econf_getConfig(handle), "main", "c", "1");
+  ret |= check_value(econf_getConfig(handle), "main", "d", "1");
+  ret |= check_value(econf_getConfig(handle), "main", "b", "etc");
+
+  /* a changed size is noticed */
+  ret |= write_file(ETC_DIR "/30-c.conf", "[main]\nc = 30\n");
+  ret |= reload(handle, true, "changing a drop-in");
+  ret |= compare(handle);
+
+  /* shadowing a drop-in of /usr/etc */
+  ret |= write_file(ETC_DIR "/10-a.conf", "[main]\na = etc\n");
+  ret |= reload(handle, true, "shadowing a drop-in");
+  ret |= check_value(econf_getConfig(handle), "main", "a", "etc");
+  ret |= compare(handle);
+
+  remove(ETC_DIR "/40-d.conf");
+  ret |= reload(handle, true, "removing a drop-in");
+  ret |= check_value(econf_getConfig(handle), "main", "d", NULL);
+  ret |= compare(handle);
+
+  /* a main file with higher priority */
+  ret |= write_file(ETC_MAIN, "[main]\nname = etc\n");
+  ret |= reload(handle, true, "adding a main file");
+  ret |= check_value(econf_getConfig(handle), "main", "name", "etc");
+  ret |= check_value(econf_getConfig(handle), "main", "size", NULL);
+  ret |= compare(handle);
+
+  /* a broken drop-in keeps the last configuration */
+  ret |= write_file(ETC_DIR "/50-e.conf", "[main\n");
+  if (econf_reload(handle, NULL) != ECONF_MISSING_BRACKET) {
+    fprintf (stderr, "ERROR: broken drop-in accepted\n");
+    ret = 1;
+  }
+  ret |= check_value(econf_getConfig(handle), "main", "name", "etc");
+  ret |= check_value(econf_getConfig(handle), "main", "c", "30");
+  remove(ETC_DIR "/50-e.conf");
+  ret |= reload(handle, true, "removing the broken drop-in");
+  ret |= compare(handle);
+  ret |= reload(handle, false, "nothing");
+
+  econf_free(handle);
+  remove_tree(ROOT "/etc");
+
+  if (econf_openConfig(&handle, OPTIONS, "foo", "/usr/etc", "missing", "conf",
+		       "=", "#") != ECONF_NOFILE || handle != NULL) {
+    fprintf (stderr, "ERROR: missing configuration opened\n");
+    ret = 1;
+  }
+  econf_free(handle);
+  return ret;
+}
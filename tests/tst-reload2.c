@@ -0,0 +1,142 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   Reader threads take the configuration of a handle with
+   econf_acquireConfig while another thread reloads it. Every reader
+   sees a consistent configuration which is never older than the one it
+   has seen before, a held configuration stays valid after a reload.
+*/
+
+#define ROOT TESTSDIR "tst-reload2-data"
+#define ETC_DIR ROOT "/etc/foo"
+#define ETC_MAIN ETC_DIR "/bar.conf"
+#define READERS 4
+#define RELOADS 200
+
+static econf_handle *handle;
+static atomic_bool done;
+
+/* Replace the main file by generation gen. The size grows with every
+   generation, so econf_reload always notices the change.  */
+static int
+write_generation(int gen)
+{
+  FILE *f;
+
+  if ((f = fopen(ETC_MAIN ".tmp", "w")) == NULL ||
+      fprintf(f, "[main]\na = %d\nb = %d\n# %*s\n", gen, gen, gen, "") < 0 ||
+      fclose(f) || rename(ETC_MAIN ".tmp", ETC_MAIN)) {
+    fprintf (stderr, "ERROR: couldn't write generation %d\n", gen);
+    return 1;
+  }
+  return 0;
+}
+
+static void *
+reader(void *arg)
+{
+  int last = -1;
+
+  (void) arg;
+  while (!atomic_load(&done)) {
+    econf_file *key_file = econf_acquireConfig(handle);
+    int a = -1, b = -2;
+
+    if (key_file == NULL || econf_getIntValue(key_file, "main", "a", &a) ||
+	econf_getIntValue(key_file, "main", "b", &b) || a != b || a < last) {
+      fprintf (stderr, "ERROR: reader sees a = %d, b = %d after %d\n", a, b, last);
+      econf_releaseConfig(key_file);
+      return (void *) 1;
+    }
+    last = a;
+    econf_releaseConfig(key_file);
+  }
+  return NULL;
+}
+
+static int
+check_generation(econf_file *key_file, int expected)
+{
+  int a = -1;
+
+  if (econf_getIntValue(key_file, "main", "a", &a) || a != expected) {
+    fprintf (stderr, "ERROR: generation %d instead of %d\n", a, expected);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  pthread_t threads[READERS];
+  econf_file *held;
+  econf_err error;
+  int ret = 0, started = 0;
+
+  remove_tree(ROOT "/etc");
+  if (mkdir(ROOT "/etc", 0755) || mkdir(ETC_DIR, 0755) || write_generation(1)) {
+    fprintf (stderr, "ERROR: couldn't create %s\n", ETC_MAIN);
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+  if ((error = econf_openConfig(&handle, "ROOT_PREFIX=" ROOT, "foo", "/usr/etc", "bar",
+				"conf", "=", "#"))) {
+    fprintf (stderr, "ERROR: econf_openConfig: %s\n", econf_errString(error));
+    remove_tree(ROOT "/etc");
+    return 1;
+  }
+
+  /* a held configuration is not freed by a reload */
+  held = econf_acquireConfig(handle);
+  ret |= write_generation(2);
+  if ((error = econf_reload(handle, NULL))) {
+    fprintf (stderr, "ERROR: econf_reload: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  ret |= check_generation(held, 1);
+  ret |= check_generation(econf_getConfig(handle), 2);
+  econf_releaseConfig(held);
+
+  while (started < READERS &&
+	 pthread_create(&threads[started], NULL, reader, NULL) == 0)
+    started++;
+  for (int gen = 3; gen < RELOADS && !ret; gen++) {
+    bool changed = false;
+    ret |= write_generation(gen);
+    if ((error = econf_reload(handle, &changed)) || !changed) {
+      fprintf (stderr, "ERROR: reload of generation %d: %s\n", gen, econf_errString(error));
+      ret = 1;
+    }
+  }
+  atomic_store(&done, true);
+  while (started > 0) {
+    void *result;
+    pthread_join(threads[--started], &result);
+    if (result)
+      ret = 1;
+  }
+  ret |= check_generation(econf_getConfig(handle), RELOADS - 1);
+
+  /* freeing the handle keeps a held configuration */
+  held = econf_acquireConfig(handle);
+  econf_free(handle);
+  ret |= check_generation(held, RELOADS - 1);
+  econf_releaseConfig(held);
+
+  remove_tree(ROOT "/etc");
+  return ret;
+}
@@ -0,0 +1,106 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Preallocate entries with econf_reserve and fill the file with more
+   entries than reserved. New entries have to be initialized correctly,
+   independent of how the econf_file object has been created.
+*/
+
+#define ENTRIES 1000
+
+static int
+fill_and_check(econf_file *key_file, const char *name)
+{
+  econf_err error;
+  char key[32];
+  int32_t value;
+  size_t length = 0;
+  char **keys;
+
+  for (int i = 0; i < ENTRIES; i++) {
+    snprintf(key, sizeof(key), "key%d", i);
+    if ((error = econf_setIntValue(key_file, "main", key, i))) {
+      fprintf (stderr, "ERROR: %s: couldn't set %s: %s\n", name, key, econf_errString(error));
+      return 1;
+    }
+  }
+
+  /* a failed set call leaves an initialized entry behind */
+  if ((error = econf_setBoolValue(key_file, "main", "broken", "maybe")) != ECONF_WRONG_BOOLEAN_VALUE) {
+    fprintf (stderr, "ERROR: %s: setting a wrong boolean returned: %s\n", name, econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_getIntValue(key_file, "main", "broken", &value)) != ECONF_VALUE_CONVERSION_ERROR) {
+    fprintf (stderr, "ERROR: %s: reading broken returned: %s\n", name, econf_errString(error));
+    return 1;
+  }
+
+  /* shrinking is not possible and must not change anything */
+  if ((error = econf_reserve(key_file, 1))) {
+    fprintf (stderr, "ERROR: %s: econf_reserve returned: %s\n", name, econf_errString(error));
+    return 1;
+  }
+
+  for (int i = 0; i < ENTRIES; i++) {
+    snprintf(key, sizeof(key), "key%d", i);
+    if ((error = econf_getIntValue(key_file, "main", key, &value)) || value != i) {
+      fprintf (stderr, "ERROR: %s: %s: expected %d, got %d: %s\n", name, key, i, value,
+	       econf_errString(error));
+      return 1;
+    }
+  }
+
+  if ((error = econf_getKeys(key_file, "main", &length, &keys))) {
+    fprintf (stderr, "ERROR: %s: econf_getKeys returned: %s\n", name, econf_errString(error));
+    return 1;
+  }
+  econf_freeArray(keys);
+  if (length != ENTRIES + 1) {
+    fprintf (stderr, "ERROR: %s: expected %d keys, got %zu\n", name, ENTRIES + 1, length);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int ret;
+
+  if ((error = econf_reserve(NULL, 10)) != ECONF_ARGUMENT_IS_NULL_VALUE) {
+    fprintf (stderr, "ERROR: econf_reserve(NULL) returned: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  if ((error = econf_newIniFile(&key_file))) {
+    fprintf (stderr, "ERROR: couldn't create new file: %s\n", econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_reserve(key_file, ENTRIES / 2))) {
+    fprintf (stderr, "ERROR: econf_reserve returned: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+  ret = fill_and_check(key_file, "reserved");
+  econf_free(key_file);
+  if (ret)
+    return ret;
+
+  if ((error = econf_newKeyFile_with_options(&key_file, ""))) {
+    fprintf (stderr, "ERROR: couldn't create new file: %s\n", econf_errString(error));
+    return 1;
+  }
+  ret = fill_and_check(key_file, "unreserved");
+  econf_free(key_file);
+
+  return ret;
+}
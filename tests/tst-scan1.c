@@ -0,0 +1,51 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   The parser finds delimiters, comments and newlines with vectorized
+   kernels which handle 64 bytes at once. Keys and values of increasing
+   length move these characters through all positions of a block.
+*/
+
+#define ENTRIES 130
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  char key[32], expected[ENTRIES * 2 + 1];
+  char *value = NULL;
+  int ret = 0;
+
+  error = econf_readFile(&key_file, TESTSDIR "tst-scan1-data/offsets.conf", "=", "#");
+  if (error) {
+    fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+    return 1;
+  }
+
+  for (int i = 0; i < ENTRIES; i++) {
+    static const char *pattern[] = { "x", "y", "\xc3\xa9" };
+    snprintf(key, sizeof(key), "key%d", i);
+    expected[0] = '\0';
+    for (int j = 0; j < i; j++)
+      strcat(expected, pattern[j % 3]);
+    if ((error = econf_getStringValue(key_file, "", key, &value)) ||
+	strcmp(value, expected)) {
+      fprintf (stderr, "ERROR: %s: expected <%s>, got <%s>: %s\n", key, expected,
+	       value, econf_errString(error));
+      ret = 1;
+    }
+    free(value);
+    value = NULL;
+  }
+
+  econf_free(key_file);
+  return ret;
+}
@@ -10,11 +10,37 @@
 #include <sys/stat.h>
 
 #include "libeconf.h"
+#include "testhelpers.h"
 
 /* Test case:
  *  Test userID, groupID, permissions of a parsed file.
  */
 
+/* Own name, tst-checkfiles creates link.conf in the same directory */
+#define LINK TESTSDIR"tst-arguments-string/etc/security-link.conf"
+/* Configuration with the permissions 0755 of the directories and 0644 of
+   the files, created at runtime */
+#define ROOT TESTSDIR"tst-security-data"
+#define CONF_DIR ROOT"/usr/etc/foo"
+
+static int
+create_config(void)
+{
+  remove_tree(ROOT);
+  if (mkdir(ROOT, 0755) || mkdir(ROOT"/usr", 0755) || mkdir(ROOT"/usr/etc", 0755) ||
+      mkdir(CONF_DIR, 0755) || mkdir(CONF_DIR"/bar.conf.d", 0755) ||
+      write_file(CONF_DIR"/bar.conf", "[main]\nkey = usr\n") ||
+      write_file(CONF_DIR"/bar.conf.d/10-dropin.conf", "[main]\ndropin = conf.d\n") ||
+      chmod(CONF_DIR, 0755) || chmod(CONF_DIR"/bar.conf.d", 0755) ||
+      chmod(CONF_DIR"/bar.conf", 0644) || chmod(CONF_DIR"/bar.conf.d/10-dropin.conf", 0644))
+  {
+    fprintf (stderr, "ERROR: couldn't create %s\n", ROOT);
+    remove_tree(ROOT);
+    return 1;
+  }
+  return 0;
+}
+
 int
 main(void)
 {
@@ -55,15 +81,25 @@ main(void)
   econf_reset_security_settings();
 
   /* checking link */
-  if (symlink(TESTSDIR"tst-arguments-string/etc/arguments.conf", TESTSDIR"tst-arguments-string/etc/link.conf") == -1)
+  if (symlink(TESTSDIR"tst-arguments-string/etc/arguments.conf", LINK) == -1)
   {
-    fprintf (stderr, "WARNING: Cannot create sym link %s for testing.\n", TESTSDIR"tst-arguments-string/etc/link.conf");
+    fprintf (stderr, "WARNING: Cannot create sym link %s for testing.\n", LINK);
     fprintf (stderr, "Exit without reporting an error");
     return 0;
   }
+  /* the checks apply to the file the link points to */
+  error = econf_readFile (&key_file, LINK, "=", "#");
+  econf_free(key_file);
+  key_file = NULL;
+  if (error)
+  {
+    remove(LINK);
+    fprintf (stderr, "ERROR: couldn't read sym link: %s\n", econf_errString(error));
+    return 1;
+  }
   econf_followSymlinks(false);
-  error = econf_readFile (&key_file, TESTSDIR"tst-arguments-string/etc/link.conf", "=", "#");
-  remove(TESTSDIR"tst-arguments-string/etc/link.conf");
+  error = econf_readFile (&key_file, LINK, "=", "#");
+  remove(LINK);
   if (error != ECONF_ERROR_FILE_IS_SYM_LINK)
   {
     fprintf (stderr, "ERROR: expecting: %s\n       returned:  %s\n",
@@ -98,6 +134,27 @@ main(void)
 	     econf_errString(error));
     return 1;
   }
+
+  /* the same for all files of a configuration */
+  if (create_config())
+    return 1;
+  if ((error = econf_newKeyFile_with_options(&key_file, "ROOT_PREFIX="ROOT)))
+  {
+    fprintf (stderr, "ERROR: couldn't create key file: %s\n", econf_errString(error));
+    remove_tree(ROOT);
+    return 1;
+  }
+  error = econf_readConfig (&key_file, "foo", "/usr/etc", "bar", "conf", "=", "#");
+  econf_free(key_file);
+  key_file = NULL;
+  remove_tree(ROOT);
+  if (error != ECONF_WRONG_DIR_PERMISSION)
+  {
+    fprintf (stderr, "ERROR: expecting: %s\n       returned:  %s\n",
+	     econf_errString(ECONF_WRONG_DIR_PERMISSION),
+	     econf_errString(error));
+    return 1;
+  }
   econf_reset_security_settings();
 
   return 0;
@@ -0,0 +1,278 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+#include "libeconf_ext.h"
+
+/* Test case:
+   Compile the result of econf_readConfig to a snapshot and open it
+   again. Groups, keys, values, comments and line numbers have to be the
+   same. Compiling the opened snapshot gives the same snapshot again.
+   Broken snapshots are refused.
+*/
+
+#define ROOT TESTSDIR "tst-snapshot1-data"
+#define SNAPSHOT ROOT "/bar.snapshot"
+#define SNAPSHOT2 ROOT "/bar2.snapshot"
+
+static int
+compare_strings(const char *what, const char *expected, const char *value)
+{
+  if ((expected == NULL) != (value == NULL) ||
+      (expected && strcmp(expected, value))) {
+    fprintf (stderr, "ERROR: %s: expected '%s', got '%s'\n", what,
+	     expected ? expected : "(null)", value ? value : "(null)");
+    return 1;
+  }
+  return 0;
+}
+
+/* Both files must have the same groups, keys, values and comments */
+static int
+compare(econf_file *expected, econf_file *key_file)
+{
+  char **exp_groups = NULL, **groups = NULL;
+  size_t exp_len = 0, len = 0;
+  int ret = 0;
+
+  if (econf_getGroups(expected, &exp_len, &exp_groups) ||
+      econf_getGroups(key_file, &len, &groups) || exp_len != len) {
+    fprintf (stderr, "ERROR: different number of groups\n");
+    ret = 1;
+  }
+  /* NULL stands for the entries without group */
+  for (size_t i = 0; !ret && i <= len; i++) {
+    const char *group = i < len ? groups[i] : NULL;
+    char **exp_keys = NULL, **keys = NULL;
+    size_t exp_key_len = 0, key_len = 0;
+
+    if ((group && strcmp(exp_groups[i], group)) ||
+	econf_getKeys(expected, group, &exp_key_len, &exp_keys) ||
+	econf_getKeys(key_file, group, &key_len, &keys) ||
+	exp_key_len != key_len) {
+      fprintf (stderr, "ERROR: group %s differs\n", group);
+      ret = 1;
+    }
+    for (size_t k = 0; !ret && k < key_len; k++) {
+      econf_ext_value *exp_value = NULL, *value = NULL;
+      ret |= compare_strings("key", exp_keys[k], keys[k]);
+      if (ret || econf_getExtValue(expected, group, keys[k], &exp_value) ||
+	  econf_getExtValue(key_file, group, keys[k], &value)) {
+	fprintf (stderr, "ERROR: %s/%s not found\n", group, keys[k]);
+	ret = 1;
+      } else {
+	for (size_t v = 0; !ret && (exp_value->values[v] || value->values[v]); v++)
+	  ret |= compare_strings("value", exp_value->values[v], value->values[v]);
+	ret |= compare_strings("comment before key", exp_value->comment_before_key,
+			       value->comment_before_key);
+	ret |= compare_strings("comment after value", exp_value->comment_after_value,
+			       value->comment_after_value);
+	if (exp_value->line_number != value->line_number) {
+	  fprintf (stderr, "ERROR: %s/%s: line %d instead of %d\n", group, keys[k],
+		   (int) value->line_number, (int) exp_value->line_number);
+	  ret = 1;
+	}
+      }
+      econf_freeExtValue(exp_value);
+      econf_freeExtValue(value);
+    }
+    econf_freeArray(exp_keys);
+    econf_freeArray(keys);
+  }
+  econf_freeArray(exp_groups);
+  econf_freeArray(groups);
+  return ret;
+}
+
+static char *
+read_all(const char *path, size_t *size)
+{
+  FILE *f = fopen(path, "r");
+  char *data = NULL;
+
+  *size = 0;
+  if (f == NULL)
+    return NULL;
+  if (fseek(f, 0, SEEK_END) == 0 && (*size = ftell(f)) > 0 &&
+      fseek(f, 0, SEEK_SET) == 0 && (data = malloc(*size)) != NULL &&
+      fread(data, 1, *size, f) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+static int
+write_all(const char *path, const char *data, size_t size)
+{
+  FILE *f = fopen(path, "w");
+
+  if (f == NULL || fwrite(data, 1, size, f) != size || fclose(f)) {
+    fprintf (stderr, "ERROR: couldn't write %s\n", path);
+    return 1;
+  }
+  return 0;
+}
+
+/* hash_offset and hash_size of struct snapshot_header */
+#define HASH_OFFSET 56
+#define HASH_SIZE 60
+#define SNAPSHOT_NULL 0xffffffff
+
+/* Write data with the hash table changed by corrupt and open it */
+static int
+check_broken_hash(const char *data, size_t size,
+		  void (*corrupt)(uint32_t *hash, uint32_t hash_size),
+		  const char *label)
+{
+  econf_file *broken = NULL;
+  char *copy = malloc(size);
+  uint32_t hash_offset, hash_size;
+  econf_err error;
+  int ret = 0;
+
+  if (copy == NULL)
+    return 1;
+  memcpy(copy, data, size);
+  memcpy(&hash_offset, copy + HASH_OFFSET, sizeof(hash_offset));
+  memcpy(&hash_size, copy + HASH_SIZE, sizeof(hash_size));
+  if (hash_offset > size || hash_size > (size - hash_offset) / sizeof(uint32_t)) {
+    fprintf (stderr, "ERROR: %s: no hash table\n", label);
+    free(copy);
+    return 1;
+  }
+  corrupt((uint32_t *) (copy + hash_offset), hash_size);
+  ret |= write_all(SNAPSHOT, copy, size);
+  if ((error = econf_openSnapshot(&broken, SNAPSHOT)) != ECONF_PARSE_ERROR) {
+    fprintf (stderr, "ERROR: %s: %s\n", label, econf_errString(error));
+    econf_free(broken);
+    ret = 1;
+  }
+  free(copy);
+  return ret;
+}
+
+/* Every slot holds the first entry, a lookup would not end */
+static void
+fill_hash(uint32_t *hash, uint32_t hash_size)
+{
+  for (uint32_t h = 0; h < hash_size; h++)
+    hash[h] = 0;
+}
+
+/* A free slot holds an entry of another slot */
+static void
+duplicate_hash(uint32_t *hash, uint32_t hash_size)
+{
+  uint32_t entry = SNAPSHOT_NULL;
+
+  for (uint32_t h = 0; h < hash_size && entry == SNAPSHOT_NULL; h++)
+    entry = hash[h];
+  for (uint32_t h = 0; h < hash_size; h++) {
+    if (hash[h] == SNAPSHOT_NULL) {
+      hash[h] = entry;
+      break;
+    }
+  }
+}
+
+int
+main(void)
+{
+  econf_file *expected = NULL, *key_file = NULL, *broken = NULL;
+  econf_err error;
+  char *data = NULL, *data2 = NULL, *path = NULL, *value = NULL;
+  size_t size = 0, size2 = 0;
+  int ret = 0;
+
+  if ((error = econf_newKeyFile_with_options(&expected, "ROOT_PREFIX=" ROOT)) ||
+      (error = econf_readConfig(&expected, "foo", "/usr/etc", "bar", "conf", "=", "#"))) {
+    fprintf (stderr, "ERROR: econf_readConfig: %s\n", econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_compileConfig(expected, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: econf_compileConfig: %s\n", econf_errString(error));
+    econf_free(expected);
+    return 1;
+  }
+  if ((error = econf_openSnapshot(&key_file, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: econf_openSnapshot: %s\n", econf_errString(error));
+    econf_free(expected);
+    remove(SNAPSHOT);
+    return 1;
+  }
+  ret |= compare(expected, key_file);
+  ret |= compare_strings("path", SNAPSHOT, path = econf_getPath(key_file));
+  free(path);
+  if (econf_delimiter_tag(key_file) != '=' || econf_comment_tag(key_file) != '#') {
+    fprintf (stderr, "ERROR: wrong delimiter or comment tag\n");
+    ret = 1;
+  }
+
+  /* provenance and all tables survive a second round */
+  if ((error = econf_compileConfig(key_file, SNAPSHOT2))) {
+    fprintf (stderr, "ERROR: econf_compileConfig of a snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  data = read_all(SNAPSHOT, &size);
+  data2 = read_all(SNAPSHOT2, &size2);
+  if (data == NULL || data2 == NULL || size != size2 || memcmp(data, data2, size)) {
+    fprintf (stderr, "ERROR: compiled snapshot differs\n");
+    ret = 1;
+  }
+  free(data2);
+  remove(SNAPSHOT2);
+
+  /* equal strings are stored once, but can be changed independently */
+  if ((error = econf_setStringValue(key_file, "main", "same", "changed")) ||
+      (error = econf_getStringValue(key_file, "main", "also_same", &value))) {
+    fprintf (stderr, "ERROR: changing a value: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    ret |= compare_strings("unchanged value", "value", value);
+  }
+  free(value);
+  econf_free(key_file);
+  key_file = NULL;
+  econf_free(expected);
+
+  /* broken snapshots */
+  if (data && size > 16) {
+    ret |= write_all(SNAPSHOT, data, size - 1);
+    if ((error = econf_openSnapshot(&broken, SNAPSHOT)) != ECONF_PARSE_ERROR) {
+      fprintf (stderr, "ERROR: truncated snapshot: %s\n", econf_errString(error));
+      ret = 1;
+    }
+    data[size - 1] = 'x';
+    ret |= write_all(SNAPSHOT, data, size);
+    if ((error = econf_openSnapshot(&broken, SNAPSHOT)) != ECONF_PARSE_ERROR) {
+      fprintf (stderr, "ERROR: unterminated string table: %s\n", econf_errString(error));
+      ret = 1;
+    }
+    data[size - 1] = '\0';
+    ret |= check_broken_hash(data, size, fill_hash, "hash table without free slot");
+    ret |= check_broken_hash(data, size, duplicate_hash, "entry in two hash slots");
+  }
+  free(data);
+  remove(SNAPSHOT);
+  if ((error = econf_openSnapshot(&broken, ROOT "/usr/etc/foo/bar.conf")) != ECONF_PARSE_ERROR) {
+    fprintf (stderr, "ERROR: config file as snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if ((error = econf_openSnapshot(&broken, SNAPSHOT)) != ECONF_NOFILE) {
+    fprintf (stderr, "ERROR: missing snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if (broken != NULL) {
+    fprintf (stderr, "ERROR: econf_file returned on error\n");
+    ret = 1;
+  }
+
+  return ret;
+}
@@ -0,0 +1,155 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeconf.h"
+#include "libeconf_ext.h"
+
+/* Test case:
+   A snapshot is mapped by econf_openSnapshot. The getters work on the
+   mapping, the entries are copied only if the key file is changed.
+   Replacing the snapshot does not change the mapping of other key files.
+*/
+
+#define SNAPSHOT TESTSDIR "tst-snapshot2.snapshot"
+
+/* Is the snapshot mapped into this process? */
+static int
+is_mapped(void)
+{
+  FILE *maps = fopen("/proc/self/maps", "r");
+  char line[1024];
+  int mapped = 0;
+
+  if (maps == NULL)
+    return -1;
+  while (fgets(line, sizeof(line), maps)) {
+    if (strstr(line, "tst-snapshot2.snapshot"))
+      mapped = 1;
+  }
+  fclose(maps);
+  return mapped;
+}
+
+static econf_err
+compile(const char *value)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+
+  if ((error = econf_newIniFile(&key_file)))
+    return error;
+  if ((error = econf_setIntValue(key_file, NULL, "top", -42)) ||
+      (error = econf_setStringValue(key_file, "main", "name", value)) ||
+      (error = econf_setBoolValue(key_file, "main", "enabled", "YES")) ||
+      (error = econf_setUInt64Value(key_file, "main", "size", 1ULL << 40)) ||
+      (error = econf_setDoubleValue(key_file, "other", "ratio", 0.5)) ||
+      (error = econf_setStringValue(key_file, "other", "name", "other")) ||
+      (error = econf_compileConfig(key_file, SNAPSHOT))) {
+    econf_free(key_file);
+    return error;
+  }
+  econf_free(key_file);
+  return ECONF_SUCCESS;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL, *old_file = NULL;
+  econf_ext_value *ext_value = NULL;
+  econf_err error;
+  char **groups = NULL, **keys = NULL, *string = NULL;
+  size_t length = 0;
+  int32_t top = 0;
+  uint64_t size = 0;
+  double ratio = 0;
+  bool enabled = false;
+  int ret = 0;
+
+  if ((error = compile("foo")) || (error = econf_openSnapshot(&key_file, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: creating snapshot: %s\n", econf_errString(error));
+    remove(SNAPSHOT);
+    return 1;
+  }
+  if (is_mapped() == 0) {
+    fprintf (stderr, "ERROR: snapshot is not mapped\n");
+    ret = 1;
+  }
+
+  if (econf_getIntValue(key_file, NULL, "top", &top) || top != -42 ||
+      econf_getStringValue(key_file, "[main]", "name", &string) || strcmp(string, "foo") ||
+      econf_getBoolValue(key_file, "main", "enabled", &enabled) || !enabled ||
+      econf_getUInt64Value(key_file, "main", "size", &size) || size != 1ULL << 40 ||
+      econf_getDoubleValue(key_file, "other", "ratio", &ratio) || ratio != 0.5) {
+    fprintf (stderr, "ERROR: wrong values in the mapped snapshot\n");
+    ret = 1;
+  }
+  free(string);
+  string = NULL;
+  if (econf_getStringValue(key_file, "main", "ratio", &string) != ECONF_NOKEY ||
+      econf_getStringValue(key_file, "missing", "name", &string) != ECONF_NOKEY ||
+      econf_getIntValueDef(key_file, "main", "missing", &top, 7) != ECONF_NOKEY || top != 7) {
+    fprintf (stderr, "ERROR: missing keys are found\n");
+    ret = 1;
+  }
+  if (econf_getGroups(key_file, &length, &groups) || length != 2 ||
+      strcmp(groups[0], "main") || strcmp(groups[1], "other")) {
+    fprintf (stderr, "ERROR: wrong groups\n");
+    ret = 1;
+  }
+  econf_freeArray(groups);
+  if (econf_getKeys(key_file, "main", &length, &keys) || length != 3 ||
+      strcmp(keys[0], "name") || strcmp(keys[1], "enabled") || strcmp(keys[2], "size")) {
+    fprintf (stderr, "ERROR: wrong keys\n");
+    ret = 1;
+  }
+  econf_freeArray(keys);
+  if (econf_getExtValue(key_file, "other", "name", &ext_value) ||
+      strcmp(ext_value->values[0], "other") || ext_value->comment_before_key) {
+    fprintf (stderr, "ERROR: wrong extended value\n");
+    ret = 1;
+  }
+  econf_freeExtValue(ext_value);
+
+  /* a new snapshot does not change the mapping of key_file */
+  old_file = key_file;
+  key_file = NULL;
+  if ((error = compile("bar")) || (error = econf_openSnapshot(&key_file, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: replacing snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    char *old_value = NULL;
+    if (econf_getStringValue(old_file, "main", "name", &old_value) || strcmp(old_value, "foo") ||
+	econf_getStringValue(key_file, "main", "name", &string) || strcmp(string, "bar")) {
+      fprintf (stderr, "ERROR: replaced snapshot has wrong values\n");
+      ret = 1;
+    }
+    free(old_value);
+    free(string);
+    string = NULL;
+  }
+  econf_free(old_file);
+
+  /* changing the key file copies the entries */
+  if ((error = econf_setStringValue(key_file, "main", "name", "changed")) ||
+      (error = econf_getStringValue(key_file, "main", "name", &string)) ||
+      strcmp(string, "changed") ||
+      (error = econf_getIntValue(key_file, NULL, "top", &top)) || top != -42) {
+    fprintf (stderr, "ERROR: changing the snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  free(string);
+  if (is_mapped() != 0) {
+    fprintf (stderr, "ERROR: snapshot is still mapped\n");
+    ret = 1;
+  }
+  econf_free(key_file);
+  remove(SNAPSHOT);
+
+  return ret;
+}
@@ -0,0 +1,148 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   econf_readConfig records the consulted files and directories.
+   econf_isStale notices changed and removed files as well as files and
+   directories which did not exist before, also for a snapshot.
+*/
+
+#define ROOT TESTSDIR "tst-stale1-data"
+#define ETC_DIR ROOT "/etc/foo/bar.conf.d"
+#define ETC_DROPIN ETC_DIR "/20-etc.conf"
+#define ETC_MAIN ROOT "/etc/foo/bar.conf"
+#define SNAPSHOT TESTSDIR "tst-stale1.snapshot"
+
+/* Read the configuration again, it must not be stale afterwards. The
+   value of main/size must be expected.  */
+static int
+reread(econf_file **key_file, int expected)
+{
+  econf_err error;
+  int size = 0;
+
+  econf_free(*key_file);
+  if ((error = read_config(key_file, "ROOT_PREFIX=" ROOT, NULL))) {
+    fprintf (stderr, "ERROR: econf_readConfig: %s\n", econf_errString(error));
+    return 1;
+  }
+  if ((error = econf_getIntValue(*key_file, "main", "size", &size)) || size != expected) {
+    fprintf (stderr, "ERROR: main/size is %d instead of %d\n", size, expected);
+    return 1;
+  }
+  if (econf_isStale(*key_file)) {
+    fprintf (stderr, "ERROR: stale after reading\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int
+check_stale(econf_file *key_file, const char *what)
+{
+  if (!econf_isStale(key_file)) {
+    fprintf (stderr, "ERROR: not stale after %s\n", what);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL, *snapshot = NULL;
+  econf_err error;
+  int ret = 0;
+
+  remove_tree(ROOT "/etc");
+  remove(SNAPSHOT);
+  if (reread(&key_file, 10)) {
+    remove_tree(ROOT "/etc");
+    remove(SNAPSHOT);
+    return 1;
+  }
+
+  /* the directory /etc did not exist */
+  if (mkdir(ROOT "/etc", 0755) || mkdir(ROOT "/etc/foo", 0755) || mkdir(ETC_DIR, 0755) ||
+      write_file(ETC_DROPIN, "[main]\nsize = 20\n")) {
+    fprintf (stderr, "ERROR: couldn't create %s\n", ETC_DROPIN);
+    econf_free(key_file);
+    remove_tree(ROOT "/etc");
+    remove(SNAPSHOT);
+    return 1;
+  }
+  ret |= check_stale(key_file, "creating a drop-in directory");
+  ret |= reread(&key_file, 20);
+
+  /* the snapshot keeps the recorded files */
+  if ((error = econf_compileConfig(key_file, SNAPSHOT)) ||
+      (error = econf_openSnapshot(&snapshot, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  } else if (econf_isStale(snapshot)) {
+    fprintf (stderr, "ERROR: snapshot is stale\n");
+    ret = 1;
+  }
+
+  ret |= write_file(ETC_DROPIN, "[main]\nsize = 200\n");
+  ret |= check_stale(key_file, "changing a drop-in");
+  ret |= check_stale(snapshot, "changing a drop-in of the snapshot");
+  ret |= reread(&key_file, 200);
+
+  /* a main file with higher priority */
+  ret |= write_file(ETC_MAIN, "[main]\nsize = 2\n");
+  ret |= check_stale(key_file, "creating the main file in /etc");
+  ret |= reread(&key_file, 200);
+
+  remove(ETC_DROPIN);
+  ret |= check_stale(key_file, "removing a drop-in");
+  ret |= reread(&key_file, 10);
+
+  /* the recorded files are also kept by changing and writing a snapshot */
+  if (snapshot && (econf_setIntValue(snapshot, "main", "size", 0) ||
+		   econf_compileConfig(snapshot, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: writing the changed snapshot\n");
+    ret = 1;
+  }
+  ret |= check_stale(snapshot, "materializing the snapshot");
+  econf_free(snapshot);
+  snapshot = NULL;
+  if ((error = econf_openSnapshot(&snapshot, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: econf_openSnapshot: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    ret |= check_stale(snapshot, "writing the changed snapshot");
+  }
+  econf_free(snapshot);
+  snapshot = NULL;
+
+  /* nothing has been recorded */
+  econf_free(key_file);
+  key_file = NULL;
+  if ((error = econf_readFile(&key_file, ROOT "/usr/etc/foo/bar.conf", "=", "#"))) {
+    fprintf (stderr, "ERROR: econf_readFile: %s\n", econf_errString(error));
+    ret = 1;
+  } else if (econf_isStale(key_file)) {
+    fprintf (stderr, "ERROR: econf_readFile result is stale\n");
+    ret = 1;
+  }
+  if (econf_isStale(NULL)) {
+    fprintf (stderr, "ERROR: NULL is stale\n");
+    ret = 1;
+  }
+
+  econf_free(key_file);
+  remove_tree(ROOT "/etc");
+  remove(SNAPSHOT);
+  return ret;
+}
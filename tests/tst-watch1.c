@@ -0,0 +1,176 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "libeconf.h"
+#include "testhelpers.h"
+
+/* Test case:
+   The file descriptor of econf_watch becomes readable if a consulted
+   file is changed or a directory is created in /etc or /run, also if
+   intermediate directories are created one after another.
+*/
+
+#define ROOT TESTSDIR "tst-watch1-data"
+#define USR_DROPIN ROOT "/usr/etc/foo/bar.conf.d/10-usr.conf"
+#define ETC_DIR ROOT "/etc/foo/bar.conf.d"
+#define ETC_DROPIN ETC_DIR "/20-etc.conf"
+#define SNAPSHOT TESTSDIR "tst-watch1.snapshot"
+
+static bool
+readable(int fd)
+{
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  return poll(&pfd, 1, 0) == 1;
+}
+
+/* After what fd has to be readable. Afterwards it is rearmed.  */
+static int
+check_event(econf_file *key_file, int fd, const char *what)
+{
+  econf_err error;
+
+  if (!readable(fd)) {
+    fprintf (stderr, "ERROR: no event after %s\n", what);
+    return 1;
+  }
+  if ((error = econf_watch(key_file, &fd))) {
+    fprintf (stderr, "ERROR: econf_watch after %s: %s\n", what, econf_errString(error));
+    return 1;
+  }
+  if (readable(fd)) {
+    fprintf (stderr, "ERROR: event pending after %s\n", what);
+    return 1;
+  }
+  return 0;
+}
+
+/* Read the configuration again and watch it with fd */
+static int
+reread(econf_file **key_file, int fd)
+{
+  econf_err error;
+
+  econf_free(*key_file);
+  if ((error = read_config(key_file, "ROOT_PREFIX=" ROOT, NULL)) || (error = econf_watch(*key_file, &fd))) {
+    fprintf (stderr, "ERROR: reading again: %s\n", econf_errString(error));
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int fd = -1, ret = 0;
+
+  remove_tree(ROOT "/etc");
+  remove_tree(ROOT "/run");
+  remove(SNAPSHOT);
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT, NULL)) || (error = econf_watch(key_file, &fd))) {
+    fprintf (stderr, "ERROR: watching: %s\n", econf_errString(error));
+    econf_free(key_file);
+    return 1;
+  }
+  if (readable(fd)) {
+    fprintf (stderr, "ERROR: event without change\n");
+    ret = 1;
+  }
+
+  /* same content, but written */
+  ret |= write_file(USR_DROPIN, "[main]\nsize = 10\n");
+  ret |= check_event(key_file, fd, "writing a drop-in");
+  ret |= reread(&key_file, fd);
+
+  /* the parse dirs /run/foo and /etc/foo did not exist, only parents of
+     them are created, which are watched afterwards */
+  if (mkdir(ROOT "/run", 0755)) {
+    fprintf (stderr, "ERROR: couldn't create /run\n");
+    ret = 1;
+  }
+  ret |= check_event(key_file, fd, "creating /run");
+  if (mkdir(ROOT "/etc", 0755)) {
+    fprintf (stderr, "ERROR: couldn't create /etc\n");
+    ret = 1;
+  }
+  ret |= check_event(key_file, fd, "creating /etc");
+  if (econf_isStale(key_file)) {
+    fprintf (stderr, "ERROR: stale after creating /etc\n");
+    ret = 1;
+  }
+  if (mkdir(ROOT "/etc/foo", 0755)) {
+    fprintf (stderr, "ERROR: couldn't create /etc/foo\n");
+    ret = 1;
+  }
+  ret |= check_event(key_file, fd, "creating /etc/foo");
+  if (!econf_isStale(key_file)) {
+    fprintf (stderr, "ERROR: not stale after creating /etc/foo\n");
+    ret = 1;
+  }
+  ret |= reread(&key_file, fd);
+
+  if (mkdir(ETC_DIR, 0755)) {
+    fprintf (stderr, "ERROR: couldn't create %s\n", ETC_DIR);
+    ret = 1;
+  }
+  ret |= check_event(key_file, fd, "creating the drop-in directory");
+  if (!econf_isStale(key_file)) {
+    fprintf (stderr, "ERROR: not stale after creating the drop-in directory\n");
+    ret = 1;
+  }
+  ret |= reread(&key_file, fd);
+  ret |= write_file(ETC_DROPIN, "[main]\nsize = 20\n");
+  ret |= check_event(key_file, fd, "creating a drop-in");
+  close(fd);
+  fd = -1;
+
+  /* a snapshot is watched like the configuration it has been compiled of */
+  econf_free(key_file);
+  if ((error = read_config(&key_file, "ROOT_PREFIX=" ROOT, NULL)) ||
+      (error = econf_compileConfig(key_file, SNAPSHOT))) {
+    fprintf (stderr, "ERROR: compiling: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  econf_free(key_file);
+  key_file = NULL;
+  if ((error = econf_openSnapshot(&key_file, SNAPSHOT)) ||
+      (error = econf_watch(key_file, &fd))) {
+    fprintf (stderr, "ERROR: watching the snapshot: %s\n", econf_errString(error));
+    ret = 1;
+  } else {
+    remove(ETC_DROPIN);
+    ret |= check_event(key_file, fd, "removing a drop-in of the snapshot");
+    close(fd);
+    fd = -1;
+  }
+  econf_free(key_file);
+  key_file = NULL;
+
+  /* nothing has been recorded */
+  if ((error = econf_readFile(&key_file, USR_DROPIN, "=", "#"))) {
+    fprintf (stderr, "ERROR: econf_readFile: %s\n", econf_errString(error));
+    ret = 1;
+  } else if ((error = econf_watch(key_file, &fd)) != ECONF_NOFILE || fd != -1) {
+    fprintf (stderr, "ERROR: econf_watch of econf_readFile: %s\n", econf_errString(error));
+    ret = 1;
+  }
+  if (econf_watch(NULL, &fd) != ECONF_ARGUMENT_IS_NULL_VALUE) {
+    fprintf (stderr, "ERROR: econf_watch accepts NULL\n");
+    ret = 1;
+  }
+
+  econf_free(key_file);
+  remove_tree(ROOT "/etc");
+  remove_tree(ROOT "/run");
+  remove(SNAPSHOT);
+  return ret;
+}
@@ -68,6 +68,9 @@ static void usage(void)
     fprintf(stderr, "syntax   checks the syntax, prints parsing errors and returns 1 if an error\n");
     fprintf(stderr, "         has been found (otherwise 0).\n");
     fprintf(stderr, "         as it has been read.\n");
+    fprintf(stderr, "compile  reads all snippets for <filename>.conf like show and writes\n");
+    fprintf(stderr, "         the result to the binary snapshot <snapshot_file>.\n");
+    fprintf(stderr, "         Usage: %s compile <filename>.<suffix> <snapshot_file>\n", utilname);
     fprintf(stderr, "edit     starts the editor $EDITOR (environment variable) where the\n");
     fprintf(stderr, "         groups, keys and values can be modified and saved afterwards.\n");
     fprintf(stderr, "  -f, --full:      copy the original configuration file to /etc instead of\n");
@@ -311,6 +314,22 @@ static econf_err pr_key_file(struct econf_file *key_file)
 }
 
 
+/**
+ * @brief Reads all snippets for filename.conf (econf_readConfig)
+ *        OR a single file only.
+ */
+static econf_err read_key_file(struct econf_file **key_file, const char *delimiters, const char *comment)
+{
+    if (conf_filename[0] == '/') {
+        /* reading one file only */
+        return econf_readFile(key_file, conf_filename,
+			      delimiters, comment);
+    }
+    *key_file = init_key_file();
+    return econf_readConfig(key_file, NULL, NULL, conf_basename,
+			    conf_suffix, delimiters, comment);
+}
+
 /**
  * @brief This command will read all snippets for filename.conf
  *        (econf_readConfig) OR a single file only. After that it
@@ -319,16 +338,7 @@ static econf_err pr_key_file(struct econf_file *key_file)
  */
 static int econf_read(struct econf_file **key_file, const char *delimiters, const char *comment, const bool show)
 {
-    econf_err econf_error;
-    if (conf_filename[0] == '/') {
-        /* reading one file only */
-        econf_error = econf_readFile(key_file, conf_filename,
-				     delimiters, comment);
-    } else {
-        *key_file = init_key_file();
-        econf_error = econf_readConfig(key_file, NULL, NULL, conf_basename,
-				     conf_suffix, delimiters, comment);
-    }
+    econf_err econf_error = read_key_file(key_file, delimiters, comment);
     if (econf_error) {
 	print_error(econf_error);
         return -1;
@@ -342,6 +352,27 @@ static int econf_read(struct econf_file **key_file, const char *delimiters, cons
     return 0;
 }
 
+/**
+ * @brief This command will read all snippets for filename.conf
+ *        (econf_readConfig) OR a single file only and write the
+ *        result to the snapshot snapshot_file (econf_compileConfig).
+ */
+static int econf_compile(struct econf_file **key_file, const char *delimiters,
+			 const char *comment, const char *snapshot_file)
+{
+    econf_err econf_error = read_key_file(key_file, delimiters, comment);
+    if (econf_error) {
+	print_error(econf_error);
+        return -1;
+    }
+    econf_error = econf_compileConfig(*key_file, snapshot_file);
+    if (econf_error) {
+        fprintf(stderr, "%s: %s\n", snapshot_file, econf_errString(econf_error));
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * @brief This command will read all snippets for filename.conf
  *        (econf_readDirsHistory) in hierarchical order and print all groups,
@@ -872,6 +903,13 @@ int main (int argc, char *argv[])
       ret = econf_revert(is_root, use_homedir);
     } else if (strcmp(argv[optind], "cat") == 0) {
 	ret = econf_cat(delimiters, comment);
+    } else if (strcmp(argv[optind], "compile") == 0) {
+        if (nonopts < 3) {
+            fprintf(stderr, "Missing snapshot file\n\n");
+            usage();
+            exit(EXIT_FAILURE);
+        }
+        ret = econf_compile(&key_file, delimiters, comment, argv[optind + 2]);
     } else {
         fprintf(stderr, "Unknown command!\n\n");
         usage();